@@ -2,40 +2,225 @@
  * $ Copyright 2023 Cypress Semiconductor $
  *******************************************************************************/
 #include "CCM.h"
+#include "ccm_timeout.h"
+#include "ccm_stats.h"
+#include "ccm_rtos.h"
+#include "ccm_hal.h"
 
-#define DATA_BITS_8 (8)
-#define STOP_BITS_1 (1)
 #define BAUD_RATE (115200)
-#define RX_BUF_SIZE (32)
-#define AWS_CONNECT_RESPONSE_DELAY (4000)  /* milliseconds*/
-#define WIFI_CONNECT_RESPONSE_DELAY (4000) /* milliseconds*/
+#define BAUD_TOLERANCE_PERCENT (2u)
+#define BAUD_SWITCH_DELAY (10)    /* milliseconds*/
+#define BAUD_PROBE_DELAY (1000)   /* milliseconds*/
+#define MS_PER_SECOND (1000u)
+#define AWS_CONNECT_RESPONSE_DELAY (CCM_TIMEOUT_AUTO)
+#define WIFI_CONNECT_RESPONSE_DELAY (CCM_TIMEOUT_AUTO)
 #define DELAY (8000)                       /* milliseconds*/
-#define BUF_SIZE (256)
+#define BUF_SIZE (CCM_RESPONSE_SLOT_SIZE)
+#define UART_READ_CHUNK (16u)    /* bytes moved from the UART FIFO at once*/
+#define STREAM_RING_MASK (CCM_STREAM_RING_SIZE - 1)
+#define TX_RING_MASK (CCM_TX_RING_SIZE - 1)
+#define TX_SPACE_DELAY (1000u)    /* milliseconds*/
+#define TX_RESYNC_DELAY (500u)    /* milliseconds*/
+#define STREAM_STATUS_SIZE (8)
+#define EVENT_FIELD_MAX (254u)
 #define NUMBER_OF_CHARACTERS (10)
 #define AT_COMMAND_SIZE (22)
+#define SLEEP_FOREVER (0xFFFFFFFFu)
 
-/*global variable for storing the AT COMMAND response */
-char global_command_response[BUF_SIZE];
+/* State of a response pool slot */
+typedef enum
+{
+    RESPONSE_SLOT_FREE = 0,
+    RESPONSE_SLOT_FILLING, /* owned by uart_event_handler() */
+    RESPONSE_SLOT_READY,   /* complete line waiting in the ready queue */
+    RESPONSE_SLOT_HELD     /* handed out to the application */
+} response_slot_state_t;
+
+typedef struct
+{
+    ccm_response_t handle;
+    char buffer[BUF_SIZE];
+    volatile response_slot_state_t state;
+} response_slot_t;
+
+/* Response pool. The UART interrupt frames the received lines directly into the
+ * slots, the application gets a handle pointing into the slot without any copy */
+static response_slot_t response_pool[CCM_RESPONSE_POOL_SIZE];
+
+/* Slot currently being filled by the interrupt handler, CCM_RESPONSE_NO_SLOT if none */
+static uint8_t rx_fill_slot = CCM_RESPONSE_NO_SLOT;
+
+/* Set when no slot was free at the start of a line, the line is dropped up to its '\n' */
+static bool rx_discarding;
+
+/* Queue of complete lines in arrival order. The head is only written by the interrupt
+ * handler and the tail only by the application, one spare entry tells full from empty */
+#define RX_READY_QUEUE_SIZE (CCM_RESPONSE_POOL_SIZE + 1)
+static uint8_t rx_ready_queue[RX_READY_QUEUE_SIZE];
+static volatile uint8_t rx_ready_head;
+static volatile uint8_t rx_ready_tail;
+
+/* Queue of the complete lines that do not terminate a response, routed in
+ * thread context by at_command_route_lines(). Same ownership as rx_ready_queue */
+static uint8_t rx_line_queue[RX_READY_QUEUE_SIZE];
+static volatile uint8_t rx_line_head;
+static volatile uint8_t rx_line_tail;
+
+/* Consumer of the intermediate lines of the multi-line response being received */
+static ccm_line_handler_t rx_line_handler;
+static void *rx_line_handler_arg;
+
+/* Consumer of the lines received outside of a multi-line response */
+static ccm_line_handler_t unsolicited_handler;
+static void *unsolicited_handler_arg;
+
+/* Returned on timeout so that callers can always dereference the response */
+static ccm_response_t timeout_response = {
+    .data = "",
+    .length = 0,
+    .slot = CCM_RESPONSE_NO_SLOT,
+    .truncated = 0,
+    .event_type = CCM_EVENT_NONE,
+    .event_id = CCM_EVENT_NONE};
+
+/* Most response slots and stream ring bytes in use at the same time */
+static uint8_t rx_pool_high_water;
+static uint32_t rx_stream_high_water;
+
+/* Lines dropped because the response pool was exhausted, lines cut to the
+ * slot size, and UART receive errors */
+static volatile uint32_t rx_overrun_count;
+static volatile uint32_t rx_truncated_count;
+static volatile uint32_t rx_error_count;
+static uint32_t rx_unsolicited_count;
+
+/* Stream ring used instead of the response pool while a streamed response is being
+ * received. Written by uart_event_handler(), drained by at_command_stream_receive() */
+static uint8_t stream_ring[CCM_STREAM_RING_SIZE];
+static volatile uint32_t stream_ring_head;
+static volatile uint32_t stream_ring_tail;
+
+/* Transmit ring of the asynchronous write path. The head is only written by the
+ * application, the tail by the transmit interrupt; both count bytes, wrapping
+ * at 2^32. tx_active is the length of the transfer in progress, 0 when idle. */
+static uint8_t tx_ring[CCM_TX_RING_SIZE];
+static volatile uint32_t tx_ring_head;
+static volatile uint32_t tx_ring_tail;
+static volatile uint32_t tx_active;
+static uint32_t tx_high_water;
+static uint32_t tx_transfers;
+static uint32_t tx_bytes;
+
+static ccm_tx_done_handler_t tx_done_handler;
+static void *tx_done_handler_arg;
 
-/*uart-object */
-cyhal_uart_t uart_obj;
+/* Set when only part of a command reached the CCM module, the next command
+ * first ends that line */
+static volatile bool tx_line_broken;
 
-/*rx-buffer*/
-uint8_t rx_buf[RX_BUF_SIZE];
+/* Number of bytes at_command_stream_receive() waits for before parsing again */
+static uint32_t stream_wait_bytes = 1;
+
+/* Set by the application: route the next response line into stream_ring */
+static volatile bool rx_stream_armed;
+
+/* Owned by the interrupt handler: the line currently received is being streamed */
+static bool rx_stream_in_line;
+
+/* Set by the interrupt handler when the streamed line has been terminated by '\n' */
+static volatile bool rx_stream_line_done;
+
+/* Set by the interrupt handler when stream_ring was full and payload bytes were lost */
+static volatile bool rx_stream_overrun;
+
+/* Timestamps and size of the streamed line, for the AT link statistics */
+static volatile uint32_t rx_stream_start_ticks;
+static volatile uint32_t rx_stream_end_ticks;
+static volatile uint16_t rx_stream_bytes;
+
+/* Cached connection states and the time they were last updated. Written by
+ * the event handlers and the probes, read by the application: a state and its
+ * time are accessed together in a critical section */
+static ccm_link_state_t wifi_state = CCM_LINK_UNKNOWN;
+static ccm_link_state_t aws_state = CCM_LINK_UNKNOWN;
+static uint32_t wifi_state_time;
+static uint32_t aws_state_time;
+
+/* Frequency of the low power timer, the time base and wake-up source while
+ * waiting for responses */
+static uint32_t lptimer_frequency;
 
 /*baud rate*/
 uint32_t actualbaud;
 
-uint8_t print_disable;
+/* Baud rate both sides agreed on, BAUD_RATE until ccm_negotiate_baud_rate() succeeds */
+static uint32_t negotiated_baud = BAUD_RATE;
 
-/* UART configuration*/
-const cyhal_uart_cfg_t uart_config =
-    {
-        .data_bits = DATA_BITS_8,
-        .stop_bits = STOP_BITS_1,
-        .parity = CYHAL_UART_PARITY_NONE,
-        .rx_buffer = rx_buf,
-        .rx_buffer_size = RX_BUF_SIZE};
+/* Baud rates tried by ccm_negotiate_baud_rate(), highest first */
+static const uint32_t baud_rate_candidates[] = CCM_BAUD_RATE_CANDIDATES;
+
+static void uart_event_handler(bool error);
+static void uart_tx_done_handler(void);
+static void tx_start(void);
+static bool tx_write(const char *str, size_t length);
+static bool tx_resync(void);
+#if CCM_TX_ASYNC
+static bool tx_space_available(void);
+#endif
+static bool tx_idle(void);
+static bool wait_for_condition(bool (*condition)(void), uint32_t delay);
+static bool stream_data_available(void);
+static bool response_or_line_available(void);
+static bool is_frame_terminator(const char *line, uint16_t length);
+static void stream_ring_push(uint8_t data);
+static void rx_flush(void);
+static bool parse_ok_fields(const char *line, uint8_t *first, uint8_t *second);
+static bool link_state_fresh(const ccm_link_state_t *state, const uint32_t *update_time);
+static bool set_host_baud(uint32_t baud);
+static bool probe_module(void);
+static uint8_t stream_receive(const char *command, size_t length, ccm_timeout_class_t timeout_class,
+                              ccm_command_id_t stats_command, uint32_t delay,
+                              ccm_stream_callback_t callback, void *callback_arg);
+
+#if CCM_RTOS
+/* Arguments and result of an AT command API call executed by the AT link task */
+typedef struct
+{
+    char *str;
+    ccm_command_id_t id;
+    uint32_t delay;
+    int *result;
+    char *desired_response;
+    ccm_response_t *response;
+    ccm_line_handler_t line_handler;
+    void *line_handler_arg;
+    const char *buffer;
+    size_t length;
+    bool success;
+} rtos_command_call_t;
+
+typedef struct
+{
+    const char *command;
+    size_t length;
+    ccm_timeout_class_t timeout_class;
+    ccm_command_id_t stats_command;
+    uint32_t delay;
+    ccm_stream_callback_t callback;
+    void *callback_arg;
+    uint8_t status;
+} rtos_stream_call_t;
+
+static bool wait_for_condition_rtos(bool (*condition)(void), uint32_t delay);
+static bool sleep_condition_rtos(bool (*condition)(void), uint32_t delay);
+static void send_buffer_call(void *arg);
+static void tx_flush_call(void *arg);
+static void response_receive_call(void *arg);
+static void route_lines_call(void *arg);
+static void send_receive_call(void *arg);
+static void execute_call(void *arg);
+static void stream_receive_call(void *arg);
+#endif /* CCM_RTOS */
 
 /*******************************************************************************
  * Function Name: Bsp_Init
@@ -43,11 +228,11 @@ const cyhal_uart_cfg_t uart_config =
  * Summary:
  * BSP initialization.
  * While porting to any other microcontroller,
- * replace the cybsp_init() with your microcontroller specific BSP init API's.
+ * implement ccm_hal_board_init() for your microcontroller, see ccm_hal.h.
  *******************************************************************************/
 void bsp_init()
 {
-    cybsp_init();
+    ccm_hal_board_init();
 }
 
 /*******************************************************************************
@@ -58,286 +243,2251 @@ void bsp_init()
     - To receive debug messages
     - To send AT commands to CCM module
  * While porting to any other microcontroller,
- * replace UART initialization API's with your microcontroller specific UART API's
+ * implement the ccm_hal_uart, ccm_hal_timer and ccm_hal_debug API's, see ccm_hal.h.
  *******************************************************************************/
 void uart_init()
 {
+    for (uint8_t i = 0; i < CCM_RESPONSE_POOL_SIZE; i++)
+    {
+        response_pool[i].handle.data = response_pool[i].buffer;
+        response_pool[i].handle.slot = i;
+        response_pool[i].state = RESPONSE_SLOT_FREE;
+    }
 
-    /*Initialize UART to communicate with CCM via pins P12_0 and P12_1 */
-    cyhal_uart_init(&uart_obj, P12_1, P12_0, NC, NC, NULL, &uart_config);
-    cyhal_uart_set_baud(&uart_obj, BAUD_RATE, &actualbaud);
+    /*Initialize UART to communicate with CCM. Receive is interrupt driven: every
+     * byte is moved from the FIFO and framed into response pool slots in
+     * uart_event_handler() */
+    ccm_hal_uart_init(BAUD_RATE, uart_event_handler, uart_tx_done_handler);
+    actualbaud = BAUD_RATE;
 
-    /*Initialize Debug UART */
-    cy_retarget_io_init(CYBSP_DEBUG_UART_TX, CYBSP_DEBUG_UART_RX,
-                        CY_RETARGET_IO_BAUDRATE);
+    /* Initialize the low power timer used for response timeouts */
+    lptimer_frequency = ccm_hal_timer_init();
 
-    /* Enable global interrupts */
-    __enable_irq();
+    /*Initialize Debug UART, enables the interrupts */
+    ccm_hal_debug_init();
 
     /* \x1b[2J\x1b[;H - ANSI ESC sequence for clear screen */
     printf("\x1b[2J\x1b[;H");
 }
 
 /*******************************************************************************
- * Function Name: at_command_send
+ * Function Name: rx_flush
  ********************************************************************************
  * Summary:
- * Sending AT Commands to CCM module via UART interface.
+ * Drop every received line and the partially received line, used after the baud
+ * rate changed and the receiver may have framed garbage.
  *
- * while porting to any other microcontroller,
- * replace the cyhal_uart_write() API with your microcontroller specific UART API
+ *******************************************************************************/
+static void rx_flush(void)
+{
+    uint32_t state = ccm_hal_critical_section_enter();
+
+    if (rx_fill_slot != CCM_RESPONSE_NO_SLOT)
+    {
+        response_pool[rx_fill_slot].state = RESPONSE_SLOT_FREE;
+        rx_fill_slot = CCM_RESPONSE_NO_SLOT;
+    }
+    rx_discarding = false;
+
+    while (rx_ready_tail != rx_ready_head)
+    {
+        response_pool[rx_ready_queue[rx_ready_tail]].state = RESPONSE_SLOT_FREE;
+        rx_ready_tail = (rx_ready_tail + 1) % RX_READY_QUEUE_SIZE;
+    }
+
+    while (rx_line_tail != rx_line_head)
+    {
+        response_pool[rx_line_queue[rx_line_tail]].state = RESPONSE_SLOT_FREE;
+        rx_line_tail = (rx_line_tail + 1) % RX_READY_QUEUE_SIZE;
+    }
+
+    ccm_hal_critical_section_exit(state);
+}
+
+/*******************************************************************************
+ * Function Name: set_host_baud
+ ********************************************************************************
+ * Summary:
+ * Set the baud rate of the CCM UART and check that the clock divider reaches it
+ * within BAUD_TOLERANCE_PERCENT.
  *
- * parameter: str
- * Address of AT Command in string format
+ * parameter: uint32_t baud
+ * Requested baud rate
+ *
+ * return: bool
+ *         true if the achieved baud rate (actualbaud) is within tolerance.
  *
  *******************************************************************************/
-void at_command_send(char *str)
+static bool set_host_baud(uint32_t baud)
 {
-    if (!print_disable)
-        printf("\rSending %s \n", str);
+    /* The bytes still in the transmit ring are meant for the current rate */
+    at_command_tx_flush(TX_SPACE_DELAY);
+
+    if (!ccm_hal_uart_set_baud(baud, &actualbaud))
+    {
+        return false;
+    }
 
-    size_t length = strlen(str);
+    uint32_t error = (actualbaud > baud) ? (actualbaud - baud) : (baud - actualbaud);
 
-    /* UART API for sending data to CCM */
-    cyhal_uart_write(&uart_obj, (void *)str, &length);
+    return ((error * 100u) <= (baud * BAUD_TOLERANCE_PERCENT));
 }
 
 /*******************************************************************************
- * Function Name: at_command_response_receive
+ * Function Name: probe_module
  ********************************************************************************
  * Summary:
- * Receive AT Command response from CCM module via UART interface.
+ * Check that the CCM module answers at the current baud rate.
  *
- * While porting to any other microcontroller,
- * replace the cyhal_uart_getc() API with your microcontroller specific UART API
+ * return: bool
+ *         true if the module answered "OK" to "AT".
  *
- * parameter: uint32_t delay
- * The amount of time(ms) the receive UART function should wait if there is no response
- * from CCM module
+ *******************************************************************************/
+static bool probe_module(void)
+{
+    int probe_result = 0;
+
+    rx_flush();
+
+    ccm_response_release(at_command_execute(CCM_CMD_AT, BAUD_PROBE_DELAY, &probe_result));
+
+    return (probe_result == 1);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_negotiate_baud_rate
+ ********************************************************************************
+ * Summary:
+ * Move the host and the CCM module to the highest baud rate of
+ * CCM_BAUD_RATE_CANDIDATES that both sides support. A candidate is skipped if
+ * the host cannot generate it accurately or the module rejects it; if the module
+ * does not answer after switching, both sides go back to BAUD_RATE.
+ *
+ * Call after uart_init() and before any other AT command.
  *
- * return: char *
- *         Pointer to the response stored in a global variable.
+ * return: uint32_t
+ *         The negotiated baud rate, BAUD_RATE if negotiation failed.
  *
  *******************************************************************************/
-char *at_command_response_receive(uint32_t delay)
+uint32_t ccm_negotiate_baud_rate(void)
 {
+    char command[AT_COMMAND_SIZE + 8];
+    int command_result = 0;
 
-    uint8_t read_data = 0;
-
-    uint8_t resp_char_count = 0;
+    if (!CCM_BAUD_NEGOTIATION)
+    {
+        return negotiated_baud;
+    }
 
-    memset(global_command_response, '\0', BUF_SIZE);
+    if (!probe_module())
+    {
+        CCM_LOG(CCM_LOG_WARN, "\rCCM module not responding, keeping %lu baud\n", (unsigned long)negotiated_baud);
+        return negotiated_baud;
+    }
 
-    /*cyhal_uart_getc() : Get a character. This is a blocking call which waits till a character is received*/
-    while (CY_RSLT_SUCCESS == cyhal_uart_getc(&uart_obj, &read_data, delay))
+    for (uint32_t i = 0; i < (sizeof(baud_rate_candidates) / sizeof(baud_rate_candidates[0])); i++)
     {
+        uint32_t baud = baud_rate_candidates[i];
+
+        /* Check the host can generate the rate before asking the module */
+        bool supported = set_host_baud(baud);
+        set_host_baud(BAUD_RATE);
+        if (!supported)
+        {
+            continue;
+        }
 
-        global_command_response[resp_char_count++] = read_data;
+        snprintf(command, sizeof(command), CCM_SET_BAUD_COMMAND, (unsigned long)baud);
+        ccm_response_release(at_command_send_receive(command, BAUD_PROBE_DELAY, &command_result, "OK\r\n"));
+        if (command_result != 1)
+        {
+            continue;
+        }
 
-        if (!print_disable)
-            printf("%c", read_data);
+        delay_ms(BAUD_SWITCH_DELAY);
+        set_host_baud(baud);
+
+        if (probe_module())
+        {
+            negotiated_baud = baud;
+            break;
+        }
 
-        /*The below if statement breaks out of while loop
-         * once you get the response for AT commands */
+        /* The module may have switched without answering, ask it to go back */
+        snprintf(command, sizeof(command), CCM_SET_BAUD_COMMAND, (unsigned long)BAUD_RATE);
+        at_command_send(command);
+        delay_ms(BAUD_SWITCH_DELAY);
+        set_host_baud(BAUD_RATE);
 
-        if (read_data == '\n')
+        if (!probe_module())
         {
-            printf("\r");
             break;
         }
     }
 
-    return global_command_response;
+    if (negotiated_baud == BAUD_RATE)
+    {
+        set_host_baud(BAUD_RATE);
+    }
+
+    rx_flush();
+
+    CCM_LOG(CCM_LOG_INFO, "\rCCM UART running at %lu baud (actual %lu)\n",
+           (unsigned long)negotiated_baud, (unsigned long)actualbaud);
+
+    return negotiated_baud;
 }
 
 /*******************************************************************************
- * Function Name: handle_error
+ * Function Name: ccm_get_baud_rate
  ********************************************************************************
  * Summary:
- * User defined error handling function
+ * Baud rate of the link to the CCM module.
+ *
+ * return: uint32_t
+ *         The negotiated baud rate.
  *
  *******************************************************************************/
-void handle_error(void)
+uint32_t ccm_get_baud_rate(void)
 {
-    /* Disable all interrupts. */
-    __disable_irq();
-
-    CY_ASSERT(0);
+    return negotiated_baud;
 }
 
 /*******************************************************************************
- * Function Name: Is_WiFi_Connected
+ * Function Name: ccm_get_memory_stats
  ********************************************************************************
  * Summary:
- * Check if CCM module is connected to Wi-Fi network
+ * Size and high-water marks of the static receive buffers.
  *
- * While porting to any other microcontroller,
- * replace the cyhal_uart_getc() and cyhal_uart_write() API with your microcontroller specific UART API's
+ * parameter: stats
+ * Filled with the current values
  *
- * return : uint8_t
- *          1 if connected to Wi-Fi network,
- *          0 otherwise.
  *******************************************************************************/
-uint8_t is_wifi_connected()
+void ccm_get_memory_stats(ccm_memory_stats_t *stats)
 {
+    stats->pool_size = CCM_RESPONSE_POOL_SIZE;
+    stats->pool_high_water = rx_pool_high_water;
+    stats->slot_size = CCM_RESPONSE_SLOT_SIZE;
+    stats->stream_ring_size = CCM_STREAM_RING_SIZE;
+    stats->stream_high_water = rx_stream_high_water;
+    stats->rx_overruns = rx_overrun_count;
+    stats->rx_truncated = rx_truncated_count;
+    stats->rx_errors = rx_error_count;
+    stats->rx_unsolicited = rx_unsolicited_count;
+    stats->tx_ring_size = CCM_TX_RING_SIZE;
+    stats->tx_high_water = tx_high_water;
+    stats->tx_transfers = tx_transfers;
+    stats->tx_bytes = tx_bytes;
+}
 
-    char *wifi_status = NULL;
+/*******************************************************************************
+ * Function Name: at_command_send
+ ********************************************************************************
+ * Summary:
+ * Sending AT Commands to CCM module via UART interface.
+ *
+ * while porting to any other microcontroller,
+ * implement ccm_hal_uart_write() for your microcontroller
+ *
+ * parameter: str
+ * Address of AT Command in string format
+ *
+ * return: bool
+ *         false if the command could not be written completely, see
+ *         at_command_send_buffer().
+ *
+ *******************************************************************************/
+bool at_command_send(char *str)
+{
+    CCM_LOG(CCM_LOG_DEBUG, "\rSending %s \n", str);
 
-    print_disable = 1;
+    return at_command_send_buffer(str, strlen(str));
+}
 
-    at_command_send("AT+DIAG PING 8.8.8.8\n");
+/*******************************************************************************
+ * Function Name: at_command_send_buffer
+ ********************************************************************************
+ * Summary:
+ * Sending an AT command of known length to CCM module via UART interface, used
+ * for the command table entries whose length is computed at compile time.
+ *
+ * The command is copied into the transmit ring and the function returns once
+ * it is queued: it is sent by DMA as soon as the transfer in progress ends,
+ * together with every other command queued meanwhile. It waits only if the
+ * ring is full.
+ *
+ * while porting to any other microcontroller,
+ * implement ccm_hal_uart_write_async() for your microcontroller
+ *
+ * parameter: str
+ * Address of AT Command, not necessarily string terminated
+ *
+ * parameter: length
+ * Number of bytes to send
+ *
+ * return: bool
+ *         false if the transmitter stalled and only part of the command was
+ *         written: no response will come, the caller fails the command at
+ *         once. The next command first ends the broken line with a '\n' and
+ *         drops the error line the CCM module answers it with.
+ *
+ *******************************************************************************/
+bool at_command_send_buffer(const char *str, size_t length)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_command_call_t call = {
+            .buffer = str,
+            .length = length};
 
-    wifi_status = at_command_response_receive(WIFI_CONNECT_RESPONSE_DELAY);
+        ccm_rtos_call(send_buffer_call, &call);
+        return call.success;
+    }
+#endif /* CCM_RTOS */
 
-    if (!strcmp(wifi_status, "OK Not connected to AP\r\n"))
+    if (tx_line_broken && !tx_resync())
     {
-        print_disable = 0;
-        return 0;
+        return false;
     }
 
-    /* Compare 10 characters */
-    else if (!strncmp(wifi_status, "OK Received ping", NUMBER_OF_CHARACTERS))
+    if (!tx_write(str, length))
     {
-        print_disable = 0;
-        return 1;
+        tx_line_broken = true;
+        return false;
     }
 
-    return 0;
+    return true;
 }
 
 /*******************************************************************************
- * Function Name: Is_AWS_Connected
+ * Function Name: tx_write
  ********************************************************************************
  * Summary:
- * Check if CCM module is connected to AWS IoT core.
+ * Queue bytes in the transmit ring, or write them the blocking way with
+ * CCM_TX_ASYNC set to 0.
  *
- * While porting to any other microcontroller,
- * replace the cyhal_uart_getc() and cyhal_uart_write() API with your microcontroller specific UART API's
+ * return: bool
+ *         false if the ring stayed full for TX_SPACE_DELAY, the bytes queued
+ *         before are still sent.
  *
- * return : uint8_t
- *          1 if connected to AWS IoT core,
- *          0 otherwise.
  *******************************************************************************/
-uint8_t is_aws_connected()
+static bool tx_write(const char *str, size_t length)
 {
+#if CCM_TX_ASYNC
+    while (length > 0)
+    {
+        if (!wait_for_condition(tx_space_available, TX_SPACE_DELAY))
+        {
+            CCM_LOG(CCM_LOG_ERROR, "\rCCM UART transmit stalled, %u bytes not sent\n", (unsigned)length);
+            return false;
+        }
 
-    char *aws_status = NULL;
+        /* Only this function writes the head, the copy needs no lock */
+        uint32_t head = tx_ring_head;
+        uint32_t used = head - tx_ring_tail;
+        uint32_t chunk = CCM_TX_RING_SIZE - used;
+        uint32_t offset = head & TX_RING_MASK;
+        uint32_t first = CCM_TX_RING_SIZE - offset;
 
-    print_disable = 1;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+        if (first > chunk)
+        {
+            first = chunk;
+        }
 
-    /* UART API for sending data to CCM*/
-    at_command_send("AT+CONNECT?\n");
+        memcpy(&tx_ring[offset], str, first);
+        memcpy(tx_ring, str + first, chunk - first);
 
-    aws_status = at_command_response_receive(AWS_CONNECT_RESPONSE_DELAY);
+        if ((used + chunk) > tx_high_water)
+        {
+            tx_high_water = used + chunk;
+        }
 
-    if (!strcmp(aws_status, "OK 1 1 CONNECTED CUSTOMER\r\n"))
-    {
-        print_disable = 0;
-        return 1;
-    }
+        uint32_t state = ccm_hal_critical_section_enter();
+        tx_ring_head = head + chunk;
+        tx_start();
+        ccm_hal_critical_section_exit(state);
 
-    else if (!strcmp(aws_status, "OK 0 1 DISCONNECTED CUSTOMER\r\n"))
-    {
-        print_disable = 0;
-        return 0;
+        str += chunk;
+        length -= chunk;
     }
 
-    else if (!strcmp(aws_status, "OK 0 0 DISCONNECTED STAGING\r\n"))
-    {
-        print_disable = 0;
-        return 0;
-    }
+    return true;
+#else
+    /* UART API for sending data to CCM */
+    return ccm_hal_uart_write(str, length);
+#endif /* CCM_TX_ASYNC */
+}
 
-    else if (!strcmp(aws_status, "OK 1 0 CONNECTED STAGING\r\n"))
+/*******************************************************************************
+ * Function Name: tx_resync
+ ********************************************************************************
+ * Summary:
+ * End the line of a command that was only sent in part, so that the CCM module
+ * parses the next command from its first byte. Its answer to the broken line
+ * is dropped. Called before the next command, no response is outstanding.
+ *
+ * return: bool
+ *         false if the transmitter is still stalled.
+ *
+ *******************************************************************************/
+static bool tx_resync(void)
+{
+    if (!tx_write("\n", 1) || !at_command_tx_flush(TX_SPACE_DELAY))
     {
-        print_disable = 0;
-        return 0;
+        return false;
     }
 
-    return 0;
+    tx_line_broken = false;
+
+    ccm_response_release(at_command_response_receive(TX_RESYNC_DELAY));
+
+    CCM_LOG(CCM_LOG_WARN, "\rCCM UART transmit resumed\n");
+
+    return true;
 }
+
 /*******************************************************************************
- * Function Name: delay_ms
+ * Function Name: at_command_tx_flush
  ********************************************************************************
  * Summary:
+ * Wait until every byte written with at_command_send_buffer() has been sent.
  *
- * While porting to any other microcontroller,
- * replace the cyhal_uart_getc() and cyhal_uart_write() API with your microcontroller specific UART API's.
+ * parameter: delay
+ * Timeout in milliseconds
  *
- * return : void
+ * return: bool
+ *         false on timeout.
  *
  *******************************************************************************/
-void delay_ms(int delay)
+bool at_command_tx_flush(uint32_t delay)
 {
-    cyhal_system_delay_ms(delay);
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_command_call_t call = {
+            .delay = delay};
+
+        ccm_rtos_call(tx_flush_call, &call);
+        return call.success;
+    }
+#endif /* CCM_RTOS */
+
+    return wait_for_condition(tx_idle, delay);
 }
 
 /*******************************************************************************
- * Function Name: at_command_send_receive
+ * Function Name: at_command_tx_pending
  ********************************************************************************
  * Summary:
- *          Send AT commands to CCM Evaluation kit , receive response
- *          ,compare it with the desired_response if compare is 1 and update
- *          the result variable.
- *
- *
- * input parameter: char *str
- *                     AT command sent in string format.
- *
- * input parameter: int delay
- *                    The amount of time(ms) the receive UART function should wait if there is no response
- *                  from CCM module
- *
- * output parameter: int *result
- *                  if the desired_response is not NULL then desired_response and
- *                  response for the AT command is compared ,the value 1 is assigned to result
- *                  if they are same else value 0 is assigned to result.
- *
- * input parameter: char *desired_response
- *                  the desired response for the AT command sent in string format
- *
- * return :
- *             Address of the AT command response received in string format.
+ * Number of bytes written and not sent yet.
  *
  *******************************************************************************/
-
-char *at_command_send_receive(char *str, int delay, int *result, char *desired_response)
+uint32_t at_command_tx_pending(void)
 {
+    return tx_ring_head - tx_ring_tail;
+}
 
-    char *local_response = NULL;
-
-    at_command_send(str);
+/*******************************************************************************
+ * Function Name: ccm_set_tx_done_handler
+ ********************************************************************************
+ * Summary:
+ * Register the completion notification of the write path, called from
+ * interrupt context every time the transmit ring has been sent entirely.
+ *
+ *******************************************************************************/
+void ccm_set_tx_done_handler(ccm_tx_done_handler_t handler, void *arg)
+{
+    tx_done_handler_arg = arg;
+    tx_done_handler = handler;
+}
 
-    local_response = at_command_response_receive(delay);
+/*******************************************************************************
+ * Function Name: tx_start
+ ********************************************************************************
+ * Summary:
+ * Start the transfer of the bytes waiting in the transmit ring, up to the end
+ * of the ring, unless a transfer is in progress. Called with the interrupts
+ * disabled or from the transmit interrupt.
+ *
+ *******************************************************************************/
+static void tx_start(void)
+{
+    uint32_t pending = tx_ring_head - tx_ring_tail;
+    uint32_t offset = tx_ring_tail & TX_RING_MASK;
 
-    if (!strncmp(local_response, "ERR14 2 UNABLE TO CONNECT\r\n", NUMBER_OF_CHARACTERS))
+    if ((tx_active != 0) || (pending == 0))
     {
-        printf("\n\rCHECK YOUR Wi-Fi CREDENTIALS\n\r");
+        return;
     }
 
-    if (!strncmp(local_response, "ERR14 5 UNABLE TO CONNECT MQTT device authentication failure\r\n", NUMBER_OF_CHARACTERS))
+    if (pending > (CCM_TX_RING_SIZE - offset))
     {
-        printf("\n\rCHECK YOUR ENDPOINT,THINGNAME AND DEVICE CERTIFICATE IN YOUR AWS ACCOUNT \n\r");
+        pending = CCM_TX_RING_SIZE - offset;
     }
 
-    if (desired_response)
+    tx_active = pending;
+    tx_transfers++;
+    tx_bytes += pending;
+
+    if (!ccm_hal_uart_write_async(&tx_ring[offset], pending))
     {
-        if (!strcmp(desired_response, local_response))
+        /* Not expected with a single writer, send it the blocking way, which
+         * returns once every byte is in the TX FIFO */
+        tx_active = 0;
+        if (!ccm_hal_uart_write((const char *)&tx_ring[offset], pending))
         {
-            *result = 1;
+            tx_line_broken = true;
         }
+        tx_ring_tail += pending;
+        tx_start();
+    }
+}
 
-        else
-        {
+/*******************************************************************************
+ * Function Name: uart_tx_done_handler
+ ********************************************************************************
+ * Summary:
+ * Transmit interrupt callback: release the bytes sent and start the transfer
+ * of the bytes written meanwhile, so back-to-back commands go out in one
+ * transfer.
+ *
+ *******************************************************************************/
+static void uart_tx_done_handler(void)
+{
+    tx_ring_tail += tx_active;
+    tx_active = 0;
 
-            *result = 0;
-        }
-    }
+    tx_start();
 
-    else
+    if ((tx_active == 0) && tx_done_handler)
     {
-        *result = 1;
+        tx_done_handler(tx_done_handler_arg);
     }
 
-    return local_response;
+#if CCM_RTOS
+    /* The AT link task may wait for room in the ring */
+    ccm_rtos_io_notify_from_isr();
+#endif /* CCM_RTOS */
+}
+
+#if CCM_TX_ASYNC
+static bool tx_space_available(void)
+{
+    return (tx_ring_head - tx_ring_tail) < CCM_TX_RING_SIZE;
+}
+#endif
+
+static bool tx_idle(void)
+{
+    return (tx_ring_head == tx_ring_tail) && (tx_active == 0);
+}
+
+/*******************************************************************************
+ * Function Name: uart_event_handler
+ ********************************************************************************
+ * Summary:
+ * UART interrupt callback. Drains the receive FIFO and frames the received bytes
+ * ('\n' terminated lines) directly into a free slot of the response pool. Lines
+ * longer than the slot are truncated, keeping their "\r\n" ending, and counted
+ * in rx_truncated_count; if no slot is free the line is dropped and counted in
+ * rx_overrun_count.
+ *
+ * While porting to any other microcontroller, call it from the UART receive
+ * interrupt handling of ccm_hal.c
+ *
+ *******************************************************************************/
+static void uart_event_handler(bool error)
+{
+    uint8_t rx_chunk[UART_READ_CHUNK];
+    size_t count;
+
+    if (error)
+    {
+        rx_error_count++;
+    }
+
+    while ((count = ccm_hal_uart_read(rx_chunk, sizeof(rx_chunk))) > 0)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            uint8_t read_data = rx_chunk[n];
+
+            if (rx_discarding)
+            {
+                rx_discarding = (read_data != '\n');
+                continue;
+            }
+
+            /* A streamed response starts with the first line received after arming */
+            if ((rx_fill_slot == CCM_RESPONSE_NO_SLOT) && !rx_stream_in_line &&
+                rx_stream_armed && !rx_stream_line_done)
+            {
+                rx_stream_in_line = true;
+                rx_stream_start_ticks = ccm_hal_timer_read();
+            }
+
+            if (rx_stream_in_line)
+            {
+                /* Bytes of an aborted stream are dropped up to the end of the line */
+                if (rx_stream_armed)
+                {
+                    stream_ring_push(read_data);
+                    rx_stream_bytes++;
+                }
+
+                if (read_data == '\n')
+                {
+                    rx_stream_in_line = false;
+                    rx_stream_line_done = true;
+                    rx_stream_end_ticks = ccm_hal_timer_read();
+                }
+                continue;
+            }
+
+            if (rx_fill_slot == CCM_RESPONSE_NO_SLOT)
+            {
+                for (uint8_t i = 0; i < CCM_RESPONSE_POOL_SIZE; i++)
+                {
+                    if (response_pool[i].state == RESPONSE_SLOT_FREE)
+                    {
+                        response_pool[i].state = RESPONSE_SLOT_FILLING;
+                        response_pool[i].handle.length = 0;
+                        response_pool[i].handle.truncated = 0;
+                        response_pool[i].handle.event_type = CCM_EVENT_NONE;
+                        response_pool[i].handle.event_id = CCM_EVENT_NONE;
+                        response_pool[i].handle.rx_start_ticks = ccm_hal_timer_read();
+                        rx_fill_slot = i;
+                        break;
+                    }
+                }
+
+                uint8_t in_use = 0;
+                for (uint8_t i = 0; i < CCM_RESPONSE_POOL_SIZE; i++)
+                {
+                    in_use += (response_pool[i].state != RESPONSE_SLOT_FREE) ? 1 : 0;
+                }
+                if (in_use > rx_pool_high_water)
+                {
+                    rx_pool_high_water = in_use;
+                }
+
+                if (rx_fill_slot == CCM_RESPONSE_NO_SLOT)
+                {
+                    rx_overrun_count++;
+                    rx_discarding = (read_data != '\n');
+                    continue;
+                }
+            }
+
+            response_slot_t *slot = &response_pool[rx_fill_slot];
+
+            /* Leave room for the string terminator */
+            if (slot->handle.length < (BUF_SIZE - 1))
+            {
+                slot->buffer[slot->handle.length++] = (char)read_data;
+            }
+            else
+            {
+                if (!slot->handle.truncated)
+                {
+                    rx_truncated_count++;
+                }
+                slot->handle.truncated = 1;
+
+                /* The line still ends like every other one */
+                if (read_data == '\n')
+                {
+                    slot->buffer[BUF_SIZE - 3] = '\r';
+                    slot->buffer[BUF_SIZE - 2] = '\n';
+                }
+            }
+
+            if (read_data == '\n')
+            {
+                slot->buffer[slot->handle.length] = '\0';
+                slot->handle.rx_end_ticks = ccm_hal_timer_read();
+
+                if (is_frame_terminator(slot->buffer, slot->handle.length))
+                {
+                    slot->state = RESPONSE_SLOT_READY;
+                    rx_ready_queue[rx_ready_head] = rx_fill_slot;
+                    rx_ready_head = (rx_ready_head + 1) % RX_READY_QUEUE_SIZE;
+                }
+                else if (slot->handle.length <= 2)
+                {
+                    /* Empty line ("\r\n"), nothing to route */
+                    slot->state = RESPONSE_SLOT_FREE;
+                }
+                else
+                {
+                    slot->state = RESPONSE_SLOT_READY;
+                    rx_line_queue[rx_line_head] = rx_fill_slot;
+                    rx_line_head = (rx_line_head + 1) % RX_READY_QUEUE_SIZE;
+                }
+                rx_fill_slot = CCM_RESPONSE_NO_SLOT;
+            }
+        }
+    }
+
+#if CCM_RTOS
+    /* A complete line or streamed bytes may be waited for by the AT link task */
+    ccm_rtos_io_notify_from_isr();
+#endif /* CCM_RTOS */
+}
+
+/*******************************************************************************
+ * Function Name: parse_ok_fields
+ ********************************************************************************
+ * Summary:
+ * Tokenizer for the two numeric fields of an "OK <first> <second> ..." line:
+ * the "OK <type> <id> <name>" event notifications answering AT+EVENT? and the
+ * "OK <connected> <customer> ..." answer of AT+CONNECT?. Only run on the
+ * response of those commands, never in the receive interrupt, so that a line
+ * of the same format answering another command is not taken for an event.
+ *
+ * parameter: const char *line
+ * Response line
+ *
+ * parameter: uint8_t *first, uint8_t *second
+ * The fields, left unchanged unless both are valid
+ *
+ * return : bool
+ *          true if the line has both fields.
+ *
+ *******************************************************************************/
+static bool parse_ok_fields(const char *line, uint8_t *first, uint8_t *second)
+{
+    uint16_t fields[2];
+
+    if (strncmp(line, "OK ", 3))
+    {
+        return false;
+    }
+    line += 3;
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        uint16_t value = 0;
+        uint8_t digits = 0;
+
+        while ((*line >= '0') && (*line <= '9'))
+        {
+            value = (uint16_t)((value * 10u) + (*line++ - '0'));
+            digits++;
+            if (value > EVENT_FIELD_MAX)
+            {
+                return false;
+            }
+        }
+
+        if (digits == 0)
+        {
+            return false;
+        }
+
+        fields[i] = value;
+
+        /* Another field follows the first one */
+        if (i == 0)
+        {
+            if (*line++ != ' ')
+            {
+                return false;
+            }
+        }
+        else if ((*line != ' ') && (*line != '\r') && (*line != '\n') && (*line != '\0'))
+        {
+            return false;
+        }
+    }
+
+    *first = (uint8_t)fields[0];
+    *second = (uint8_t)fields[1];
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: stream_ring_push
+ ********************************************************************************
+ * Summary:
+ * Append a byte to stream_ring from the UART interrupt. The byte is dropped and
+ * rx_stream_overrun is set if the application does not keep up.
+ *
+ * parameter: uint8_t data
+ * Received byte
+ *
+ *******************************************************************************/
+static void stream_ring_push(uint8_t data)
+{
+    uint32_t head = stream_ring_head;
+
+    if (((head + 1) & STREAM_RING_MASK) == stream_ring_tail)
+    {
+        rx_stream_overrun = true;
+        return;
+    }
+
+    stream_ring[head] = data;
+    stream_ring_head = (head + 1) & STREAM_RING_MASK;
+
+    uint32_t used = (stream_ring_head - stream_ring_tail) & STREAM_RING_MASK;
+    if (used > rx_stream_high_water)
+    {
+        rx_stream_high_water = used;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: stream_data_available
+ ********************************************************************************
+ * Summary:
+ * Wake-up condition of at_command_stream_receive(): stream_wait_bytes payload
+ * bytes buffered or the end of the streamed line.
+ *
+ *******************************************************************************/
+static bool stream_data_available(void)
+{
+    return (((stream_ring_head - stream_ring_tail) & STREAM_RING_MASK) >= stream_wait_bytes) || rx_stream_line_done;
+}
+
+/*******************************************************************************
+ * Function Name: wait_for_condition
+ ********************************************************************************
+ * Summary:
+ * Sleep the CPU until the condition is met or until the timeout expires.
+ * The low power timer is armed as wake-up source so that the CPU does not spin
+ * while the response is in flight.
+ *
+ * parameter: bool (*condition)(void)
+ * Condition checked after every wake-up, updated from interrupt context
+ *
+ * parameter: uint32_t delay
+ * Timeout in milliseconds
+ *
+ * return: bool
+ *         true if the condition is met, false on timeout.
+ *
+ *******************************************************************************/
+static bool wait_for_condition(bool (*condition)(void), uint32_t delay)
+{
+#if CCM_RTOS
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        return wait_for_condition_rtos(condition, delay);
+    }
+#endif /* CCM_RTOS */
+
+    uint32_t start = ccm_hal_timer_read();
+    uint32_t timeout_ticks = (uint32_t)(((uint64_t)delay * lptimer_frequency) / MS_PER_SECOND);
+
+    while (!condition())
+    {
+        uint32_t elapsed = ccm_hal_timer_read() - start;
+
+        if (elapsed >= timeout_ticks)
+        {
+            return false;
+        }
+
+        /* Idle time is used to write the deferred log to the debug UART, the
+         * condition is checked again after every chunk */
+        if (ccm_log_drain(CCM_LOG_DRAIN_CHUNK) > 0)
+        {
+            continue;
+        }
+
+        uint32_t remaining = timeout_ticks - elapsed;
+        ccm_hal_timer_set_wakeup((remaining > CCM_HAL_TIMER_MAX_DELAY) ? CCM_HAL_TIMER_MAX_DELAY : remaining);
+
+        /* WFI wakes up on a pending interrupt even with interrupts masked, checking
+         * again inside the critical section closes the window for a missed wake-up */
+        uint32_t state = ccm_hal_critical_section_enter();
+        if (!condition())
+        {
+            ccm_hal_sleep();
+        }
+        ccm_hal_critical_section_exit(state);
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_deep_sleep_until
+ ********************************************************************************
+ * Summary:
+ * Put the system into deep sleep until an interrupt makes the condition true.
+ * Use it for idle periods in which only a GPIO interrupt (EVENT pin) or another
+ * deep sleep capable wake-up source is expected. If a response is being
+ * received or deep sleep is refused (e.g. the debug UART is still transmitting)
+ * the CPU is put into sleep instead, which keeps the UART running.
+ *
+ * While porting to any other microcontroller,
+ * implement ccm_hal_sleep() and ccm_hal_deep_sleep() for your microcontroller
+ *
+ * In the RTOS build the calling task polls the condition and the idle task
+ * puts the system into (deep) sleep, see sleep_condition_rtos().
+ *
+ * parameter: bool (*condition)(void)
+ * Wake-up condition, updated from interrupt context
+ *
+ *******************************************************************************/
+void ccm_deep_sleep_until(bool (*condition)(void))
+{
+#if CCM_RTOS
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        (void)sleep_condition_rtos(condition, SLEEP_FOREVER);
+        return;
+    }
+#endif /* CCM_RTOS */
+
+    /* Free the slots of the lines received since the last command */
+    at_command_route_lines();
+
+    /* The debug UART does not run in deep sleep */
+    ccm_log_flush();
+
+    while (!condition())
+    {
+        /* WFI wakes up on a pending interrupt even with interrupts masked, checking
+         * again inside the critical section closes the window for a missed wake-up */
+        uint32_t state = ccm_hal_critical_section_enter();
+
+        if (!condition())
+        {
+            bool rx_busy = (rx_fill_slot != CCM_RESPONSE_NO_SLOT) || rx_stream_in_line;
+
+            if (rx_busy || !ccm_hal_deep_sleep())
+            {
+                ccm_hal_sleep();
+            }
+        }
+
+        ccm_hal_critical_section_exit(state);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_deep_sleep_timeout
+ ********************************************************************************
+ * Summary:
+ * ccm_deep_sleep_until() with a timeout, the low power timer wakes the system
+ * up from deep sleep when it expires.
+ *
+ * parameter: bool (*condition)(void)
+ * Wake-up condition, updated from interrupt context
+ *
+ * parameter: uint32_t delay
+ * Timeout in milliseconds
+ *
+ * return: bool
+ *         true if the condition is met, false on timeout.
+ *
+ *******************************************************************************/
+bool ccm_deep_sleep_timeout(bool (*condition)(void), uint32_t delay)
+{
+#if CCM_RTOS
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        return sleep_condition_rtos(condition, delay);
+    }
+#endif /* CCM_RTOS */
+
+    uint32_t start = ccm_hal_timer_read();
+    uint32_t timeout_ticks = (uint32_t)(((uint64_t)delay * lptimer_frequency) / MS_PER_SECOND);
+
+    at_command_route_lines();
+
+    /* The debug UART does not run in deep sleep */
+    ccm_log_flush();
+
+    while (!condition())
+    {
+        uint32_t elapsed = ccm_hal_timer_read() - start;
+
+        if (elapsed >= timeout_ticks)
+        {
+            return false;
+        }
+
+        uint32_t remaining = timeout_ticks - elapsed;
+        ccm_hal_timer_set_wakeup((remaining > CCM_HAL_TIMER_MAX_DELAY) ? CCM_HAL_TIMER_MAX_DELAY : remaining);
+
+        uint32_t state = ccm_hal_critical_section_enter();
+
+        if (!condition())
+        {
+            bool rx_busy = (rx_fill_slot != CCM_RESPONSE_NO_SLOT) || rx_stream_in_line;
+
+            if (rx_busy || !ccm_hal_deep_sleep())
+            {
+                ccm_hal_sleep();
+            }
+        }
+
+        ccm_hal_critical_section_exit(state);
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: at_command_response_available
+ ********************************************************************************
+ * Summary:
+ * Check whether a complete response line has been received from the CCM module.
+ * This call never blocks and can be used to do other work while a response is
+ * in flight.
+ *
+ * return: bool
+ *         true if at_command_response_receive() returns without waiting.
+ *
+ *******************************************************************************/
+bool at_command_response_available(void)
+{
+    return (rx_ready_head != rx_ready_tail);
+}
+
+/*******************************************************************************
+ * Function Name: at_command_route_lines
+ ********************************************************************************
+ * Summary:
+ * Hand the received lines that do not terminate a response to their consumer:
+ * the line handler of at_command_execute_lines() while its command is
+ * outstanding, the unsolicited line handler otherwise. Called by the receive
+ * path before a response is returned, and before sleeping. Thread context only,
+ * the handlers run in the AT link task in the RTOS build.
+ *
+ *******************************************************************************/
+void at_command_route_lines(void)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        ccm_rtos_call(route_lines_call, NULL);
+        return;
+    }
+#endif /* CCM_RTOS */
+
+    while (rx_line_tail != rx_line_head)
+    {
+        response_slot_t *slot = &response_pool[rx_line_queue[rx_line_tail]];
+
+        slot->state = RESPONSE_SLOT_HELD;
+        rx_line_tail = (rx_line_tail + 1) % RX_READY_QUEUE_SIZE;
+
+        if (rx_line_handler)
+        {
+            rx_line_handler(&slot->handle, rx_line_handler_arg);
+        }
+        else
+        {
+            rx_unsolicited_count++;
+
+            if (unsolicited_handler)
+            {
+                unsolicited_handler(&slot->handle, unsolicited_handler_arg);
+            }
+            else
+            {
+                CCM_LOG(CCM_LOG_WARN, "\rUnsolicited line: %s", slot->handle.data);
+            }
+        }
+
+        ccm_response_release(&slot->handle);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_set_unsolicited_handler
+ ********************************************************************************
+ * Summary:
+ * Register the consumer of the lines received outside of a response, which are
+ * logged and dropped by default. The handler runs in thread context.
+ *
+ *******************************************************************************/
+void ccm_set_unsolicited_handler(ccm_line_handler_t handler, void *arg)
+{
+    unsolicited_handler_arg = arg;
+    unsolicited_handler = handler;
+}
+
+/*******************************************************************************
+ * Function Name: is_frame_terminator
+ ********************************************************************************
+ * Summary:
+ * Whether a complete line terminates the response of a command, called by the
+ * interrupt handler at the end of every line.
+ *
+ *******************************************************************************/
+static bool is_frame_terminator(const char *line, uint16_t length)
+{
+#if CCM_FRAME_TERMINATORS
+    return ((length >= 2) && (line[0] == 'O') && (line[1] == 'K')) ||
+           ((length >= 3) && (line[0] == 'E') && (line[1] == 'R') && (line[2] == 'R'));
+#else
+    return true;
+#endif
+}
+
+/* Wake-up condition of the receive path */
+static bool response_or_line_available(void)
+{
+    return (rx_ready_head != rx_ready_tail) || (rx_line_head != rx_line_tail);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_get_time_ms
+ ********************************************************************************
+ * Summary:
+ * Milliseconds elapsed since uart_init(), derived from the low power timer.
+ * The timer counter is extended to 64 bits in software so that the result wraps
+ * around cleanly at 2^32 ms; call it at least once per counter period (~36 h).
+ * The extension is updated in a critical section, the function can be called
+ * from any task and from interrupt context.
+ *
+ * return: uint32_t
+ *         Time in milliseconds.
+ *
+ *******************************************************************************/
+uint32_t ccm_get_time_ms(void)
+{
+    static uint32_t last_ticks;
+    static uint64_t ticks_high;
+
+    uint32_t state = ccm_hal_critical_section_enter();
+    uint32_t ticks = ccm_hal_timer_read();
+
+    /* Read and compare without being preempted, so that the wrap is counted once */
+    if (ticks < last_ticks)
+    {
+        ticks_high += (1ull << 32);
+    }
+    last_ticks = ticks;
+
+    uint64_t extended = ticks_high | ticks;
+    ccm_hal_critical_section_exit(state);
+
+    return (uint32_t)((extended * MS_PER_SECOND) / lptimer_frequency);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_get_ticks
+ ********************************************************************************
+ * Summary:
+ * Raw low power timer counter, the time base of the AT link statistics. Can be
+ * called from interrupt context; differences are valid up to one counter
+ * period (~36 h).
+ *
+ * return: uint32_t
+ *         Timer ticks, convert differences with ccm_ticks_to_us().
+ *
+ *******************************************************************************/
+uint32_t ccm_get_ticks(void)
+{
+    return ccm_hal_timer_read();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_ticks_to_us
+ ********************************************************************************
+ * Summary:
+ * Convert a number of low power timer ticks to microseconds.
+ *
+ *******************************************************************************/
+uint32_t ccm_ticks_to_us(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000000u) / lptimer_frequency);
+}
+
+/*******************************************************************************
+ * Function Name: at_command_response_receive
+ ********************************************************************************
+ * Summary:
+ * Receive AT Command response from CCM module via UART interface.
+ * The bytes are framed by uart_event_handler() in the background, this function
+ * sleeps until a complete line is available and hands out its pool slot.
+ *
+ * parameter: uint32_t delay
+ * The amount of time(ms) the receive UART function should wait if there is no response
+ * from CCM module
+ *
+ * return: ccm_response_t *
+ *         Handle to the response. The response stays valid until it is given back
+ *         with ccm_response_release(). On timeout an empty response is returned.
+ *
+ *******************************************************************************/
+ccm_response_t *at_command_response_receive(uint32_t delay)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_command_call_t call = {
+            .delay = delay};
+
+        ccm_rtos_call(response_receive_call, &call);
+        return call.response;
+    }
+#endif /* CCM_RTOS */
+
+    response_slot_t *slot = NULL;
+    uint32_t start = ccm_get_time_ms();
+
+    /* The lines received before the terminator are routed while waiting, so
+     * that a long multi-line response does not exhaust the response pool */
+    while (1)
+    {
+        uint32_t elapsed = ccm_get_time_ms() - start;
+        bool available = (elapsed < delay) && wait_for_condition(response_or_line_available, delay - elapsed);
+
+        at_command_route_lines();
+
+        if (at_command_response_available())
+        {
+            break;
+        }
+
+        if (!available)
+        {
+            return &timeout_response;
+        }
+    }
+
+    slot = &response_pool[rx_ready_queue[rx_ready_tail]];
+    slot->state = RESPONSE_SLOT_HELD;
+    rx_ready_tail = (rx_ready_tail + 1) % RX_READY_QUEUE_SIZE;
+
+    return &slot->handle;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_response_release
+ ********************************************************************************
+ * Summary:
+ * Give a response slot back to the pool. Releasing NULL or the timeout response
+ * is allowed and has no effect. Can be called from any task, the slot is given
+ * back in a critical section.
+ *
+ * parameter: ccm_response_t *response
+ * Handle returned by at_command_response_receive() or at_command_send_receive()
+ *
+ *******************************************************************************/
+void ccm_response_release(ccm_response_t *response)
+{
+    if ((response == NULL) || (response->slot >= CCM_RESPONSE_POOL_SIZE))
+    {
+        return;
+    }
+
+    uint32_t state = ccm_hal_critical_section_enter();
+    response_pool[response->slot].state = RESPONSE_SLOT_FREE;
+    ccm_hal_critical_section_exit(state);
+}
+
+/*******************************************************************************
+ * Function Name: at_command_stream_receive
+ ********************************************************************************
+ * Summary:
+ * Send an AT command whose response is a single, possibly very long line (for
+ * example AT+GET1) and hand the payload to the callback in chunks while it is
+ * still being received. The payload is never buffered as a whole, memory usage
+ * is bounded by CCM_STREAM_RING_SIZE whatever the message size.
+ *
+ * The status word ("OK", "ERRnn") and the line terminator are not passed to the
+ * callback. The callback is invoked a last time with last set to true and a
+ * zero length chunk, ok tells a complete payload from a broken one.
+ *
+ * While porting to any other microcontroller, no change is required in this
+ * function; the bytes are collected by uart_event_handler().
+ *
+ * input parameter: char *str
+ *                  AT command sent in string format.
+ *
+ * input parameter: int delay
+ *                  The amount of time(ms) to wait for the first byte and between
+ *                  two chunks of the response, CCM_TIMEOUT_AUTO for the timeout
+ *                  of the command class
+ *
+ * input parameter: ccm_stream_callback_t callback
+ *                  Function receiving the payload chunks, called from this context
+ *
+ * input parameter: void *callback_arg
+ *                  Passed to the callback unchanged
+ *
+ * return : uint8_t
+ *          1 if the CCM module answered OK and the payload was received completely,
+ *          0 otherwise.
+ *
+ *******************************************************************************/
+uint8_t at_command_stream_receive(char *str, int delay, ccm_stream_callback_t callback, void *callback_arg)
+{
+    return stream_receive(str, strlen(str), ccm_timeout_classify(str), CCM_STATS_OTHER, (uint32_t)delay, callback, callback_arg);
+}
+
+/*******************************************************************************
+ * Function Name: at_command_execute_stream
+ ********************************************************************************
+ * Summary:
+ * at_command_stream_receive() for a command of the command table.
+ *
+ * input parameter: ccm_command_id_t id
+ *                  Command to send
+ *
+ * input parameter: uint32_t delay
+ *                  See at_command_stream_receive()
+ *
+ * input parameter: ccm_stream_callback_t callback
+ *                  Function receiving the payload chunks, called from this context
+ *
+ * input parameter: void *callback_arg
+ *                  Passed to the callback unchanged
+ *
+ * return : uint8_t
+ *          1 if the CCM module answered OK and the payload was received completely,
+ *          0 otherwise.
+ *
+ *******************************************************************************/
+uint8_t at_command_execute_stream(ccm_command_id_t id, uint32_t delay, ccm_stream_callback_t callback, void *callback_arg)
+{
+    const ccm_command_desc_t *desc = &ccm_commands[id];
+
+    return stream_receive(desc->command, desc->length, desc->timeout_class, id, delay, callback, callback_arg);
+}
+
+/*******************************************************************************
+ * Function Name: stream_receive
+ ********************************************************************************
+ * Summary:
+ * Streamed command execution shared by at_command_stream_receive() and
+ * at_command_execute_stream().
+ *
+ *******************************************************************************/
+static uint8_t stream_receive(const char *command, size_t length, ccm_timeout_class_t timeout_class,
+                              ccm_command_id_t stats_command, uint32_t delay,
+                              ccm_stream_callback_t callback, void *callback_arg)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_stream_call_t call = {
+            .command = command,
+            .length = length,
+            .timeout_class = timeout_class,
+            .stats_command = stats_command,
+            .delay = delay,
+            .callback = callback,
+            .callback_arg = callback_arg};
+
+        ccm_rtos_call(stream_receive_call, &call);
+        return call.status;
+    }
+#endif /* CCM_RTOS */
+
+    char status[STREAM_STATUS_SIZE] = {0};
+    uint8_t status_length = 0;
+    bool in_status = true;
+    bool complete = false;
+    uint32_t start_time = 0;
+    uint32_t timeout = (delay == CCM_TIMEOUT_AUTO) ? ccm_timeout_get_class(timeout_class) : delay;
+
+    /* The answer to a broken line is dropped before the stream is armed */
+    bool sent = !tx_line_broken || tx_resync();
+
+    stream_wait_bytes = 1;
+    stream_ring_tail = stream_ring_head;
+    rx_stream_overrun = false;
+    rx_stream_line_done = false;
+    rx_stream_bytes = 0;
+    rx_stream_armed = true;
+
+    start_time = ccm_get_time_ms();
+    uint32_t send_ticks = ccm_get_ticks();
+
+    CCM_LOG(CCM_COMMAND_LOG_LEVEL(stats_command), "\rSending %.*s \n", (int)length, command);
+
+    if (!sent || !at_command_send_buffer(command, length))
+    {
+        rx_stream_armed = false;
+        callback(NULL, 0, true, false, callback_arg);
+        return 0;
+    }
+
+    while (!complete)
+    {
+        uint32_t head = stream_ring_head;
+        uint32_t tail = stream_ring_tail;
+
+        if (((head - tail) & STREAM_RING_MASK) < stream_wait_bytes)
+        {
+            if (rx_stream_line_done)
+            {
+                /* No more bytes will arrive, the terminator was lost in an overrun */
+                break;
+            }
+
+            if (!wait_for_condition(stream_data_available, timeout))
+            {
+                if (in_status && (status_length == 0))
+                {
+                    ccm_timeout_record_class(timeout_class, 0, true);
+                }
+                break;
+            }
+            continue;
+        }
+
+        stream_wait_bytes = 1;
+
+        if (in_status)
+        {
+            uint8_t data = stream_ring[tail];
+
+            /* The latency of a download is the time to its first byte, the rest
+             * depends on the message size */
+            if (status_length == 0)
+            {
+                ccm_timeout_record_class(timeout_class, ccm_get_time_ms() - start_time, false);
+            }
+
+            if ((data == ' ') || (data == '\r') || (data == '\n'))
+            {
+                in_status = false;
+                if (data == ' ')
+                {
+                    stream_ring_tail = (tail + 1) & STREAM_RING_MASK;
+                }
+            }
+            else
+            {
+                if (status_length < (STREAM_STATUS_SIZE - 1))
+                {
+                    status[status_length++] = (char)data;
+                }
+                stream_ring_tail = (tail + 1) & STREAM_RING_MASK;
+            }
+            continue;
+        }
+
+        /* Deliver the contiguous part of the ring up to the end of the line. A '\r'
+         * is held back until it is known whether it belongs to the terminator. */
+        uint32_t end = (head > tail) ? head : CCM_STREAM_RING_SIZE;
+        uint32_t index = tail;
+
+        while (index < end)
+        {
+            if (stream_ring[index] == '\n')
+            {
+                complete = true;
+                break;
+            }
+
+            if (stream_ring[index] == '\r')
+            {
+                uint32_t next = (index + 1) & STREAM_RING_MASK;
+
+                if (next == head)
+                {
+                    break;
+                }
+
+                if (stream_ring[next] == '\n')
+                {
+                    complete = true;
+                    break;
+                }
+            }
+            index++;
+        }
+
+        if (index > tail)
+        {
+            callback(&stream_ring[tail], (uint16_t)(index - tail), false, false, callback_arg);
+        }
+
+        if (complete)
+        {
+            stream_ring_tail = head;
+        }
+        else if (index == tail)
+        {
+            /* A '\r' is waiting at the tail, wait for the byte following it */
+            stream_wait_bytes = 2;
+        }
+        else
+        {
+            stream_ring_tail = index & STREAM_RING_MASK;
+        }
+    }
+
+    rx_stream_armed = false;
+
+    ccm_stats_sample_t sample = {
+        .send_ticks = send_ticks,
+        .first_byte_ticks = rx_stream_start_ticks,
+        .done_ticks = complete ? rx_stream_end_ticks : ccm_get_ticks(),
+        .bytes_out = (uint16_t)length,
+        .bytes_in = rx_stream_bytes,
+        .timed_out = (in_status && (status_length == 0)),
+        .error = !strncmp(status, "ERR", 3)};
+    ccm_stats_record((uint8_t)stats_command, &sample);
+
+    bool ok = complete && !rx_stream_overrun && !strcmp(status, "OK");
+
+    callback(NULL, 0, true, ok, callback_arg);
+
+    if (!complete)
+        CCM_LOG(CCM_LOG_WARN, "\n\rStreamed response incomplete\n\r");
+
+    return ok ? 1 : 0;
+}
+
+/*******************************************************************************
+ * Function Name: handle_error
+ ********************************************************************************
+ * Summary:
+ * User defined error handling function
+ *
+ *******************************************************************************/
+void handle_error(void)
+{
+    ccm_log_flush();
+
+    /* Disable all interrupts. */
+    __disable_irq();
+
+    CY_ASSERT(0);
+}
+
+/*******************************************************************************
+ * Function Name: link_state_fresh
+ ********************************************************************************
+ * Summary:
+ * Check whether a cached connection state can be used without probing. A
+ * connected state is trusted for CCM_LINK_UP_CACHE_TIME after the last sign
+ * of the connection, so that a loss the CCM module did not report is noticed,
+ * a disconnected state only for CCM_LINK_DOWN_CACHE_TIME so that polling
+ * loops still notice a new connection.
+ *
+ *******************************************************************************/
+static bool link_state_fresh(const ccm_link_state_t *state, const uint32_t *update_time)
+{
+    uint32_t now = ccm_get_time_ms();
+    uint32_t critical = ccm_hal_critical_section_enter();
+    ccm_link_state_t current = *state;
+    uint32_t age = now - *update_time;
+    ccm_hal_critical_section_exit(critical);
+
+    return ((current == CCM_LINK_UP) && (age < CCM_LINK_UP_CACHE_TIME)) ||
+           ((current == CCM_LINK_DOWN) && (age < CCM_LINK_DOWN_CACHE_TIME));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_set_wifi_state
+ ********************************************************************************
+ * Summary:
+ * Update the cached Wi-Fi state. Losing Wi-Fi also means losing AWS.
+ *
+ *******************************************************************************/
+void ccm_link_set_wifi_state(ccm_link_state_t state)
+{
+    uint32_t now = ccm_get_time_ms();
+    uint32_t critical = ccm_hal_critical_section_enter();
+
+    wifi_state = state;
+    wifi_state_time = now;
+
+    if (state != CCM_LINK_UP)
+    {
+        aws_state = state;
+        aws_state_time = now;
+    }
+
+    ccm_hal_critical_section_exit(critical);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_set_aws_state
+ ********************************************************************************
+ * Summary:
+ * Update the cached AWS IoT core state. An AWS connection implies Wi-Fi.
+ *
+ *******************************************************************************/
+void ccm_link_set_aws_state(ccm_link_state_t state)
+{
+    uint32_t now = ccm_get_time_ms();
+    uint32_t critical = ccm_hal_critical_section_enter();
+
+    aws_state = state;
+    aws_state_time = now;
+
+    if (state == CCM_LINK_UP)
+    {
+        wifi_state = CCM_LINK_UP;
+        wifi_state_time = now;
+    }
+
+    ccm_hal_critical_section_exit(critical);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_aws_alive
+ ********************************************************************************
+ * Summary:
+ * Traffic of the AWS IoT core connection was received (MSG event): refresh a
+ * cached connected state. Any other state is kept, a queued message does not
+ * prove that the connection is up now.
+ *
+ *******************************************************************************/
+void ccm_link_aws_alive(void)
+{
+    uint32_t now = ccm_get_time_ms();
+    uint32_t critical = ccm_hal_critical_section_enter();
+
+    if (aws_state == CCM_LINK_UP)
+    {
+        aws_state_time = now;
+        wifi_state_time = now;
+    }
+
+    ccm_hal_critical_section_exit(critical);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_get_wifi_state
+ ********************************************************************************
+ * Summary:
+ * Cached Wi-Fi state, never sends a command.
+ *
+ *******************************************************************************/
+ccm_link_state_t ccm_link_get_wifi_state(void)
+{
+    return wifi_state;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_get_aws_state
+ ********************************************************************************
+ * Summary:
+ * Cached AWS IoT core state, never sends a command.
+ *
+ *******************************************************************************/
+ccm_link_state_t ccm_link_get_aws_state(void)
+{
+    return aws_state;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_get_aws_time
+ ********************************************************************************
+ * Summary:
+ * ccm_get_time_ms() of the last update of the cached AWS IoT core state. While
+ * connected, every received message, CONNECT event and probe refreshes it.
+ *
+ *******************************************************************************/
+uint32_t ccm_link_get_aws_time(void)
+{
+    return aws_state_time;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_invalidate
+ ********************************************************************************
+ * Summary:
+ * Forget the cached states, the next is_wifi_connected() and is_aws_connected()
+ * probe the CCM module.
+ *
+ *******************************************************************************/
+void ccm_link_invalidate(void)
+{
+    uint32_t critical = ccm_hal_critical_section_enter();
+
+    wifi_state = CCM_LINK_UNKNOWN;
+    aws_state = CCM_LINK_UNKNOWN;
+
+    ccm_hal_critical_section_exit(critical);
+}
+
+/*******************************************************************************
+ * Function Name: Is_WiFi_Connected
+ ********************************************************************************
+ * Summary:
+ * Check if CCM module is connected to Wi-Fi network.
+ * The cached state is returned if it is known. Otherwise a connection to AWS
+ * IoT core, answered by the module itself, implies Wi-Fi; the module is only
+ * pinged, which goes over the WAN, when it is not connected to AWS IoT core.
+ *
+ * While porting to any other microcontroller,
+ * implement the ccm_hal.h API's for your microcontroller
+ *
+ * return : uint8_t
+ *          1 if connected to Wi-Fi network,
+ *          0 otherwise.
+ *******************************************************************************/
+uint8_t is_wifi_connected()
+{
+
+    ccm_response_t *wifi_status = NULL;
+
+    int probe_result = 0;
+
+    if (link_state_fresh(&wifi_state, &wifi_state_time))
+    {
+        return (wifi_state == CCM_LINK_UP) ? 1 : 0;
+    }
+
+    if (is_aws_connected() || link_state_fresh(&wifi_state, &wifi_state_time))
+    {
+        return (wifi_state == CCM_LINK_UP) ? 1 : 0;
+    }
+
+    wifi_status = at_command_execute(CCM_CMD_PING, WIFI_CONNECT_RESPONSE_DELAY, &probe_result);
+
+    ccm_link_probe_complete(CCM_CMD_PING, wifi_status, probe_result);
+
+    ccm_response_release(wifi_status);
+
+    return (wifi_state == CCM_LINK_UP) ? 1 : 0;
+}
+
+/*******************************************************************************
+ * Function Name: Is_AWS_Connected
+ ********************************************************************************
+ * Summary:
+ * Check if CCM module is connected to AWS IoT core.
+ * The cached state is returned while it is fresh, AT+CONNECT? is only sent
+ * when the state is unknown or expired (see link_state_fresh()). The answer
+ * "OK <connected> <customer> ..." is decoded by ccm_link_probe_complete().
+ *
+ * While porting to any other microcontroller,
+ * implement the ccm_hal.h API's for your microcontroller
+ *
+ * return : uint8_t
+ *          1 if connected to AWS IoT core (customer endpoint),
+ *          0 otherwise.
+ *******************************************************************************/
+uint8_t is_aws_connected()
+{
+
+    ccm_response_t *aws_status = NULL;
+
+    int probe_result = 0;
+
+    if (link_state_fresh(&aws_state, &aws_state_time))
+    {
+        return (aws_state == CCM_LINK_UP) ? 1 : 0;
+    }
+
+    /* UART API for sending data to CCM*/
+    aws_status = at_command_execute(CCM_CMD_CONNECT_QUERY, AWS_CONNECT_RESPONSE_DELAY, &probe_result);
+
+    ccm_link_probe_complete(CCM_CMD_CONNECT_QUERY, aws_status, probe_result);
+
+    ccm_response_release(aws_status);
+
+    return (aws_state == CCM_LINK_UP) ? 1 : 0;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_link_probe_complete
+ ********************************************************************************
+ * Summary:
+ * Update the cached states from the response of a probe, AT+DIAG PING or
+ * AT+CONNECT?, sent by is_wifi_connected(), is_aws_connected() or queued by
+ * the application to overlap the probes.
+ *
+ * input parameter: ccm_command_id_t id
+ *                  CCM_CMD_PING or CCM_CMD_CONNECT_QUERY
+ *
+ * input parameter: const ccm_response_t *response
+ *                  Response of the probe
+ *
+ * input parameter: int result
+ *                  1 if the response is the expected one
+ *
+ *******************************************************************************/
+void ccm_link_probe_complete(ccm_command_id_t id, const ccm_response_t *response, int result)
+{
+    uint32_t now = ccm_get_time_ms();
+
+    if (id == CCM_CMD_PING)
+    {
+        if (!strcmp(response->data, "OK Not connected to AP\r\n"))
+        {
+            ccm_link_set_wifi_state(CCM_LINK_DOWN);
+        }
+
+        /* "OK Received ping ..." */
+        else if (result)
+        {
+            uint32_t critical = ccm_hal_critical_section_enter();
+            wifi_state = CCM_LINK_UP;
+            wifi_state_time = now;
+            ccm_hal_critical_section_exit(critical);
+        }
+    }
+    else if (id == CCM_CMD_CONNECT_QUERY)
+    {
+        uint8_t connected = CCM_EVENT_NONE;
+        uint8_t customer = CCM_EVENT_NONE;
+
+        parse_ok_fields(response->data, &connected, &customer);
+
+        if (connected == 1)
+        {
+            /* Connected to the staging endpoint still means Wi-Fi is up */
+            uint32_t critical = ccm_hal_critical_section_enter();
+            wifi_state = CCM_LINK_UP;
+            wifi_state_time = now;
+            aws_state = (customer == 1) ? CCM_LINK_UP : CCM_LINK_DOWN;
+            aws_state_time = now;
+            ccm_hal_critical_section_exit(critical);
+        }
+
+        else if (connected == 0)
+        {
+            ccm_link_set_aws_state(CCM_LINK_DOWN);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: delay_ms
+ ********************************************************************************
+ * Summary:
+ *
+ * While porting to any other microcontroller,
+ * implement ccm_hal_delay_ms() for your microcontroller.
+ *
+ * return : void
+ *
+ *******************************************************************************/
+void delay_ms(int delay)
+{
+    ccm_hal_delay_ms(delay);
+}
+
+/*******************************************************************************
+ * Function Name: at_command_send_receive
+ ********************************************************************************
+ * Summary:
+ *          Send AT commands to CCM Evaluation kit , receive response
+ *          ,compare it with the desired_response if compare is 1 and update
+ *          the result variable.
+ *
+ *
+ * input parameter: char *str
+ *                     AT command sent in string format.
+ *
+ * input parameter: int delay
+ *                    The amount of time(ms) the receive UART function should wait if there is no response
+ *                  from CCM module, CCM_TIMEOUT_AUTO for the (adaptive) timeout of the command class
+ *
+ * output parameter: int *result
+ *                  if the desired_response is not NULL then desired_response and
+ *                  response for the AT command is compared ,the value 1 is assigned to result
+ *                  if they are same else value 0 is assigned to result.
+ *
+ * input parameter: char *desired_response
+ *                  the desired response for the AT command sent in string format
+ *
+ * return :
+ *             Handle to the AT command response. Give it back with
+ *             ccm_response_release() once it is no longer needed.
+ *
+ *******************************************************************************/
+
+ccm_response_t *at_command_send_receive(char *str, int delay, int *result, char *desired_response)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_command_call_t call = {
+            .str = str,
+            .delay = (uint32_t)delay,
+            .result = result,
+            .desired_response = desired_response};
+
+        ccm_rtos_call(send_receive_call, &call);
+        return call.response;
+    }
+#endif /* CCM_RTOS */
+
+    ccm_response_t *local_response = NULL;
+
+    uint32_t start_time = ccm_get_time_ms();
+    uint32_t send_ticks = ccm_get_ticks();
+
+    if (!at_command_send(str))
+    {
+        *result = 0;
+        return &timeout_response;
+    }
+
+    local_response = at_command_response_receive(ccm_timeout_resolve(str, (uint32_t)delay));
+
+    CCM_LOG(CCM_LOG_DEBUG, "%s\r", local_response->data);
+
+    ccm_stats_record_response(CCM_STATS_OTHER, (uint16_t)strlen(str), send_ticks, local_response);
+
+    ccm_timeout_record(str, ccm_get_time_ms() - start_time, (local_response->slot == CCM_RESPONSE_NO_SLOT));
+
+    *result = at_command_evaluate_response(local_response, desired_response);
+
+    return local_response;
+}
+
+/*******************************************************************************
+ * Function Name: at_command_execute
+ ********************************************************************************
+ * Summary:
+ *          Send a command of the command table and receive its response. The
+ *          response is compared with the expected prefix of the table entry, no
+ *          string length is computed at run time.
+ *
+ * input parameter: ccm_command_id_t id
+ *                  Command to send
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout in milliseconds, CCM_TIMEOUT_AUTO for the
+ *                  (adaptive) timeout of the command class
+ *
+ * output parameter: int *result
+ *                  1 if the response starts with the expected prefix of the
+ *                  command, 0 otherwise
+ *
+ * return :
+ *             Handle to the AT command response. Give it back with
+ *             ccm_response_release() once it is no longer needed.
+ *
+ *******************************************************************************/
+ccm_response_t *at_command_execute(ccm_command_id_t id, uint32_t delay, int *result)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_command_call_t call = {
+            .id = id,
+            .delay = delay,
+            .result = result};
+
+        ccm_rtos_call(execute_call, &call);
+        return call.response;
+    }
+#endif /* CCM_RTOS */
+
+    const ccm_command_desc_t *desc = &ccm_commands[id];
+    ccm_response_t *local_response = NULL;
+
+    uint32_t start_time = ccm_get_time_ms();
+    uint32_t send_ticks = ccm_get_ticks();
+
+    CCM_LOG(desc->log_level, "\rSending %s \n", desc->command);
+
+    if (!at_command_send_buffer(desc->command, desc->length))
+    {
+        *result = 0;
+        return &timeout_response;
+    }
+
+    local_response = at_command_response_receive((delay == CCM_TIMEOUT_AUTO) ? ccm_timeout_get_class(desc->timeout_class) : delay);
+
+    CCM_LOG(desc->log_level, "%s\r", local_response->data);
+
+    ccm_stats_record_response((uint8_t)id, desc->length, send_ticks, local_response);
+
+    ccm_timeout_record_class(desc->timeout_class, ccm_get_time_ms() - start_time, (local_response->slot == CCM_RESPONSE_NO_SLOT));
+
+    /* Only the answer of AT+EVENT? is an event, the shared timeout response keeps CCM_EVENT_NONE */
+    if ((id == CCM_CMD_EVENT_QUERY) && (local_response->slot != CCM_RESPONSE_NO_SLOT))
+    {
+        parse_ok_fields(local_response->data, &local_response->event_type, &local_response->event_id);
+    }
+
+    *result = at_command_evaluate_expected(local_response, id);
+
+    return local_response;
+}
+
+/*******************************************************************************
+ * Function Name: at_command_execute_lines
+ ********************************************************************************
+ * Summary:
+ *          at_command_execute() for a command answering with several lines:
+ *          the lines before the terminating "OK..." / "ERR..." line are passed
+ *          to line_handler as they arrive, the terminating line is returned.
+ *
+ * input parameter: ccm_line_handler_t line_handler
+ *                  Consumer of the intermediate lines, runs in the context
+ *                  executing the command (the AT link task in the RTOS build)
+ *
+ * input parameter: void *arg
+ *                  Passed to line_handler
+ *
+ *******************************************************************************/
+ccm_response_t *at_command_execute_lines(ccm_command_id_t id, uint32_t delay, int *result,
+                                         ccm_line_handler_t line_handler, void *arg)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_command_call_t call = {
+            .id = id,
+            .delay = delay,
+            .result = result,
+            .line_handler = line_handler,
+            .line_handler_arg = arg};
+
+        ccm_rtos_call(execute_call, &call);
+        return call.response;
+    }
+#endif /* CCM_RTOS */
+
+    ccm_response_t *response = NULL;
+
+    /* Lines received before the command was sent are not part of its response */
+    at_command_route_lines();
+
+    rx_line_handler_arg = arg;
+    rx_line_handler = line_handler;
+
+    response = at_command_execute(id, delay, result);
+
+    rx_line_handler = NULL;
+
+    return response;
+}
+
+/*******************************************************************************
+ * Function Name: at_command_evaluate_expected
+ ********************************************************************************
+ * Summary:
+ *          Compare an AT command response with the expected prefix of a command
+ *          table entry and print a hint for the known connection errors.
+ *
+ * return : int
+ *          1 if the entry accepts any response or the response starts with the
+ *          expected prefix, 0 otherwise.
+ *
+ *******************************************************************************/
+int at_command_evaluate_expected(ccm_response_t *response, ccm_command_id_t id)
+{
+    const ccm_command_desc_t *desc = &ccm_commands[id];
+
+    (void)at_command_evaluate_response(response, NULL);
+
+    if (desc->expected_length == 0)
+    {
+        return 1;
+    }
+
+    return ((response->length >= desc->expected_length) &&
+            !memcmp(response->data, desc->expected, desc->expected_length)) ? 1 : 0;
+}
+
+/*******************************************************************************
+ * Function Name: at_command_evaluate_response
+ ********************************************************************************
+ * Summary:
+ *          Compare an AT command response with the desired_response and print
+ *          a hint for the known connection errors.
+ *
+ * input parameter: ccm_response_t *response
+ *                  Response received from the CCM module
+ *
+ * input parameter: const char *desired_response
+ *                  the desired response for the AT command sent in string format,
+ *                  NULL if any response is accepted
+ *
+ * return : int
+ *          1 if desired_response is NULL or equal to the response, 0 otherwise.
+ *
+ *******************************************************************************/
+int at_command_evaluate_response(ccm_response_t *response, const char *desired_response)
+{
+    if (!strncmp(response->data, "ERR14 2 UNABLE TO CONNECT\r\n", NUMBER_OF_CHARACTERS))
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\n\rCHECK YOUR Wi-Fi CREDENTIALS\n\r");
+    }
+
+    if (!strncmp(response->data, "ERR14 5 UNABLE TO CONNECT MQTT device authentication failure\r\n", NUMBER_OF_CHARACTERS))
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\n\rCHECK YOUR ENDPOINT,THINGNAME AND DEVICE CERTIFICATE IN YOUR AWS ACCOUNT \n\r");
+    }
+
+    if (desired_response)
+    {
+        return (!strcmp(desired_response, response->data)) ? 1 : 0;
+    }
+
+    return 1;
+}
+
+#if CCM_RTOS
+/*******************************************************************************
+ * Function Name: wait_for_condition_rtos
+ ********************************************************************************
+ * Summary:
+ * wait_for_condition() of the RTOS build: the AT link task blocks until the
+ * UART interrupt notifies it, the CPU is left to the other tasks (and to the
+ * tickless idle task for sleeping). A notification given between the check
+ * and the wait is kept pending, no wake-up is missed.
+ *
+ *******************************************************************************/
+static bool wait_for_condition_rtos(bool (*condition)(void), uint32_t delay)
+{
+    uint32_t start = ccm_hal_timer_read();
+    uint32_t timeout_ticks = (uint32_t)(((uint64_t)delay * lptimer_frequency) / MS_PER_SECOND);
+
+    while (!condition())
+    {
+        uint32_t elapsed = ccm_hal_timer_read() - start;
+
+        if (elapsed >= timeout_ticks)
+        {
+            return false;
+        }
+
+        uint32_t remaining = timeout_ticks - elapsed;
+        ccm_rtos_io_wait((uint32_t)((((uint64_t)remaining * MS_PER_SECOND) + lptimer_frequency - 1) / lptimer_frequency));
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: sleep_condition_rtos
+ ********************************************************************************
+ * Summary:
+ * ccm_deep_sleep_until() and ccm_deep_sleep_timeout() of the RTOS build. The
+ * calling task checks the condition every CCM_RTOS_SLEEP_POLL_INTERVAL ms and
+ * is blocked in between, the tickless idle task puts the system into (deep)
+ * sleep meanwhile. The lines received are routed by the AT link task first.
+ *
+ * parameter: uint32_t delay
+ * Timeout in milliseconds, SLEEP_FOREVER to wait for the condition only
+ *
+ *******************************************************************************/
+static bool sleep_condition_rtos(bool (*condition)(void), uint32_t delay)
+{
+    uint32_t start = ccm_get_time_ms();
+
+    at_command_route_lines();
+
+    while (!condition())
+    {
+        uint32_t elapsed = ccm_get_time_ms() - start;
+        uint32_t wait = CCM_RTOS_SLEEP_POLL_INTERVAL;
+
+        if (delay != SLEEP_FOREVER)
+        {
+            if (elapsed >= delay)
+            {
+                return false;
+            }
+
+            if ((delay - elapsed) < wait)
+            {
+                wait = delay - elapsed;
+            }
+        }
+
+        vTaskDelay((pdMS_TO_TICKS(wait) > 0) ? pdMS_TO_TICKS(wait) : 1);
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: send_buffer_call, tx_flush_call, response_receive_call,
+ *                route_lines_call
+ ********************************************************************************
+ * Summary:
+ * Receive and transmit path API calls executed by the AT link task, which owns
+ * the UART, the transmit ring and the response queues.
+ *
+ *******************************************************************************/
+static void send_buffer_call(void *arg)
+{
+    rtos_command_call_t *call = (rtos_command_call_t *)arg;
+
+    call->success = at_command_send_buffer(call->buffer, call->length);
+}
+
+static void tx_flush_call(void *arg)
+{
+    rtos_command_call_t *call = (rtos_command_call_t *)arg;
+
+    call->success = at_command_tx_flush(call->delay);
+}
+
+static void response_receive_call(void *arg)
+{
+    rtos_command_call_t *call = (rtos_command_call_t *)arg;
+
+    call->response = at_command_response_receive(call->delay);
+}
+
+static void route_lines_call(void *arg)
+{
+    at_command_route_lines();
+}
+
+/*******************************************************************************
+ * Function Name: send_receive_call
+ ********************************************************************************
+ * Summary:
+ * at_command_send_receive() executed by the AT link task.
+ *
+ *******************************************************************************/
+static void send_receive_call(void *arg)
+{
+    rtos_command_call_t *call = (rtos_command_call_t *)arg;
+
+    call->response = at_command_send_receive(call->str, (int)call->delay, call->result, call->desired_response);
+}
+
+/*******************************************************************************
+ * Function Name: execute_call
+ ********************************************************************************
+ * Summary:
+ * at_command_execute() and at_command_execute_lines() executed by the AT link
+ * task.
+ *
+ *******************************************************************************/
+static void execute_call(void *arg)
+{
+    rtos_command_call_t *call = (rtos_command_call_t *)arg;
+
+    if (call->line_handler)
+    {
+        call->response = at_command_execute_lines(call->id, call->delay, call->result,
+                                                  call->line_handler, call->line_handler_arg);
+    }
+    else
+    {
+        call->response = at_command_execute(call->id, call->delay, call->result);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: stream_receive_call
+ ********************************************************************************
+ * Summary:
+ * Streamed command executed by the AT link task, the chunk callback runs in
+ * the AT link task.
+ *
+ *******************************************************************************/
+static void stream_receive_call(void *arg)
+{
+    rtos_stream_call_t *call = (rtos_stream_call_t *)arg;
+
+    call->status = stream_receive(call->command, call->length, call->timeout_class, call->stats_command,
+                                  call->delay, call->callback, call->callback_arg);
 }
+#endif /* CCM_RTOS */
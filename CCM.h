@@ -9,6 +9,9 @@
  * $ Copyright 2023 Cypress Semiconductor $
  *******************************************************************************/
 
+#ifndef CCM_H_
+#define CCM_H_
+
 #include "stdio.h"
 #include "stdint.h"
 #include "cy_pdl.h"
@@ -16,6 +19,144 @@
 #include "cybsp.h"
 #include "stdlib.h"
 #include "cy_retarget_io.h"
+#include "ccm_timeout.h"
+#include "ccm_commands.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Most lines the CCM module sends before the host takes one out of the
+ * response pool: the responses of the pipelined commands (CCM_PIPELINE_DEPTH),
+ * the intermediate lines of a multi-line response and unsolicited lines */
+#ifndef CCM_RX_BURST_LINES
+#define CCM_RX_BURST_LINES (8)
+#endif
+
+/* Number of responses that can be alive at the same time: a burst, the line
+ * being framed and a response still held by the application. A line arriving
+ * with every slot in use is dropped and counted in rx_overruns */
+#ifndef CCM_RESPONSE_POOL_SIZE
+#define CCM_RESPONSE_POOL_SIZE (CCM_RX_BURST_LINES + 2)
+#endif
+
+/* Maximum length of a single response line including the string terminator */
+#ifndef CCM_RESPONSE_SLOT_SIZE
+#define CCM_RESPONSE_SLOT_SIZE (256)
+#endif
+
+#define CCM_RESPONSE_NO_SLOT (0xFFu)
+
+/* Value of ccm_response_t event fields for lines not in "OK <type> <id>" format */
+#define CCM_EVENT_NONE (0xFFu)
+
+/* Receive ring used by at_command_stream_receive(), must be a power of two */
+#ifndef CCM_STREAM_RING_SIZE
+#define CCM_STREAM_RING_SIZE (1024)
+#endif
+
+/* Set to 0 to send the AT commands with blocking UART writes */
+#ifndef CCM_TX_ASYNC
+#define CCM_TX_ASYNC (1)
+#endif
+
+/* Transmit ring of the asynchronous write path, must be a power of two. The
+ * commands written while a transfer runs are sent by the next one. */
+#ifndef CCM_TX_RING_SIZE
+#define CCM_TX_RING_SIZE (512)
+#endif
+
+/* Set to 0 to take every received line as the response of the outstanding
+ * command. Otherwise only "OK..." and "ERR..." lines terminate a response; the
+ * other lines are the intermediate lines of a multi-line response if the
+ * command was sent with at_command_execute_lines(), or unsolicited lines. */
+#ifndef CCM_FRAME_TERMINATORS
+#define CCM_FRAME_TERMINATORS (1)
+#endif
+
+/* Set to 1 to move the CCM UART above 115200 baud at startup. Off by default:
+ * enable it only for a CCM firmware that accepts CCM_SET_BAUD_COMMAND and a
+ * board whose UART lines carry CCM_BAUD_RATE_CANDIDATES */
+#ifndef CCM_BAUD_NEGOTIATION
+#define CCM_BAUD_NEGOTIATION (0)
+#endif
+
+/* Baud rates offered to the CCM module at startup, highest first */
+#ifndef CCM_BAUD_RATE_CANDIDATES
+#define CCM_BAUD_RATE_CANDIDATES {921600u, 460800u, 230400u}
+#endif
+
+/* AT command used to change the baud rate of the CCM module, takes the baud rate */
+#ifndef CCM_SET_BAUD_COMMAND
+#define CCM_SET_BAUD_COMMAND "AT+CONF BaudRate=%lu\n"
+#endif
+
+/* Time a disconnected state is trusted before probing again, in milliseconds */
+#ifndef CCM_LINK_DOWN_CACHE_TIME
+#define CCM_LINK_DOWN_CACHE_TIME (5000u)
+#endif
+
+/* Time a connected state is trusted without a sign of the connection (event,
+ * received message, probe) before probing again, in milliseconds */
+#ifndef CCM_LINK_UP_CACHE_TIME
+#define CCM_LINK_UP_CACHE_TIME (60000u)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Cached Wi-Fi / AWS IoT core connection state */
+typedef enum
+{
+    CCM_LINK_UNKNOWN = 0,
+    CCM_LINK_DOWN,
+    CCM_LINK_UP
+} ccm_link_state_t;
+
+/* Handle to a response received from the CCM module. The data points directly
+ * into a response pool slot and stays valid until ccm_response_release(). */
+typedef struct
+{
+    const char *data;  /* '\0' terminated response line */
+    uint16_t length;   /* number of characters in data */
+    uint8_t slot;      /* response pool slot, CCM_RESPONSE_NO_SLOT if not pooled */
+    uint8_t truncated;  /* 1 if the line did not fit into the slot */
+    uint8_t event_type; /* <type> of an "OK <type> <id> ..." AT+EVENT? answer, else CCM_EVENT_NONE */
+    uint8_t event_id;   /* <id> of an "OK <type> <id> ..." AT+EVENT? answer, else CCM_EVENT_NONE */
+    uint32_t rx_start_ticks; /* ccm_get_ticks() at the first byte of the line */
+    uint32_t rx_end_ticks;   /* ccm_get_ticks() at the '\n' of the line */
+} ccm_response_t;
+
+/* Usage of the static receive buffers, for the memory budget */
+typedef struct
+{
+    uint8_t pool_size;          /* CCM_RESPONSE_POOL_SIZE */
+    uint8_t pool_high_water;    /* most slots in use at the same time */
+    uint16_t slot_size;         /* CCM_RESPONSE_SLOT_SIZE */
+    uint32_t stream_ring_size;  /* CCM_STREAM_RING_SIZE */
+    uint32_t stream_high_water; /* most bytes waiting in the stream ring */
+    uint32_t rx_overruns;       /* lines dropped, no free slot */
+    uint32_t rx_truncated;      /* lines longer than a slot, cut short */
+    uint32_t rx_errors;         /* UART receive errors */
+    uint32_t rx_unsolicited;    /* lines received outside of a response */
+    uint32_t tx_ring_size;      /* CCM_TX_RING_SIZE */
+    uint32_t tx_high_water;     /* most bytes waiting in the transmit ring */
+    uint32_t tx_transfers;      /* asynchronous transfers started */
+    uint32_t tx_bytes;          /* bytes sent, tx_bytes / tx_transfers is the coalescing gain */
+} ccm_memory_stats_t;
+
+/* Called from interrupt context once every written byte has been sent */
+typedef void (*ccm_tx_done_handler_t)(void *arg);
+
+/* Receives a line that does not terminate a response. line is released by the
+ * caller when the handler returns. */
+typedef void (*ccm_line_handler_t)(ccm_response_t *line, void *arg);
+
+/* Receives the payload of a streamed response. chunk points into the stream ring
+ * and is only valid during the call. ok is only set with last, when the CCM
+ * module answered OK and every payload byte was passed; otherwise (timeout,
+ * ERR status, stream ring overrun) the chunks passed before are a broken
+ * message. */
+typedef void (*ccm_stream_callback_t)(const uint8_t *chunk, uint16_t length, bool last, bool ok, void *arg);
 
 /*******************************************************************************
  * Function prototypes
@@ -24,16 +165,78 @@ void bsp_init(void);
 
 void uart_init(void);
 
-void at_command_send(char *);
+uint32_t ccm_negotiate_baud_rate(void);
+
+uint32_t ccm_get_baud_rate(void);
+
+void ccm_get_memory_stats(ccm_memory_stats_t *stats);
+
+bool at_command_send(char *);
 
-char *at_command_response_receive(uint32_t delay);
+bool at_command_send_buffer(const char *, size_t);
+
+bool at_command_tx_flush(uint32_t);
+
+uint32_t at_command_tx_pending(void);
+
+void ccm_set_tx_done_handler(ccm_tx_done_handler_t, void *);
+
+ccm_response_t *at_command_response_receive(uint32_t delay);
+
+void ccm_response_release(ccm_response_t *);
+
+uint8_t at_command_stream_receive(char *, int, ccm_stream_callback_t, void *);
+
+uint8_t at_command_execute_stream(ccm_command_id_t, uint32_t, ccm_stream_callback_t, void *);
+
+bool at_command_response_available(void);
+
+void at_command_route_lines(void);
+
+void ccm_set_unsolicited_handler(ccm_line_handler_t handler, void *arg);
+
+void ccm_deep_sleep_until(bool (*condition)(void));
+
+bool ccm_deep_sleep_timeout(bool (*condition)(void), uint32_t delay);
+
+uint32_t ccm_get_time_ms(void);
+
+uint32_t ccm_get_ticks(void);
+
+uint32_t ccm_ticks_to_us(uint32_t ticks);
 
 uint8_t is_wifi_connected(void);
 
 uint8_t is_aws_connected(void);
 
+void ccm_link_set_wifi_state(ccm_link_state_t);
+
+void ccm_link_set_aws_state(ccm_link_state_t);
+
+void ccm_link_aws_alive(void);
+
+ccm_link_state_t ccm_link_get_wifi_state(void);
+
+ccm_link_state_t ccm_link_get_aws_state(void);
+
+uint32_t ccm_link_get_aws_time(void);
+
+void ccm_link_invalidate(void);
+
+void ccm_link_probe_complete(ccm_command_id_t, const ccm_response_t *, int);
+
 void handle_error(void);
 
 void delay_ms(int);
 
-char *at_command_send_receive(char *, int, int *, char*);
+ccm_response_t *at_command_send_receive(char *, int, int *, char*);
+
+int at_command_evaluate_response(ccm_response_t *, const char *);
+
+ccm_response_t *at_command_execute(ccm_command_id_t, uint32_t, int *);
+
+ccm_response_t *at_command_execute_lines(ccm_command_id_t, uint32_t, int *, ccm_line_handler_t, void *);
+
+int at_command_evaluate_expected(ccm_response_t *, ccm_command_id_t);
+
+#endif /* CCM_H_ */
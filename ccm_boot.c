@@ -0,0 +1,141 @@
+/******************************************************************************
+ * File Name: ccm_boot.c
+ *
+ * Description: Boot timeline and fast start helpers. The application marks
+ * the end of every boot phase; ccm_boot_dump() prints when each phase ended
+ * and how long it took, in milliseconds of the CCM link time base (started
+ * by uart_init(), marks before it read 0).
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_boot.h"
+#include "ccm_command_queue.h"
+#include "ccm_log.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    const char *phase;
+    uint32_t time; /* ms */
+} boot_mark_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+#if CCM_BOOT_TRACE
+static boot_mark_t boot_marks[CCM_BOOT_MARKS];
+static uint8_t boot_mark_count = 0;
+#endif
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void probe_handler(ccm_response_t *response, int result, void *arg);
+
+/*******************************************************************************
+ * Function Name: ccm_boot_mark
+ *******************************************************************************
+ * Summary:
+ *  Record the end of a boot phase.
+ *
+ * input parameter: const char *phase
+ *                  Name of the phase, must stay valid
+ *
+ *******************************************************************************/
+void ccm_boot_mark(const char *phase)
+{
+#if CCM_BOOT_TRACE
+    if (boot_mark_count < CCM_BOOT_MARKS)
+    {
+        boot_marks[boot_mark_count].phase = phase;
+        boot_marks[boot_mark_count].time = ccm_get_time_ms();
+        boot_mark_count++;
+    }
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_boot_time
+ *******************************************************************************
+ * Summary:
+ *  Time at which a phase ended.
+ *
+ * Return:
+ *  uint32_t - ms, 0 if the phase was not marked.
+ *
+ *******************************************************************************/
+uint32_t ccm_boot_time(const char *phase)
+{
+#if CCM_BOOT_TRACE
+    for (uint8_t i = 0; i < boot_mark_count; i++)
+    {
+        if (!strcmp(boot_marks[i].phase, phase))
+        {
+            return boot_marks[i].time;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_boot_dump
+ *******************************************************************************
+ * Summary:
+ *  Log the boot timeline, one line per phase: end time and duration.
+ *
+ *******************************************************************************/
+void ccm_boot_dump(void)
+{
+#if CCM_BOOT_TRACE
+    uint32_t previous = 0;
+
+    CCM_LOG(CCM_LOG_INFO, "\n\rBoot timeline (ms)\n\r");
+
+    for (uint8_t i = 0; i < boot_mark_count; i++)
+    {
+        CCM_LOG(CCM_LOG_INFO, "%8lu %+8ld  %s\n\r", (unsigned long)boot_marks[i].time,
+                (long)(boot_marks[i].time - previous), boot_marks[i].phase);
+        previous = boot_marks[i].time;
+    }
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_boot_probe_links
+ *******************************************************************************
+ * Summary:
+ *  Probe the Wi-Fi and the AWS IoT core connections with AT+CONNECT? and
+ *  AT+DIAG PING pipelined instead of one after the other. The results go to
+ *  the connection state cache, the next is_wifi_connected() and
+ *  is_aws_connected() do not send a command.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of each probe in milliseconds
+ *
+ *******************************************************************************/
+void ccm_boot_probe_links(uint32_t delay)
+{
+    ccm_link_invalidate();
+
+    ccm_command_queue_submit_id(CCM_CMD_CONNECT_QUERY, delay, CCM_COMMAND_FLAG_NONE,
+                                probe_handler, (void *)(uintptr_t)CCM_CMD_CONNECT_QUERY);
+    ccm_command_queue_submit_id(CCM_CMD_PING, delay, CCM_COMMAND_FLAG_NONE,
+                                probe_handler, (void *)(uintptr_t)CCM_CMD_PING);
+
+    ccm_command_queue_flush();
+}
+
+static void probe_handler(ccm_response_t *response, int result, void *arg)
+{
+    ccm_link_probe_complete((ccm_command_id_t)(uintptr_t)arg, response, result);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,41 @@
+/******************************************************************************
+ * File Name: ccm_boot.h
+ *
+ * Description: This file is the public interface of ccm_boot.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_BOOT_H_
+#define CCM_BOOT_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set to 0 to compile the boot timeline out */
+#ifndef CCM_BOOT_TRACE
+#define CCM_BOOT_TRACE (1)
+#endif
+
+/* Phases kept in the boot timeline, later marks are dropped */
+#ifndef CCM_BOOT_MARKS
+#define CCM_BOOT_MARKS (16u)
+#endif
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_boot_mark(const char *phase);
+
+uint32_t ccm_boot_time(const char *phase);
+
+void ccm_boot_dump(void);
+
+void ccm_boot_probe_links(uint32_t delay);
+
+#endif /* CCM_BOOT_H_ */
@@ -0,0 +1,517 @@
+/******************************************************************************
+ * File Name: ccm_command_queue.c
+ *
+ * Description: Pipelined AT command queue. Independent commands are written to
+ * the CCM module back to back, up to CCM_PIPELINE_DEPTH at a time, and their
+ * responses are matched to the requests in arrival order. This requires a CCM
+ * module that queues the commands and answers them in the order it received
+ * them, see ccm_command_queue.h; the default depth of 1 sends one command at a
+ * time.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_command_queue.h"
+#include "ccm_stats.h"
+#include "ccm_rtos.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* The responses of a full pipeline must fit into the response pool at once */
+#if (CCM_PIPELINE_DEPTH > CCM_RX_BURST_LINES)
+#error "CCM_PIPELINE_DEPTH exceeds CCM_RX_BURST_LINES, raise the response pool size"
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    char buffer[CCM_COMMAND_MAX_LENGTH]; /* copy of a string command */
+    const char *command;
+    uint8_t length;
+    ccm_timeout_class_t timeout_class;
+    ccm_command_id_t id;      /* CCM_CMD_COUNT for a string command */
+    const char *desired_response;
+    uint32_t delay;
+    uint32_t start_time; /* start of the response timeout, in milliseconds */
+    uint32_t send_ticks; /* ccm_get_ticks() when the command was sent */
+    uint8_t flags;
+    bool send_failed;    /* only part of the command was written, no response comes */
+    ccm_command_callback_t callback;
+    void *callback_arg;
+} command_entry_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static command_entry_t command_queue[CCM_COMMAND_QUEUE_SIZE];
+
+/* Oldest entry, number of queued entries and number of entries already sent */
+static uint8_t queue_head;
+static uint8_t queue_count;
+static uint8_t queue_in_flight;
+
+/* Most entries queued at the same time */
+static uint8_t queue_high_water;
+
+/* Commands that did not get the desired response since the last flush */
+static uint8_t queue_failures;
+
+/* Response passed to the callback of a command that could not be sent */
+static ccm_response_t not_sent_response = {
+    .data = "",
+    .length = 0,
+    .slot = CCM_RESPONSE_NO_SLOT,
+    .truncated = 0,
+    .event_type = CCM_EVENT_NONE,
+    .event_id = CCM_EVENT_NONE};
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void send_ready_commands(void);
+static void complete_head(ccm_response_t *response, bool timed_out);
+static command_entry_t *queue_tail_entry(uint8_t flags, ccm_command_callback_t callback, void *callback_arg);
+
+#if CCM_RTOS
+/* Arguments and result of a queue API call executed by the AT link task */
+typedef struct
+{
+    const char *command;
+    ccm_command_id_t id;
+    uint32_t delay;
+    const char *desired_response;
+    uint8_t flags;
+    ccm_command_callback_t callback;
+    void *callback_arg;
+    bool success;
+} rtos_queue_call_t;
+
+static void submit_call(void *arg);
+static void submit_id_call(void *arg);
+static void process_call(void *arg);
+static void flush_call(void *arg);
+#endif /* CCM_RTOS */
+
+/*******************************************************************************
+ * Function Name: ccm_command_queue_submit
+ *******************************************************************************
+ * Summary:
+ *  Queue an AT command. The command is copied, it is sent by the next call of
+ *  ccm_command_queue_process() or ccm_command_queue_flush() once the pipeline
+ *  has room for it.
+ *
+ * input parameter: const char *command
+ *                  AT command in string format
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout in milliseconds, counted from the moment the
+ *                  command is the oldest outstanding one. CCM_TIMEOUT_AUTO for
+ *                  the timeout of the command class.
+ *
+ * input parameter: const char *desired_response
+ *                  Desired response, NULL if any response is accepted. Must stay
+ *                  valid until the command completes.
+ *
+ * input parameter: uint8_t flags
+ *                  CCM_COMMAND_FLAG_xxx
+ *
+ * input parameter: ccm_command_callback_t callback
+ *                  Called when the response is received or on timeout, may be NULL
+ *
+ * input parameter: void *callback_arg
+ *                  Passed to the callback unchanged
+ *
+ * Return:
+ *  bool - false if the queue is full or the command too long.
+ *
+ *******************************************************************************/
+bool ccm_command_queue_submit(const char *command, uint32_t delay, const char *desired_response,
+                              uint8_t flags, ccm_command_callback_t callback, void *callback_arg)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_queue_call_t call = {
+            .command = command,
+            .delay = delay,
+            .desired_response = desired_response,
+            .flags = flags,
+            .callback = callback,
+            .callback_arg = callback_arg};
+
+        ccm_rtos_call(submit_call, &call);
+        return call.success;
+    }
+#endif /* CCM_RTOS */
+
+    size_t length = strlen(command);
+
+    if ((queue_count >= CCM_COMMAND_QUEUE_SIZE) || (length >= CCM_COMMAND_MAX_LENGTH))
+    {
+        return false;
+    }
+
+    command_entry_t *entry = queue_tail_entry(flags, callback, callback_arg);
+
+    memcpy(entry->buffer, command, length + 1);
+    entry->command = entry->buffer;
+    entry->length = (uint8_t)length;
+    entry->timeout_class = ccm_timeout_classify(command);
+    entry->id = CCM_CMD_COUNT;
+    entry->desired_response = desired_response;
+    entry->delay = ccm_timeout_resolve(command, delay);
+
+    queue_count++;
+    if (queue_count > queue_high_water)
+    {
+        queue_high_water = queue_count;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_command_queue_submit_id
+ *******************************************************************************
+ * Summary:
+ *  Queue a command of the command table. Nothing is copied, the entry refers to
+ *  the table; the response is compared with the expected prefix of the entry.
+ *
+ * input parameter: ccm_command_id_t id
+ *                  Command to send
+ *
+ * input parameter: uint32_t delay
+ *                  See ccm_command_queue_submit()
+ *
+ * input parameter: uint8_t flags
+ *                  CCM_COMMAND_FLAG_xxx
+ *
+ * input parameter: ccm_command_callback_t callback
+ *                  Called when the response is received or on timeout, may be NULL
+ *
+ * input parameter: void *callback_arg
+ *                  Passed to the callback unchanged
+ *
+ * Return:
+ *  bool - false if the queue is full.
+ *
+ *******************************************************************************/
+bool ccm_command_queue_submit_id(ccm_command_id_t id, uint32_t delay, uint8_t flags,
+                                 ccm_command_callback_t callback, void *callback_arg)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_queue_call_t call = {
+            .id = id,
+            .delay = delay,
+            .flags = flags,
+            .callback = callback,
+            .callback_arg = callback_arg};
+
+        ccm_rtos_call(submit_id_call, &call);
+        return call.success;
+    }
+#endif /* CCM_RTOS */
+
+    if (queue_count >= CCM_COMMAND_QUEUE_SIZE)
+    {
+        return false;
+    }
+
+    const ccm_command_desc_t *desc = &ccm_commands[id];
+    command_entry_t *entry = queue_tail_entry(flags, callback, callback_arg);
+
+    entry->command = desc->command;
+    entry->length = desc->length;
+    entry->timeout_class = desc->timeout_class;
+    entry->id = id;
+    entry->desired_response = NULL;
+    entry->delay = (delay == CCM_TIMEOUT_AUTO) ? ccm_timeout_get_class(desc->timeout_class) : delay;
+
+    queue_count++;
+    if (queue_count > queue_high_water)
+    {
+        queue_high_water = queue_count;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: queue_tail_entry
+ *******************************************************************************
+ * Summary:
+ *  First free entry of the queue with the fields common to all the commands set.
+ *
+ *******************************************************************************/
+static command_entry_t *queue_tail_entry(uint8_t flags, ccm_command_callback_t callback, void *callback_arg)
+{
+    command_entry_t *entry = &command_queue[(queue_head + queue_count) % CCM_COMMAND_QUEUE_SIZE];
+
+    entry->flags = flags;
+    entry->callback = callback;
+    entry->callback_arg = callback_arg;
+
+    return entry;
+}
+
+/*******************************************************************************
+ * Function Name: send_ready_commands
+ *******************************************************************************
+ * Summary:
+ *  Send queued commands while the pipeline has room. A barrier command waits
+ *  for an empty pipeline and blocks the pipeline until it completes. A command
+ *  that could not be sent is the last one sent until it completed, so that
+ *  the send path resynchronizes the CCM module with no response outstanding.
+ *
+ *******************************************************************************/
+static void send_ready_commands(void)
+{
+    while ((queue_in_flight < queue_count) && (queue_in_flight < CCM_PIPELINE_DEPTH))
+    {
+        command_entry_t *entry = &command_queue[(queue_head + queue_in_flight) % CCM_COMMAND_QUEUE_SIZE];
+
+        if (queue_in_flight > 0)
+        {
+            command_entry_t *last = &command_queue[(queue_head + queue_in_flight - 1) % CCM_COMMAND_QUEUE_SIZE];
+
+            if ((entry->flags & CCM_COMMAND_FLAG_BARRIER) || (last->flags & CCM_COMMAND_FLAG_BARRIER) ||
+                last->send_failed)
+            {
+                break;
+            }
+        }
+
+        CCM_LOG(CCM_COMMAND_LOG_LEVEL(entry->id), "\rSending %.*s \n", (int)entry->length, entry->command);
+
+        entry->send_ticks = ccm_get_ticks();
+        entry->send_failed = !at_command_send_buffer(entry->command, entry->length);
+
+        if (queue_in_flight == 0)
+        {
+            entry->start_time = ccm_get_time_ms();
+        }
+
+        queue_in_flight++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: complete_head
+ *******************************************************************************
+ * Summary:
+ *  Complete the oldest outstanding command with the given response and start
+ *  the response timeout of the next one. A command that could not be sent
+ *  fails without a response and is not counted in the timeouts.
+ *
+ *******************************************************************************/
+static void complete_head(ccm_response_t *response, bool timed_out)
+{
+    command_entry_t *entry = &command_queue[queue_head];
+    ccm_command_callback_t callback = entry->callback;
+    void *callback_arg = entry->callback_arg;
+
+    int result = 0;
+
+    if (entry->send_failed)
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\rNot sent %.*s \n", (int)entry->length, entry->command);
+    }
+    else
+    {
+        CCM_LOG(CCM_COMMAND_LOG_LEVEL(entry->id), "%s\r", response->data);
+
+        if (!timed_out)
+        {
+            result = (entry->id < CCM_CMD_COUNT) ? at_command_evaluate_expected(response, entry->id)
+                                                 : at_command_evaluate_response(response, entry->desired_response);
+        }
+
+        ccm_timeout_record_class(entry->timeout_class, ccm_get_time_ms() - entry->start_time, timed_out);
+        ccm_stats_record_response((uint8_t)entry->id, entry->length, entry->send_ticks, response);
+    }
+
+    if (!result)
+    {
+        queue_failures++;
+    }
+
+    queue_head = (queue_head + 1) % CCM_COMMAND_QUEUE_SIZE;
+    queue_count--;
+    queue_in_flight--;
+
+    if (queue_in_flight > 0)
+    {
+        command_queue[queue_head].start_time = ccm_get_time_ms();
+    }
+
+    /* The entry may be reused by a command submitted from the callback */
+    if (callback)
+    {
+        callback(response, result, callback_arg);
+    }
+
+    ccm_response_release(response);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_command_queue_process
+ *******************************************************************************
+ * Summary:
+ *  Non-blocking queue service: complete the commands whose response has been
+ *  received or whose timeout expired, and send the next ones.
+ *
+ *******************************************************************************/
+void ccm_command_queue_process(void)
+{
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        ccm_rtos_call(process_call, NULL);
+        return;
+    }
+#endif /* CCM_RTOS */
+
+    at_command_route_lines();
+
+    while (queue_in_flight > 0)
+    {
+        if (command_queue[queue_head].send_failed)
+        {
+            complete_head(&not_sent_response, false);
+        }
+        else if (at_command_response_available())
+        {
+            complete_head(at_command_response_receive(0), false);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if ((queue_in_flight > 0) &&
+        ((ccm_get_time_ms() - command_queue[queue_head].start_time) >= command_queue[queue_head].delay))
+    {
+        complete_head(at_command_response_receive(0), true);
+    }
+
+    send_ready_commands();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_command_queue_flush
+ *******************************************************************************
+ * Summary:
+ *  Send every queued command and wait for all the responses. The CPU sleeps
+ *  while the responses are in flight.
+ *
+ * Return:
+ *  bool - true if every command completed since the previous flush got its
+ *         desired response.
+ *
+ *******************************************************************************/
+bool ccm_command_queue_flush(void)
+{
+    bool success = false;
+
+#if CCM_RTOS
+    if (!ccm_rtos_direct())
+    {
+        rtos_queue_call_t call = {0};
+
+        ccm_rtos_call(flush_call, &call);
+        return call.success;
+    }
+#endif /* CCM_RTOS */
+
+    send_ready_commands();
+
+    while (queue_in_flight > 0)
+    {
+        command_entry_t *entry = &command_queue[queue_head];
+        uint32_t elapsed = ccm_get_time_ms() - entry->start_time;
+        uint32_t remaining = (elapsed < entry->delay) ? (entry->delay - elapsed) : 0;
+
+        ccm_response_t *response = entry->send_failed ? &not_sent_response : at_command_response_receive(remaining);
+
+        complete_head(response, (response->slot == CCM_RESPONSE_NO_SLOT));
+
+        send_ready_commands();
+    }
+
+    success = (queue_failures == 0);
+    queue_failures = 0;
+
+    return success;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_command_queue_pending
+ *******************************************************************************
+ * Summary:
+ *  Number of commands queued or waiting for their response. Synchronous
+ *  at_command_send_receive() calls must only be made when this is 0.
+ *
+ *******************************************************************************/
+uint8_t ccm_command_queue_pending(void)
+{
+    return queue_count;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_command_queue_high_water
+ *******************************************************************************
+ * Summary:
+ *  Most commands queued at the same time, out of CCM_COMMAND_QUEUE_SIZE.
+ *
+ *******************************************************************************/
+uint8_t ccm_command_queue_high_water(void)
+{
+    return queue_high_water;
+}
+
+#if CCM_RTOS
+/*******************************************************************************
+ * Function Name: submit_call, submit_id_call, process_call, flush_call
+ *******************************************************************************
+ * Summary:
+ *  Queue API calls executed by the AT link task, which owns the queue. The
+ *  completion callbacks run in the AT link task.
+ *
+ *******************************************************************************/
+static void submit_call(void *arg)
+{
+    rtos_queue_call_t *call = (rtos_queue_call_t *)arg;
+
+    call->success = ccm_command_queue_submit(call->command, call->delay, call->desired_response,
+                                             call->flags, call->callback, call->callback_arg);
+}
+
+static void submit_id_call(void *arg)
+{
+    rtos_queue_call_t *call = (rtos_queue_call_t *)arg;
+
+    call->success = ccm_command_queue_submit_id(call->id, call->delay, call->flags, call->callback, call->callback_arg);
+}
+
+static void process_call(void *arg)
+{
+    ccm_command_queue_process();
+}
+
+static void flush_call(void *arg)
+{
+    rtos_queue_call_t *call = (rtos_queue_call_t *)arg;
+
+    call->success = ccm_command_queue_flush();
+}
+#endif /* CCM_RTOS */
+
+/* [] END OF FILE */
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * File Name: ccm_command_queue.h
+ *
+ * Description: This file is the public interface of ccm_command_queue.c source
+ * file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_COMMAND_QUEUE_H_
+#define CCM_COMMAND_QUEUE_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Number of commands that can be queued, sent or waiting */
+#ifndef CCM_COMMAND_QUEUE_SIZE
+#define CCM_COMMAND_QUEUE_SIZE (8)
+#endif
+
+/* Maximum number of commands sent to the CCM module before their response is
+ * received. 1 gives the stop-and-wait behavior of at_command_send_receive():
+ * the commands are still queued, each is sent once the previous one completed.
+ * Raise it only for a CCM firmware that buffers the commands received while it
+ * executes one and answers them in order, and with CCM_FRAME_TERMINATORS: a
+ * response line is matched to the oldest command in flight, so an unsolicited
+ * "OK..." or "ERR..." line sent while several commands wait would complete
+ * the wrong command. */
+#ifndef CCM_PIPELINE_DEPTH
+#define CCM_PIPELINE_DEPTH (1)
+#endif
+
+/* Maximum length of a queued AT command including the string terminator */
+#ifndef CCM_COMMAND_MAX_LENGTH
+#define CCM_COMMAND_MAX_LENGTH (96)
+#endif
+
+/* Command flags */
+#define CCM_COMMAND_FLAG_NONE    (0x00u)
+/* Sent only once every earlier command completed, and nothing is sent after it
+ * until it completes. Use for commands changing the module state (AT+CONNECT). */
+#define CCM_COMMAND_FLAG_BARRIER (0x01u)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Completion of a queued command. response is released by the queue when the
+ * callback returns; it is the empty timeout response if the command timed out. */
+typedef void (*ccm_command_callback_t)(ccm_response_t *response, int result, void *arg);
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+bool ccm_command_queue_submit(const char *command, uint32_t delay, const char *desired_response,
+                              uint8_t flags, ccm_command_callback_t callback, void *callback_arg);
+
+bool ccm_command_queue_submit_id(ccm_command_id_t id, uint32_t delay, uint8_t flags,
+                                 ccm_command_callback_t callback, void *callback_arg);
+
+void ccm_command_queue_process(void);
+
+bool ccm_command_queue_flush(void);
+
+uint8_t ccm_command_queue_pending(void);
+
+uint8_t ccm_command_queue_high_water(void);
+
+#endif /* CCM_COMMAND_QUEUE_H_ */
@@ -0,0 +1,31 @@
+/******************************************************************************
+ * File Name: ccm_commands.c
+ *
+ * Description: Flash resident AT command descriptor table, generated from
+ * CCM_COMMAND_LIST at compile time.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_commands.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+#define CCM_COMMAND_DESC(id, cmd, exp, class, log) \
+    [id] = {                                        \
+        .command = cmd,                             \
+        .expected = exp,                            \
+        .length = sizeof(cmd) - 1,                  \
+        .expected_length = sizeof(exp) - 1,         \
+        .timeout_class = CCM_TIMEOUT_CLASS_##class, \
+        .log_level = CCM_LOG_##log},
+
+const ccm_command_desc_t ccm_commands[CCM_CMD_COUNT] = {
+    CCM_COMMAND_LIST(CCM_COMMAND_DESC)};
+
+#undef CCM_COMMAND_DESC
+
+/* [] END OF FILE */
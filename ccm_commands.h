@@ -0,0 +1,93 @@
+/******************************************************************************
+ * File Name: ccm_commands.h
+ *
+ * Description: Compile-time table of the fixed AT commands sent to the CCM
+ * module. Every entry holds the command bytes, their length computed by the
+ * compiler, the expected response prefix and the timeout class, so the send
+ * path needs no strlen() or string building. The timeout class of a command
+ * sent as a string is taken from the entry with the same command word, see
+ * ccm_timeout_classify().
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_COMMANDS_H_
+#define CCM_COMMANDS_H_
+
+#include "stdint.h"
+#include "ccm_timeout.h"
+#include "ccm_log.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* X(id, command, expected response prefix ("" accepts any), timeout class,
+ *   log level of the command and its response) */
+#define CCM_COMMAND_LIST(X)                                                                  \
+    X(CCM_CMD_AT,            "AT\n",                   "OK\r\n",             QUICK,   TRACE) \
+    X(CCM_CMD_EVENT_QUERY,   "AT+EVENT?\n",            "OK",                 QUICK,   TRACE) \
+    X(CCM_CMD_CONNECT,       "AT+CONNECT\n",           "OK 1 CONNECTED\r\n", CONNECT, DEBUG) \
+    X(CCM_CMD_CONNECT_QUERY, "AT+CONNECT?\n",          "OK",                 PROBE,   TRACE) \
+    X(CCM_CMD_DISCONNECT,    "AT+DISCONNECT\n",        "",                   CONNECT, DEBUG) \
+    X(CCM_CMD_CLOUD_SYNC,    "AT+CLOUD_SYNC\n",        "",                   CONNECT, DEBUG) \
+    X(CCM_CMD_CONFMODE,      "AT+CONFMODE\n",          "",                   CONNECT, DEBUG) \
+    X(CCM_CMD_PING,          "AT+DIAG PING 8.8.8.8\n", "OK Received ping",   PROBE,   TRACE) \
+    X(CCM_CMD_OTA_ACCEPT,    "AT+OTA ACCEPT\n",        "",                   OTA,     DEBUG) \
+    X(CCM_CMD_OTA_APPLY,     "AT+OTA APPLY\n",         "",                   OTA,     DEBUG) \
+    X(CCM_CMD_GET1,          "AT+GET1\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET2,          "AT+GET2\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET3,          "AT+GET3\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET4,          "AT+GET4\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET5,          "AT+GET5\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET6,          "AT+GET6\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET7,          "AT+GET7\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_GET8,          "AT+GET8\n",              "OK",                 GET,     DEBUG) \
+    X(CCM_CMD_SUBSCRIBE1,    "AT+SUBSCRIBE1\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE2,    "AT+SUBSCRIBE2\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE3,    "AT+SUBSCRIBE3\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE4,    "AT+SUBSCRIBE4\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE5,    "AT+SUBSCRIBE5\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE6,    "AT+SUBSCRIBE6\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE7,    "AT+SUBSCRIBE7\n",        "",                   QUICK,   DEBUG) \
+    X(CCM_CMD_SUBSCRIBE8,    "AT+SUBSCRIBE8\n",        "",                   QUICK,   DEBUG)
+
+/* Number of topic indexes with a GET and SUBSCRIBE entry in the table */
+#define CCM_COMMAND_TOPIC_COUNT (8u)
+
+/* Command of topic index n (1..CCM_COMMAND_TOPIC_COUNT) */
+#define CCM_CMD_GET(n)       ((ccm_command_id_t)(CCM_CMD_GET1 + (n) - 1))
+#define CCM_CMD_SUBSCRIBE(n) ((ccm_command_id_t)(CCM_CMD_SUBSCRIBE1 + (n) - 1))
+
+/* Log level of the traffic of a command id, CCM_CMD_COUNT for string commands */
+#define CCM_COMMAND_LOG_LEVEL(id) (((id) < CCM_CMD_COUNT) ? ccm_commands[(id)].log_level : CCM_LOG_DEBUG)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+#define CCM_COMMAND_ID(id, command, expected, timeout_class, log_level) id,
+typedef enum
+{
+    CCM_COMMAND_LIST(CCM_COMMAND_ID)
+    CCM_CMD_COUNT
+} ccm_command_id_t;
+#undef CCM_COMMAND_ID
+
+typedef struct
+{
+    const char *command;
+    const char *expected;
+    uint8_t length;
+    uint8_t expected_length;
+    ccm_timeout_class_t timeout_class;
+    uint8_t log_level;
+} ccm_command_desc_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+extern const ccm_command_desc_t ccm_commands[CCM_CMD_COUNT];
+
+#endif /* CCM_COMMANDS_H_ */
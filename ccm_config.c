@@ -0,0 +1,375 @@
+/******************************************************************************
+ * File Name: ccm_config.c
+ *
+ * Description: Configuration fingerprint of the CCM module. The CCM module
+ * persists its configuration (AT+CONF) itself; this file keeps an FNV-1a hash
+ * of every AT+CONF command acknowledged by the module in a host flash row, so
+ * that after a reset only the commands whose value changed are sent again.
+ * The Passphrase can not be read back from the module, which is why a
+ * fingerprint is kept instead of comparing with AT+CONF? responses.
+ *
+ * The fingerprint only tells what was sent to the module: when the module
+ * lost its configuration (factory reset, replaced module), the application
+ * calls ccm_config_invalidate() on the first failure and configures again.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_config.h"
+#include "ccm_command_queue.h"
+#include "ccm_log.h"
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "stddef.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define CONFIG_MAGIC (0x43434D31u) /* "CCM1" */
+#define CONFIG_PREFIX "AT+CONF "
+#define CONFIG_PREFIX_LENGTH (sizeof(CONFIG_PREFIX) - 1)
+#define CONFIG_ROW_WORDS (CY_FLASH_SIZEOF_ROW / sizeof(uint32_t))
+
+#define FNV_PRIME (16777619u)
+
+/* Header, entries and checksum of the record must fit in one flash row */
+#if ((3u + 2u * CCM_CONFIG_MAX_KEYS) * 4u > CY_FLASH_SIZEOF_ROW)
+#error "CCM_CONFIG_MAX_KEYS does not fit in a flash row"
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    uint32_t key;   /* hash of the key, 0 for a free entry */
+    uint32_t value; /* hash of the acknowledged command, 0 if unknown */
+} config_entry_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t count;
+    config_entry_t entries[CCM_CONFIG_MAX_KEYS];
+    uint32_t checksum;
+} config_record_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+#if CCM_CONFIG_FINGERPRINT
+/* Emulated EEPROM section of the linker script, kept by firmware updates */
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(CY_FLASH_SIZEOF_ROW)
+static const uint32_t config_flash[CONFIG_ROW_WORDS] = {0};
+
+/* RAM copy of the flash row, written back as a whole */
+static union
+{
+    config_record_t record;
+    uint32_t words[CONFIG_ROW_WORDS];
+} config_row;
+
+/* Hash of the commands queued and not acknowledged yet, per entry */
+static uint32_t config_pending[CCM_CONFIG_MAX_KEYS];
+
+static cyhal_flash_t config_flash_obj;
+static bool config_flash_ready = false;
+static bool config_dirty = false;
+static uint8_t config_skipped = 0;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static uint32_t fingerprint(const void *data, size_t length);
+static uint32_t record_checksum(void);
+static int find_entry(uint32_t key);
+static bool command_hashes(const char *command, uint32_t *key_hash, uint32_t *value_hash, int *key_length);
+static void config_set_handler(ccm_response_t *response, int result, void *arg);
+#endif
+
+/*******************************************************************************
+ * Function Name: ccm_config_init
+ *******************************************************************************
+ * Summary:
+ *  Load the configuration fingerprint from flash. A blank or corrupted row
+ *  gives an empty fingerprint: every AT+CONF command is sent.
+ *
+ *******************************************************************************/
+void ccm_config_init(void)
+{
+#if CCM_CONFIG_FINGERPRINT
+    const volatile uint32_t *flash = config_flash;
+
+    for (uint32_t i = 0; i < CONFIG_ROW_WORDS; i++)
+    {
+        config_row.words[i] = flash[i];
+    }
+
+    if ((config_row.record.magic != CONFIG_MAGIC) || (config_row.record.count > CCM_CONFIG_MAX_KEYS) ||
+        (config_row.record.checksum != record_checksum()))
+    {
+        memset(&config_row, 0, sizeof(config_row));
+        config_row.record.magic = CONFIG_MAGIC;
+    }
+
+    config_flash_ready = (CY_RSLT_SUCCESS == cyhal_flash_init(&config_flash_obj));
+    config_skipped = 0;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_config_submit
+ *******************************************************************************
+ * Summary:
+ *  Queue an AT+CONF command, unless the module acknowledged the same command
+ *  before. Same parameters as ccm_command_queue_submit() without the desired
+ *  response and the callback.
+ *
+ * input parameter: const char *command
+ *                  "AT+CONF <key>=<value>\n"
+ *
+ * Return:
+ *  bool - false if the command queue is full.
+ *
+ *******************************************************************************/
+bool ccm_config_submit(const char *command, uint32_t delay, uint8_t flags)
+{
+#if CCM_CONFIG_FINGERPRINT
+    const char *key = command + CONFIG_PREFIX_LENGTH;
+    uint32_t key_hash = 0;
+    uint32_t value_hash = 0;
+    int key_length = 0;
+
+    if (command_hashes(command, &key_hash, &value_hash, &key_length))
+    {
+        int index = find_entry(key_hash);
+
+        if ((index >= 0) && (config_row.record.entries[index].value == value_hash))
+        {
+            /* Not logging the value, it may be the Passphrase */
+            CCM_LOG(CCM_LOG_DEBUG, "\rUnchanged, not sent: %.*s\n", key_length, key);
+            config_skipped++;
+            return true;
+        }
+
+        if ((index < 0) && (config_row.record.count < CCM_CONFIG_MAX_KEYS))
+        {
+            index = config_row.record.count++;
+            config_row.record.entries[index].key = key_hash;
+            config_row.record.entries[index].value = 0;
+        }
+
+        if (index >= 0)
+        {
+            config_pending[index] = value_hash;
+            return ccm_command_queue_submit(command, delay, NULL, flags, config_set_handler, &config_pending[index]);
+        }
+
+        CCM_LOG(CCM_LOG_WARN, "\rNo fingerprint entry left for %.*s\n", key_length, key);
+    }
+#endif
+
+    return ccm_command_queue_submit(command, delay, NULL, flags, NULL, NULL);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_config_is_current
+ *******************************************************************************
+ * Summary:
+ *  Check whether the module acknowledged the same AT+CONF command before,
+ *  i.e. whether ccm_config_submit() would skip it.
+ *
+ * input parameter: const char *command
+ *                  "AT+CONF <key>=<value>\n"
+ *
+ * Return:
+ *  bool - false if the value changed or is not known.
+ *
+ *******************************************************************************/
+bool ccm_config_is_current(const char *command)
+{
+#if CCM_CONFIG_FINGERPRINT
+    uint32_t key_hash = 0;
+    uint32_t value_hash = 0;
+    int key_length = 0;
+
+    if (command_hashes(command, &key_hash, &value_hash, &key_length))
+    {
+        int index = find_entry(key_hash);
+
+        return (index >= 0) && (config_row.record.entries[index].value == value_hash);
+    }
+#endif
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_config_commit
+ *******************************************************************************
+ * Summary:
+ *  Write the fingerprint to flash if a command changed it. Call once the
+ *  submitted commands completed (ccm_command_queue_flush()), at most once per
+ *  boot in normal operation.
+ *
+ * Return:
+ *  bool - false if the flash write failed.
+ *
+ *******************************************************************************/
+bool ccm_config_commit(void)
+{
+#if CCM_CONFIG_FINGERPRINT
+    if (!config_dirty)
+    {
+        return true;
+    }
+
+    if (!config_flash_ready)
+    {
+        return false;
+    }
+
+    config_row.record.checksum = record_checksum();
+
+    if (CY_RSLT_SUCCESS != cyhal_flash_write(&config_flash_obj, (uint32_t)(uintptr_t)config_flash, config_row.words))
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\rConfiguration fingerprint write failed\n");
+        return false;
+    }
+
+    config_dirty = false;
+#endif
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_config_invalidate
+ *******************************************************************************
+ * Summary:
+ *  Forget the fingerprint, in RAM and flash: every AT+CONF command submitted
+ *  from now on is sent.
+ *
+ *******************************************************************************/
+void ccm_config_invalidate(void)
+{
+#if CCM_CONFIG_FINGERPRINT
+    memset(&config_row, 0, sizeof(config_row));
+    config_row.record.magic = CONFIG_MAGIC;
+    config_skipped = 0;
+    config_dirty = true;
+
+    ccm_config_commit();
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_config_skipped
+ *******************************************************************************
+ * Summary:
+ *  Number of AT+CONF commands not sent since boot or the last
+ *  ccm_config_invalidate() because their value was unchanged.
+ *
+ *******************************************************************************/
+uint8_t ccm_config_skipped(void)
+{
+#if CCM_CONFIG_FINGERPRINT
+    return config_skipped;
+#else
+    return 0;
+#endif
+}
+
+#if CCM_CONFIG_FINGERPRINT
+/*******************************************************************************
+ * Function Name: config_set_handler
+ *******************************************************************************
+ * Summary:
+ *  Completion of a queued AT+CONF command: the fingerprint entry takes the
+ *  hash of the command if the module acknowledged it, and is cleared
+ *  otherwise so that the command is sent again next time.
+ *
+ *******************************************************************************/
+static void config_set_handler(ccm_response_t *response, int result, void *arg)
+{
+    uint32_t *pending = (uint32_t *)arg;
+    config_entry_t *entry = &config_row.record.entries[pending - config_pending];
+    uint32_t value = result ? *pending : 0;
+
+    if (entry->value != value)
+    {
+        entry->value = value;
+        config_dirty = true;
+    }
+}
+
+static int find_entry(uint32_t key)
+{
+    for (uint32_t i = 0; i < config_row.record.count; i++)
+    {
+        if (config_row.record.entries[i].key == key)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Hashes of the key and of the whole command, false if not an AT+CONF command */
+static bool command_hashes(const char *command, uint32_t *key_hash, uint32_t *value_hash, int *key_length)
+{
+    const char *key = command + CONFIG_PREFIX_LENGTH;
+    const char *separator = strchr(command, '=');
+
+    if ((0 != strncmp(command, CONFIG_PREFIX, CONFIG_PREFIX_LENGTH)) || (separator == NULL) || (separator <= key))
+    {
+        return false;
+    }
+
+    *key_length = (int)(separator - key);
+    *key_hash = fingerprint(key, *key_length);
+    *value_hash = fingerprint(command, strlen(command));
+
+    return true;
+}
+
+static uint32_t record_checksum(void)
+{
+    return fingerprint(&config_row.record, offsetof(config_record_t, checksum));
+}
+
+/* ccm_fnv1a() never 0, which marks a free or unknown entry */
+static uint32_t fingerprint(const void *data, size_t length)
+{
+    uint32_t hash = ccm_fnv1a(CCM_FNV1A_INIT, data, length);
+
+    return (hash != 0) ? hash : 1;
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: ccm_fnv1a
+ *******************************************************************************
+ * Summary:
+ *  32-bit FNV-1a hash, the checksum of the flash records and the configuration
+ *  fingerprint. Start with CCM_FNV1A_INIT; the result of one call is the hash
+ *  to continue with for the next bytes.
+ *
+ *******************************************************************************/
+uint32_t ccm_fnv1a(uint32_t hash, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/* [] END OF FILE */
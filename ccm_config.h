@@ -0,0 +1,52 @@
+/******************************************************************************
+ * File Name: ccm_config.h
+ *
+ * Description: This file is the public interface of ccm_config.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_CONFIG_H_
+#define CCM_CONFIG_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set to 0 to send every AT+CONF command at every boot */
+#ifndef CCM_CONFIG_FINGERPRINT
+#define CCM_CONFIG_FINGERPRINT (1)
+#endif
+
+/* Number of configuration keys whose fingerprint is kept */
+#ifndef CCM_CONFIG_MAX_KEYS
+#define CCM_CONFIG_MAX_KEYS (16u)
+#endif
+
+/* Initial value of ccm_fnv1a() */
+#define CCM_FNV1A_INIT (2166136261u)
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_config_init(void);
+
+bool ccm_config_submit(const char *command, uint32_t delay, uint8_t flags);
+
+bool ccm_config_is_current(const char *command);
+
+bool ccm_config_commit(void);
+
+void ccm_config_invalidate(void);
+
+uint8_t ccm_config_skipped(void);
+
+uint32_t ccm_fnv1a(uint32_t hash, const void *data, size_t length);
+
+#endif /* CCM_CONFIG_H_ */
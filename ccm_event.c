@@ -0,0 +1,249 @@
+/******************************************************************************
+ * File Name: ccm_event.c
+ *
+ * Description: Table driven dispatcher for the events reported by AT+EVENT?.
+ * The event fields are tokenized from the AT+EVENT? answer only (see
+ * at_command_execute()), dispatching is a constant time table lookup keyed by
+ * (type, id).
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_event.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Handlers for a given (type, id) */
+static ccm_event_handler_t event_handlers[CCM_EVENT_TYPE_COUNT][CCM_EVENT_ID_COUNT];
+
+/* Handlers for every id of a type, used when no (type, id) handler exists */
+static ccm_event_handler_t event_type_handlers[CCM_EVENT_TYPE_COUNT];
+
+/* Handler for the events nobody registered for */
+static ccm_event_handler_t event_default_handler;
+
+/* Handler called once the events of a drain are dispatched */
+static ccm_event_drain_handler_t event_drain_handler;
+
+static ccm_event_stats_t event_stats;
+
+/*******************************************************************************
+ * Function Name: ccm_event_register
+ *******************************************************************************
+ * Summary:
+ *  Register the handler of an event. A NULL handler removes the registration.
+ *
+ * input parameter: uint8_t type
+ *                  Event type, CCM_EVENT_xxx
+ *
+ * input parameter: uint8_t id
+ *                  Event id, CCM_EVENT_ID_ANY for every id of the type
+ *
+ * input parameter: ccm_event_handler_t handler
+ *                  Function called from ccm_event_dispatch()
+ *
+ * Return:
+ *  bool - false if type or id is outside the handler table.
+ *
+ *******************************************************************************/
+bool ccm_event_register(uint8_t type, uint8_t id, ccm_event_handler_t handler)
+{
+    if (type >= CCM_EVENT_TYPE_COUNT)
+    {
+        return false;
+    }
+
+    if (id == CCM_EVENT_ID_ANY)
+    {
+        event_type_handlers[type] = handler;
+        return true;
+    }
+
+    if (id >= CCM_EVENT_ID_COUNT)
+    {
+        return false;
+    }
+
+    event_handlers[type][id] = handler;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_event_set_default_handler
+ *******************************************************************************
+ * Summary:
+ *  Register the handler called for events without a registered handler.
+ *
+ *******************************************************************************/
+void ccm_event_set_default_handler(ccm_event_handler_t handler)
+{
+    event_default_handler = handler;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_event_set_drain_handler
+ *******************************************************************************
+ * Summary:
+ *  Register the handler called at the end of every dispatching drain.
+ *
+ *******************************************************************************/
+void ccm_event_set_drain_handler(ccm_event_drain_handler_t handler)
+{
+    event_drain_handler = handler;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_event_dispatch
+ *******************************************************************************
+ * Summary:
+ *  Call the handler of an AT+EVENT? response.
+ *
+ * input parameter: ccm_response_t *event
+ *                  Response of AT+EVENT?
+ *
+ * Return:
+ *  bool - false if the response is not an event ("OK" of an empty event queue,
+ *         error or timeout); the default handler is not called in that case.
+ *
+ *******************************************************************************/
+bool ccm_event_dispatch(ccm_response_t *event)
+{
+    uint8_t type = event->event_type;
+    uint8_t id = event->event_id;
+    ccm_event_handler_t handler = NULL;
+
+    if (type == CCM_EVENT_NONE)
+    {
+        return false;
+    }
+
+    /* Keep the connection state cache up to date */
+    if (type == CCM_EVENT_STARTUP)
+    {
+        ccm_link_invalidate();
+    }
+    else if (type == CCM_EVENT_CONLOST)
+    {
+        ccm_link_set_aws_state(CCM_LINK_DOWN);
+    }
+    else if (type == CCM_EVENT_CONNECT)
+    {
+        ccm_link_set_aws_state(CCM_LINK_UP);
+    }
+    else if (type == CCM_EVENT_MSG)
+    {
+        /* Keeps a connected state fresh, does not make one up */
+        ccm_link_aws_alive();
+    }
+
+    if (type < CCM_EVENT_TYPE_COUNT)
+    {
+        if (id < CCM_EVENT_ID_COUNT)
+        {
+            handler = event_handlers[type][id];
+        }
+
+        if (handler == NULL)
+        {
+            handler = event_type_handlers[type];
+        }
+    }
+
+    if (handler == NULL)
+    {
+        handler = event_default_handler;
+    }
+
+    if (handler)
+    {
+        handler(event);
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_event_drain
+ *******************************************************************************
+ * Summary:
+ *  Pull events from the CCM event queue with AT+EVENT? until the queue reports
+ *  empty ("OK"), so a burst of events is handled in one wake-up. At most
+ *  CCM_EVENT_DRAIN_MAX events are handled per call to bound the time spent.
+ *  The drain handler runs after the last event.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of each AT+EVENT? in milliseconds
+ *
+ * input parameter: bool dispatch
+ *                  true to call the event handlers, false to discard the events
+ *
+ * Return:
+ *  uint8_t - number of events pulled. CCM_EVENT_DRAIN_MAX means the queue may
+ *            not be empty yet.
+ *
+ *******************************************************************************/
+uint8_t ccm_event_drain(uint32_t delay, bool dispatch)
+{
+    int result = 0;
+    uint8_t count = 0;
+
+    while (count < CCM_EVENT_DRAIN_MAX)
+    {
+        /* AT command for checking the events queued in CCM module*/
+        ccm_response_t *event = at_command_execute(CCM_CMD_EVENT_QUERY, delay, &result);
+        bool is_event = (event->event_type != CCM_EVENT_NONE);
+
+        if (is_event && dispatch)
+        {
+            ccm_event_dispatch(event);
+        }
+
+        ccm_response_release(event);
+
+        if (!is_event)
+        {
+            break;
+        }
+
+        count++;
+    }
+
+    if (dispatch && event_drain_handler)
+    {
+        event_drain_handler();
+    }
+
+    event_stats.drains++;
+    event_stats.events += count;
+    event_stats.last_batch = count;
+
+    if (count > event_stats.max_batch)
+    {
+        event_stats.max_batch = count;
+    }
+
+    if (count == CCM_EVENT_DRAIN_MAX)
+    {
+        event_stats.limit_hits++;
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_event_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Event queue drain statistics.
+ *
+ *******************************************************************************/
+const ccm_event_stats_t *ccm_event_get_stats(void)
+{
+    return &event_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,85 @@
+/******************************************************************************
+ * File Name: ccm_event.h
+ *
+ * Description: This file is the public interface of ccm_event.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_EVENT_H_
+#define CCM_EVENT_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Event types reported by AT+EVENT? as "OK <type> <id> <name>" */
+#define CCM_EVENT_MSG     (1u) /* <id> is the topic index */
+#define CCM_EVENT_STARTUP (2u)
+#define CCM_EVENT_CONLOST (3u)
+#define CCM_EVENT_OVERRUN (4u)
+#define CCM_EVENT_OTA     (5u) /* <id> is the OTA state */
+#define CCM_EVENT_CONNECT (6u) /* connected to AWS IoT core */
+
+/* OTA event ids */
+#define CCM_EVENT_OTA_AVAILABLE (1u)
+#define CCM_EVENT_OTA_VERIFIED  (4u)
+
+/* Register a handler for every id of an event type */
+#define CCM_EVENT_ID_ANY (CCM_EVENT_NONE)
+
+/* Dimensions of the handler table, events outside go to the default handler */
+#ifndef CCM_EVENT_TYPE_COUNT
+#define CCM_EVENT_TYPE_COUNT (16u)
+#endif
+
+#ifndef CCM_EVENT_ID_COUNT
+#define CCM_EVENT_ID_COUNT (16u)
+#endif
+
+/* Maximum number of events handled by one ccm_event_drain() call */
+#ifndef CCM_EVENT_DRAIN_MAX
+#define CCM_EVENT_DRAIN_MAX (16u)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Event handler, event->event_type and event->event_id identify the event.
+ * The event is released by the caller when the handler returns. */
+typedef void (*ccm_event_handler_t)(ccm_response_t *event);
+
+/* Called at the end of a dispatching ccm_event_drain(), the work deferred by
+ * the event handlers (batched message fetches) is done from here */
+typedef void (*ccm_event_drain_handler_t)(void);
+
+/* Event queue drain statistics */
+typedef struct
+{
+    uint32_t drains;     /* ccm_event_drain() calls */
+    uint32_t events;     /* events handled over all drains */
+    uint32_t limit_hits; /* drains stopped by CCM_EVENT_DRAIN_MAX */
+    uint8_t last_batch;  /* events handled by the last drain */
+    uint8_t max_batch;   /* largest number of events handled by one drain */
+} ccm_event_stats_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+bool ccm_event_register(uint8_t type, uint8_t id, ccm_event_handler_t handler);
+
+void ccm_event_set_default_handler(ccm_event_handler_t handler);
+
+void ccm_event_set_drain_handler(ccm_event_drain_handler_t handler);
+
+bool ccm_event_dispatch(ccm_response_t *event);
+
+uint8_t ccm_event_drain(uint32_t delay, bool dispatch);
+
+const ccm_event_stats_t *ccm_event_get_stats(void);
+
+#endif /* CCM_EVENT_H_ */
@@ -0,0 +1,375 @@
+/******************************************************************************
+ * File Name: ccm_hal.c
+ *
+ * Description: PSoC 6 implementation of the CCM link hardware interface on
+ * the cyhal API's. Compiled out when CCM_HAL_CUSTOM is defined, the port then
+ * provides its own implementation of ccm_hal.h.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_hal.h"
+
+#ifndef CCM_HAL_CUSTOM
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "cybsp.h"
+#include "cy_retarget_io.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define DATA_BITS_8 (8)
+#define STOP_BITS_1 (1)
+#define UART_INTERRUPT_PRIORITY (3u)
+#define LPTIMER_INTERRUPT_PRIORITY (4u)
+#define UART_DMA_PRIORITY (3u)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/*uart-object */
+cyhal_uart_t uart_obj;
+
+/* UART configuration*/
+const cyhal_uart_cfg_t uart_config =
+    {
+        .data_bits = DATA_BITS_8,
+        .stop_bits = STOP_BITS_1,
+        .parity = CYHAL_UART_PARITY_NONE,
+        .rx_buffer = NULL,
+        .rx_buffer_size = 0};
+
+/* low power timer used as time base and as wake-up source */
+static cyhal_lptimer_t lptimer_obj;
+
+static ccm_hal_uart_handler_t uart_handler;
+static ccm_hal_uart_tx_handler_t uart_tx_handler;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void uart_event_handler(void *callback_arg, cyhal_uart_event_t event);
+
+/*******************************************************************************
+ * Function Name: ccm_hal_board_init
+ *******************************************************************************
+ * Summary:
+ *  BSP initialization.
+ *
+ *******************************************************************************/
+void ccm_hal_board_init(void)
+{
+    cybsp_init();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_init
+ *******************************************************************************
+ * Summary:
+ *  Initialize the UART to the CCM module (pins P12_0 and P12_1) with its
+ *  receive interrupt.
+ *
+ * input parameter: uint32_t baud
+ *                  Initial baud rate
+ *
+ * input parameter: ccm_hal_uart_handler_t handler
+ *                  Called from the receive interrupt
+ *
+ * input parameter: ccm_hal_uart_tx_handler_t tx_handler
+ *                  Called when an asynchronous transfer is complete
+ *
+ *******************************************************************************/
+void ccm_hal_uart_init(uint32_t baud, ccm_hal_uart_handler_t handler, ccm_hal_uart_tx_handler_t tx_handler)
+{
+    uint32_t actual_baud = 0;
+
+    uart_handler = handler;
+    uart_tx_handler = tx_handler;
+
+    cyhal_uart_init(&uart_obj, P12_1, P12_0, NC, NC, NULL, &uart_config);
+    cyhal_uart_set_baud(&uart_obj, baud, &actual_baud);
+
+    /* Asynchronous transfers by DMA, the interrupt driven software mode of
+     * cyhal stays in use if no DMA channel is available */
+    cyhal_uart_config_async(&uart_obj, CYHAL_ASYNC_DMA, UART_DMA_PRIORITY);
+
+    cyhal_uart_register_callback(&uart_obj, uart_event_handler, NULL);
+    cyhal_uart_enable_event(&uart_obj, (cyhal_uart_event_t)(CYHAL_UART_IRQ_RX_NOT_EMPTY | CYHAL_UART_IRQ_RX_ERROR |
+                                                            CYHAL_UART_IRQ_TX_DONE),
+                            UART_INTERRUPT_PRIORITY, true);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_set_baud
+ *******************************************************************************
+ * Summary:
+ *  Change the baud rate of the CCM UART.
+ *
+ * Return:
+ *  bool - false if the clock divider can not be set, actual_baud is the rate
+ *         achieved otherwise.
+ *
+ *******************************************************************************/
+bool ccm_hal_uart_set_baud(uint32_t baud, uint32_t *actual_baud)
+{
+    return (CY_RSLT_SUCCESS == cyhal_uart_set_baud(&uart_obj, baud, actual_baud));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_write
+ *******************************************************************************
+ * Summary:
+ *  Send bytes to the CCM module. cyhal_uart_write() only takes the bytes the
+ *  TX FIFO has room for, it is called again until every byte is taken: the
+ *  function returns once the last byte is in the TX FIFO.
+ *
+ * Return:
+ *  bool - false if the UART reported an error, part of the bytes may be sent.
+ *
+ *******************************************************************************/
+bool ccm_hal_uart_write(const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t written = length;
+
+        if (CY_RSLT_SUCCESS != cyhal_uart_write(&uart_obj, (void *)data, &written))
+        {
+            return false;
+        }
+
+        data += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_write_async
+ *******************************************************************************
+ * Summary:
+ *  Start sending bytes to the CCM module and return right away, the transmit
+ *  handler is called once the last byte is sent. data must stay valid until
+ *  then. One transfer at a time.
+ *
+ * Return:
+ *  bool - false if the transfer could not be started.
+ *
+ *******************************************************************************/
+bool ccm_hal_uart_write_async(const uint8_t *data, size_t length)
+{
+    return (CY_RSLT_SUCCESS == cyhal_uart_write_async(&uart_obj, (void *)data, length));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_read
+ *******************************************************************************
+ * Summary:
+ *  Move up to size bytes received from the CCM module out of the RX FIFO,
+ *  never waits. The receive interrupt of CCM.c calls it in chunks of 16 bytes
+ *  until the FIFO is empty.
+ *
+ * Return:
+ *  size_t - number of bytes written to buffer.
+ *
+ *******************************************************************************/
+size_t ccm_hal_uart_read(uint8_t *buffer, size_t size)
+{
+    size_t count = 0;
+
+    while ((count < size) && (cyhal_uart_readable(&uart_obj) > 0))
+    {
+        if (CY_RSLT_SUCCESS != cyhal_uart_getc(&uart_obj, &buffer[count], 0))
+        {
+            break;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: uart_event_handler
+ *******************************************************************************
+ * Summary:
+ *  cyhal UART interrupt callback: pass the receive and error events to the
+ *  receive handler of CCM.c, which empties the RX FIFO with
+ *  ccm_hal_uart_read(), and the end of an asynchronous transfer to the
+ *  transmit handler.
+ *
+ *******************************************************************************/
+static void uart_event_handler(void *callback_arg, cyhal_uart_event_t event)
+{
+    if ((event & (CYHAL_UART_IRQ_RX_NOT_EMPTY | CYHAL_UART_IRQ_RX_ERROR)) && uart_handler)
+    {
+        uart_handler((event & CYHAL_UART_IRQ_RX_ERROR) != 0);
+    }
+
+    if ((event & CYHAL_UART_IRQ_TX_DONE) && uart_tx_handler)
+    {
+        uart_tx_handler();
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_debug_init
+ *******************************************************************************
+ * Summary:
+ *  Initialize the debug UART used by printf and enable the interrupts.
+ *
+ *******************************************************************************/
+void ccm_hal_debug_init(void)
+{
+    cy_retarget_io_init(CYBSP_DEBUG_UART_TX, CYBSP_DEBUG_UART_RX,
+                        CY_RETARGET_IO_BAUDRATE);
+
+    /* Enable global interrupts */
+    __enable_irq();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_debug_write
+ *******************************************************************************
+ * Summary:
+ *  Write to the debug UART without waiting: only the bytes the TX FIFO has
+ *  room for now are taken.
+ *
+ * Return:
+ *  size_t - number of bytes taken, 0 if the FIFO is full.
+ *
+ *******************************************************************************/
+size_t ccm_hal_debug_write(const char *data, size_t length)
+{
+    if (CY_RSLT_SUCCESS != cyhal_uart_write(&cy_retarget_io_uart_obj, (void *)data, &length))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_timer_init
+ *******************************************************************************
+ * Summary:
+ *  Start the low power timer, the time base of the CCM link. It keeps
+ *  counting in deep sleep and its match event is a deep sleep wake-up source.
+ *
+ * Return:
+ *  uint32_t - timer frequency in Hz.
+ *
+ *******************************************************************************/
+uint32_t ccm_hal_timer_init(void)
+{
+    cyhal_lptimer_info_t lptimer_info;
+
+    cyhal_lptimer_init(&lptimer_obj);
+    cyhal_lptimer_get_info(&lptimer_obj, &lptimer_info);
+    cyhal_lptimer_enable_event(&lptimer_obj, CYHAL_LPTIMER_COMPARE_MATCH,
+                               LPTIMER_INTERRUPT_PRIORITY, true);
+
+    return lptimer_info.frequency_hz;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_timer_read
+ *******************************************************************************
+ * Summary:
+ *  Free running 32-bit timer counter, can be called from interrupt context.
+ *
+ *******************************************************************************/
+uint32_t ccm_hal_timer_read(void)
+{
+    return cyhal_lptimer_read(&lptimer_obj);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_timer_set_wakeup
+ *******************************************************************************
+ * Summary:
+ *  Generate a wake-up interrupt after ticks, at most CCM_HAL_TIMER_MAX_DELAY.
+ *
+ *******************************************************************************/
+void ccm_hal_timer_set_wakeup(uint32_t ticks)
+{
+    cyhal_lptimer_set_delay(&lptimer_obj, ticks);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_critical_section_enter
+ *******************************************************************************
+ * Summary:
+ *  Disable the interrupts, can be nested.
+ *
+ * Return:
+ *  uint32_t - interrupt state to pass to ccm_hal_critical_section_exit().
+ *
+ *******************************************************************************/
+uint32_t ccm_hal_critical_section_enter(void)
+{
+    return cyhal_system_critical_section_enter();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_critical_section_exit
+ *******************************************************************************
+ * Summary:
+ *  Restore the interrupt state saved by ccm_hal_critical_section_enter().
+ *
+ *******************************************************************************/
+void ccm_hal_critical_section_exit(uint32_t state)
+{
+    cyhal_system_critical_section_exit(state);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_sleep
+ *******************************************************************************
+ * Summary:
+ *  Sleep the CPU until the next interrupt, the peripherals keep running.
+ *  Called inside a critical section: a pending interrupt still wakes it up.
+ *
+ *******************************************************************************/
+void ccm_hal_sleep(void)
+{
+    cyhal_syspm_sleep();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_deep_sleep
+ *******************************************************************************
+ * Summary:
+ *  Deep sleep until a deep sleep capable wake-up source (GPIO, low power
+ *  timer), called inside a critical section.
+ *
+ * Return:
+ *  bool - false if deep sleep was refused, e.g. the debug UART is still
+ *         transmitting; the caller sleeps instead.
+ *
+ *******************************************************************************/
+bool ccm_hal_deep_sleep(void)
+{
+    return (CY_RSLT_SUCCESS == cyhal_syspm_deepsleep());
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_delay_ms
+ *******************************************************************************
+ * Summary:
+ *  Busy wait for delay milliseconds.
+ *
+ *******************************************************************************/
+void ccm_hal_delay_ms(uint32_t delay)
+{
+    cyhal_system_delay_ms(delay);
+}
+
+#endif /* CCM_HAL_CUSTOM */
+
+/* [] END OF FILE */
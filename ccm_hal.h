@@ -0,0 +1,81 @@
+/******************************************************************************
+ * File Name: ccm_hal.h
+ *
+ * Description: This file is the public interface of ccm_hal.c source file,
+ * the hardware the CCM link (CCM.c, ccm_log.c) runs on: the UART to the CCM
+ * module, the debug UART, a free running low power timer and the power modes.
+ *
+ * While porting to any other microcontroller, or to run the CCM link on a
+ * host against an emulated CCM module, define CCM_HAL_CUSTOM and implement
+ * these functions instead of modifying CCM.c. host/ccm_hal_host.c is the
+ * host implementation, against the scripted CCM emulator of host/ccm_emulator.c
+ * (see host/Makefile).
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_HAL_H_
+#define CCM_HAL_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Longest wake-up delay ccm_hal_timer_set_wakeup() accepts, in timer ticks */
+#ifndef CCM_HAL_TIMER_MAX_DELAY
+#define CCM_HAL_TIMER_MAX_DELAY (0xFFFFu)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Called from interrupt context when the CCM UART received data or detected an
+ * error, read the data with ccm_hal_uart_read() */
+typedef void (*ccm_hal_uart_handler_t)(bool error);
+
+/* Called from interrupt context when the transfer started with
+ * ccm_hal_uart_write_async() is complete */
+typedef void (*ccm_hal_uart_tx_handler_t)(void);
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_hal_board_init(void);
+
+void ccm_hal_uart_init(uint32_t baud, ccm_hal_uart_handler_t handler, ccm_hal_uart_tx_handler_t tx_handler);
+
+bool ccm_hal_uart_set_baud(uint32_t baud, uint32_t *actual_baud);
+
+bool ccm_hal_uart_write(const char *data, size_t length);
+
+bool ccm_hal_uart_write_async(const uint8_t *data, size_t length);
+
+size_t ccm_hal_uart_read(uint8_t *buffer, size_t size);
+
+void ccm_hal_debug_init(void);
+
+size_t ccm_hal_debug_write(const char *data, size_t length);
+
+uint32_t ccm_hal_timer_init(void);
+
+uint32_t ccm_hal_timer_read(void);
+
+void ccm_hal_timer_set_wakeup(uint32_t ticks);
+
+uint32_t ccm_hal_critical_section_enter(void);
+
+void ccm_hal_critical_section_exit(uint32_t state);
+
+void ccm_hal_sleep(void);
+
+bool ccm_hal_deep_sleep(void);
+
+void ccm_hal_delay_ms(uint32_t delay);
+
+#endif /* CCM_HAL_H_ */
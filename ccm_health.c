@@ -0,0 +1,200 @@
+/******************************************************************************
+ * File Name: ccm_health.c
+ *
+ * Description: Passive health monitor of the AWS IoT core connection. Every
+ * received message and CCM event already updates the connection state cache
+ * (ccm_event.c); the monitor takes the last such update as proof that the
+ * connection is alive and only probes with AT+CONNECT?, answered by the CCM
+ * module without WAN traffic, once nothing was received for
+ * CCM_HEALTH_QUIET_TIME. While not connected it probes every
+ * CCM_HEALTH_RETRY_TIME. The latency of the probe is measured on every probe;
+ * the RSSI only if the integrator defines CCM_HEALTH_RSSI_COMMAND, read in the
+ * same pipelined batch.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_health.h"
+#include "ccm_command_queue.h"
+#include "stdlib.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static ccm_health_handler_t health_handler = NULL;
+static void *health_arg = NULL;
+static ccm_health_stats_t health_stats;
+
+/* ccm_get_time_ms() when the last probe was sent */
+static uint32_t probe_time = 0;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void probe(uint32_t delay);
+static void report(ccm_link_state_t state);
+static void probe_handler(ccm_response_t *response, int result, void *arg);
+static void rssi_handler(ccm_response_t *response, int result, void *arg);
+
+/*******************************************************************************
+ * Function Name: ccm_health_init
+ *******************************************************************************
+ * Summary:
+ *  Start monitoring from the current connection state.
+ *
+ * input parameter: ccm_health_handler_t handler
+ *                  Called when the AWS IoT core state changes, may be NULL
+ *
+ * input parameter: void *arg
+ *                  Passed to the handler unchanged
+ *
+ *******************************************************************************/
+void ccm_health_init(ccm_health_handler_t handler, void *arg)
+{
+    health_handler = handler;
+    health_arg = arg;
+
+    memset(&health_stats, 0, sizeof(health_stats));
+    health_stats.aws = ccm_link_get_aws_state();
+    health_stats.last_alive = ccm_link_get_aws_time();
+    health_stats.rssi = CCM_HEALTH_RSSI_UNKNOWN;
+
+    probe_time = ccm_get_time_ms();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_health_process
+ *******************************************************************************
+ * Summary:
+ *  Report a state change seen from the received traffic, and probe the
+ *  connection if it was quiet for too long. Call from the main loop.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of the probe in milliseconds
+ *
+ * Return:
+ *  uint32_t - ms until the next probe is due, for the main loop sleep.
+ *
+ *******************************************************************************/
+uint32_t ccm_health_process(uint32_t delay)
+{
+    uint32_t now = ccm_get_time_ms();
+    ccm_link_state_t state = ccm_link_get_aws_state();
+    uint32_t elapsed = 0;
+    uint32_t interval = 0;
+
+    if (state == CCM_LINK_UP)
+    {
+        health_stats.last_alive = ccm_link_get_aws_time();
+        elapsed = now - health_stats.last_alive;
+        interval = CCM_HEALTH_QUIET_TIME;
+    }
+    else
+    {
+        elapsed = now - probe_time;
+        interval = CCM_HEALTH_RETRY_TIME;
+    }
+
+    /* Lost or recovered according to the received events */
+    report(state);
+
+    if (elapsed < interval)
+    {
+        return interval - elapsed;
+    }
+
+    probe(delay);
+
+    state = ccm_link_get_aws_state();
+    if (state == CCM_LINK_UP)
+    {
+        health_stats.last_alive = ccm_link_get_aws_time();
+    }
+    report(state);
+
+    return (state == CCM_LINK_UP) ? CCM_HEALTH_QUIET_TIME : CCM_HEALTH_RETRY_TIME;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_health_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Copy of the monitor statistics and link metrics.
+ *
+ *******************************************************************************/
+void ccm_health_get_stats(ccm_health_stats_t *stats)
+{
+    *stats = health_stats;
+}
+
+/* AT+CONNECT? and the RSSI command in one pipelined batch */
+static void probe(uint32_t delay)
+{
+    probe_time = ccm_get_time_ms();
+    health_stats.probes++;
+
+    ccm_command_queue_submit_id(CCM_CMD_CONNECT_QUERY, delay, CCM_COMMAND_FLAG_NONE, probe_handler, NULL);
+
+    if (sizeof(CCM_HEALTH_RSSI_COMMAND) > 1)
+    {
+        ccm_command_queue_submit(CCM_HEALTH_RSSI_COMMAND, delay, "OK", CCM_COMMAND_FLAG_NONE, rssi_handler, NULL);
+    }
+
+    ccm_command_queue_flush();
+}
+
+static void report(ccm_link_state_t state)
+{
+    if (state == health_stats.aws)
+    {
+        return;
+    }
+
+    if (health_stats.aws == CCM_LINK_UP)
+    {
+        health_stats.losses++;
+    }
+
+    health_stats.aws = state;
+
+    if (health_handler)
+    {
+        health_handler(state, health_arg);
+    }
+}
+
+static void probe_handler(ccm_response_t *response, int result, void *arg)
+{
+    uint32_t latency = ccm_get_time_ms() - probe_time;
+
+    if (response->slot == CCM_RESPONSE_NO_SLOT)
+    {
+        /* No answer: the state is not known any more, probed again in CCM_HEALTH_RETRY_TIME */
+        ccm_link_invalidate();
+        return;
+    }
+
+    health_stats.probe_latency = latency;
+    if (latency > health_stats.probe_latency_max)
+    {
+        health_stats.probe_latency_max = latency;
+    }
+
+    ccm_link_probe_complete(CCM_CMD_CONNECT_QUERY, response, result);
+}
+
+/* First number of the response, e.g. "OK -61" */
+static void rssi_handler(ccm_response_t *response, int result, void *arg)
+{
+    const char *number = strpbrk(response->data, "-0123456789");
+
+    if (result && number)
+    {
+        health_stats.rssi = (int16_t)strtol(number, NULL, 10);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,69 @@
+/******************************************************************************
+ * File Name: ccm_health.h
+ *
+ * Description: This file is the public interface of ccm_health.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_HEALTH_H_
+#define CCM_HEALTH_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Time without a received message or event after which the AWS IoT core
+ * connection is probed, ms */
+#ifndef CCM_HEALTH_QUIET_TIME
+#define CCM_HEALTH_QUIET_TIME (300000u)
+#endif
+
+/* Interval of the probes while not connected, ms */
+#ifndef CCM_HEALTH_RETRY_TIME
+#define CCM_HEALTH_RETRY_TIME (30000u)
+#endif
+
+/* AT command answering the RSSI in dBm as the first number of its response
+ * ("OK -61"), pipelined after every probe. The AT command set of the CCM
+ * module has no such query, so the RSSI is not read by default: the
+ * integrator supplies the command of the CCM firmware in use that reports it.
+ * Without it rssi stays CCM_HEALTH_RSSI_UNKNOWN, the latency is always read */
+#ifndef CCM_HEALTH_RSSI_COMMAND
+#define CCM_HEALTH_RSSI_COMMAND ""
+#endif
+
+/* RSSI not read yet */
+#define CCM_HEALTH_RSSI_UNKNOWN (0)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    ccm_link_state_t aws;    /* last reported AWS IoT core state */
+    uint32_t last_alive;     /* ccm_get_time_ms() of the last proof of the connection */
+    uint32_t probes;         /* AT+CONNECT? sent by the monitor */
+    uint32_t losses;         /* connected to not connected transitions */
+    uint32_t probe_latency;  /* ms, last probe */
+    uint32_t probe_latency_max;
+    int16_t rssi;            /* dBm, CCM_HEALTH_RSSI_UNKNOWN if not read */
+} ccm_health_stats_t;
+
+/* Called when the AWS IoT core state changes */
+typedef void (*ccm_health_handler_t)(ccm_link_state_t state, void *arg);
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_health_init(ccm_health_handler_t handler, void *arg);
+
+uint32_t ccm_health_process(uint32_t delay);
+
+void ccm_health_get_stats(ccm_health_stats_t *stats);
+
+#endif /* CCM_HEALTH_H_ */
@@ -0,0 +1,280 @@
+/******************************************************************************
+ * File Name: ccm_log.c
+ *
+ * Description: Deferred, buffered logging. Messages are formatted by the
+ * caller into a RAM ring and written to the debug UART later from the idle
+ * loop, only as fast as its TX FIFO takes them, so that a slow debug console
+ * never delays the AT command path. Writing never blocks: a message that does
+ * not fit into the ring is dropped and counted.
+ *
+ * ccm_log_data() is safe to call from interrupt context. ccm_log_write() and
+ * CCM_LOG() format with vsnprintf(), which is not: use them from task or main
+ * loop context only.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_log.h"
+#include "ccm_rtos.h"
+#include "ccm_hal.h"
+#include "stdarg.h"
+#include "stdio.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define LOG_RING_MASK (CCM_LOG_RING_SIZE - 1u)
+
+#if (CCM_LOG_RING_SIZE & LOG_RING_MASK)
+#error "CCM_LOG_RING_SIZE must be a power of two"
+#endif
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static char log_ring[CCM_LOG_RING_SIZE];
+static volatile uint32_t log_ring_head;
+static volatile uint32_t log_ring_tail;
+
+static uint32_t log_high_water;
+
+static volatile uint32_t log_dropped;
+static volatile uint32_t log_dropped_reported;
+
+static uint8_t log_level = CCM_LOG_LEVEL;
+
+/* Set while a context writes to the debug UART, the other ones skip draining */
+static bool log_draining;
+
+/*******************************************************************************
+ * Function Name: ccm_log_data
+ *******************************************************************************
+ * Summary:
+ *  Append raw bytes to the log ring, for example a message payload. Dropped
+ *  as a whole if the ring has no room.
+ *
+ * input parameter: uint8_t level
+ *                  CCM_LOG_xxx
+ *
+ * input parameter: const void *data
+ *                  Bytes to log
+ *
+ * input parameter: uint32_t length
+ *                  Number of bytes
+ *
+ *******************************************************************************/
+void ccm_log_data(uint8_t level, const void *data, uint32_t length)
+{
+    const char *bytes = (const char *)data;
+
+    if ((level > log_level) || (length == 0))
+    {
+        return;
+    }
+
+    uint32_t state = ccm_hal_critical_section_enter();
+    uint32_t head = log_ring_head;
+    uint32_t used = (head - log_ring_tail) & LOG_RING_MASK;
+
+    /* One byte stays free to tell a full ring from an empty one */
+    if ((used + length) >= CCM_LOG_RING_SIZE)
+    {
+        log_dropped++;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < length; i++)
+        {
+            log_ring[(head + i) & LOG_RING_MASK] = bytes[i];
+        }
+        log_ring_head = (head + length) & LOG_RING_MASK;
+
+        if ((used + length) > log_high_water)
+        {
+            log_high_water = used + length;
+        }
+    }
+
+    ccm_hal_critical_section_exit(state);
+
+#if CCM_RTOS
+    ccm_rtos_log_notify();
+#endif /* CCM_RTOS */
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_write
+ *******************************************************************************
+ * Summary:
+ *  Format a message into the log ring, printf style. Use the CCM_LOG() macro to
+ *  compile out the messages above CCM_LOG_LEVEL.
+ *
+ *******************************************************************************/
+void ccm_log_write(uint8_t level, const char *format, ...)
+{
+    char line[CCM_LOG_LINE_SIZE];
+    va_list args;
+
+    if (level > log_level)
+    {
+        return;
+    }
+
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length > 0)
+    {
+        ccm_log_data(level, line, ((uint32_t)length < sizeof(line)) ? (uint32_t)length : (sizeof(line) - 1));
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_drain
+ *******************************************************************************
+ * Summary:
+ *  Write up to max_bytes of the log ring to the debug UART, without waiting
+ *  for it: stops once its TX FIFO is full. Call from the lowest priority
+ *  context only; returns at once if another context is already draining.
+ *
+ * Return:
+ *  uint32_t - number of bytes written.
+ *
+ *******************************************************************************/
+uint32_t ccm_log_drain(uint32_t max_bytes)
+{
+    uint32_t written = 0;
+
+    uint32_t state = ccm_hal_critical_section_enter();
+    bool busy = log_draining;
+    log_draining = true;
+    ccm_hal_critical_section_exit(state);
+
+    if (busy)
+    {
+        return 0;
+    }
+
+    if (log_dropped != log_dropped_reported)
+    {
+        uint32_t dropped = log_dropped;
+        uint32_t count = dropped - log_dropped_reported;
+
+        /* Queued behind the messages written before the loss */
+        log_dropped_reported = dropped;
+        ccm_log_write(CCM_LOG_ERROR, "\n\r[%lu log messages dropped]\n\r", (unsigned long)count);
+    }
+
+    while (written < max_bytes)
+    {
+        uint32_t head = log_ring_head;
+        uint32_t tail = log_ring_tail;
+
+        if (head == tail)
+        {
+            break;
+        }
+
+        /* Contiguous part of the ring */
+        uint32_t length = ((head > tail) ? head : CCM_LOG_RING_SIZE) - tail;
+        if (length > (max_bytes - written))
+        {
+            length = max_bytes - written;
+        }
+
+        /* Only what fits into the debug UART TX FIFO, the rest waits for the next call */
+        length = ccm_hal_debug_write(&log_ring[tail], length);
+
+        log_ring_tail = (tail + length) & LOG_RING_MASK;
+        written += length;
+
+        if (length == 0)
+        {
+            break;
+        }
+    }
+
+    log_draining = false;
+
+    return written;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_flush
+ *******************************************************************************
+ * Summary:
+ *  Write the whole log ring to the debug UART, before a reset or deep sleep.
+ *  Waits for the debug UART; another task gets the CPU meanwhile.
+ *
+ *******************************************************************************/
+void ccm_log_flush(void)
+{
+    while (log_ring_head != log_ring_tail)
+    {
+        if (ccm_log_drain(CCM_LOG_RING_SIZE) > 0)
+        {
+            continue;
+        }
+
+#if CCM_RTOS
+        if ((xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) && !xPortIsInsideInterrupt())
+        {
+            vTaskDelay(1);
+        }
+#endif /* CCM_RTOS */
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_set_level
+ *******************************************************************************
+ * Summary:
+ *  Change the log level at run time. Levels above CCM_LOG_LEVEL are compiled
+ *  out, a higher level is clamped to it.
+ *
+ *******************************************************************************/
+void ccm_log_set_level(uint8_t level)
+{
+    log_level = (level > CCM_LOG_LEVEL) ? CCM_LOG_LEVEL : level;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_get_level
+ *******************************************************************************
+ * Summary:
+ *  Current log level.
+ *
+ *******************************************************************************/
+uint8_t ccm_log_get_level(void)
+{
+    return log_level;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_dropped
+ *******************************************************************************
+ * Summary:
+ *  Number of messages dropped because the log ring was full.
+ *
+ *******************************************************************************/
+uint32_t ccm_log_dropped(void)
+{
+    return log_dropped;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_log_high_water
+ *******************************************************************************
+ * Summary:
+ *  Most bytes waiting in the log ring at the same time.
+ *
+ *******************************************************************************/
+uint32_t ccm_log_high_water(void)
+{
+    return log_high_water;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,77 @@
+/******************************************************************************
+ * File Name: ccm_log.h
+ *
+ * Description: This file is the public interface of ccm_log.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_LOG_H_
+#define CCM_LOG_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Log levels, a message is kept if its level is at most the current level */
+#define CCM_LOG_ERROR (0u)
+#define CCM_LOG_WARN  (1u)
+#define CCM_LOG_INFO  (2u)
+#define CCM_LOG_DEBUG (3u) /* AT commands and responses */
+#define CCM_LOG_TRACE (4u) /* periodic probes and event polling */
+
+/* Messages above this level are compiled out */
+#ifndef CCM_LOG_LEVEL
+#define CCM_LOG_LEVEL CCM_LOG_DEBUG
+#endif
+
+/* Log ring size in bytes, must be a power of two */
+#ifndef CCM_LOG_RING_SIZE
+#define CCM_LOG_RING_SIZE (2048u)
+#endif
+
+/* Longest formatted message, longer ones are truncated */
+#ifndef CCM_LOG_LINE_SIZE
+#define CCM_LOG_LINE_SIZE (128u)
+#endif
+
+/* Most bytes written to the debug UART by one ccm_log_drain() call from the
+ * idle loop, less if its TX FIFO is full */
+#ifndef CCM_LOG_DRAIN_CHUNK
+#define CCM_LOG_DRAIN_CHUNK (64u)
+#endif
+
+#define CCM_LOG(level, ...)                    \
+    do                                         \
+    {                                          \
+        if ((level) <= CCM_LOG_LEVEL)          \
+        {                                      \
+            ccm_log_write((level), __VA_ARGS__); \
+        }                                      \
+    } while (0)
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_log_write(uint8_t level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+void ccm_log_data(uint8_t level, const void *data, uint32_t length);
+
+uint32_t ccm_log_drain(uint32_t max_bytes);
+
+void ccm_log_flush(void);
+
+void ccm_log_set_level(uint8_t level);
+
+uint8_t ccm_log_get_level(void);
+
+uint32_t ccm_log_dropped(void);
+
+uint32_t ccm_log_high_water(void);
+
+#endif /* CCM_LOG_H_ */
@@ -0,0 +1,251 @@
+/******************************************************************************
+ * File Name: ccm_ota.c
+ *
+ * Description: OTA update state machine of the CCM module. The OTA events
+ * only move the state; the AT+OTA commands are sent from ccm_ota_process(),
+ * called by the application between event drains, so the handling of the
+ * MSG events goes on while the CCM module downloads the image. A policy hook
+ * decides when the download is accepted and when the image is applied, which
+ * restarts the CCM module and with it the host.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_ota.h"
+#include "ccm_event.h"
+#include "ccm_log.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static const char *const ota_state_names[] = {
+    [CCM_OTA_IDLE] = "idle",
+    [CCM_OTA_AVAILABLE] = "new firmware available",
+    [CCM_OTA_DOWNLOADING] = "downloading",
+    [CCM_OTA_VERIFIED] = "new firmware image verified",
+    [CCM_OTA_APPLYING] = "applying, the CCM module restarts",
+};
+
+static ccm_ota_state_t ota_state = CCM_OTA_IDLE;
+static uint32_t ota_state_start;
+static uint32_t ota_activity;   /* last OTA event, ms */
+static uint32_t ota_wait_until; /* next policy check or command retry, ms */
+static uint8_t ota_last_event;
+static uint32_t ota_deferrals;
+static uint32_t ota_failures;
+static uint32_t ota_updates;
+
+static ccm_ota_policy_t ota_policy;
+static void *ota_policy_arg;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void ota_event_handler(ccm_response_t *event);
+static void set_state(ccm_ota_state_t state);
+static bool action_allowed(ccm_ota_action_t action, uint32_t now);
+
+/*******************************************************************************
+ * Function Name: ccm_ota_init
+ *******************************************************************************
+ * Summary:
+ *  Register the handler of the OTA events.
+ *
+ * input parameter: ccm_ota_policy_t policy
+ *                  Decides when the image is downloaded and applied, NULL to
+ *                  do both as soon as possible
+ *
+ * input parameter: void *policy_arg
+ *                  Passed to the policy
+ *
+ *******************************************************************************/
+void ccm_ota_init(ccm_ota_policy_t policy, void *policy_arg)
+{
+    ota_policy = policy;
+    ota_policy_arg = policy_arg;
+    ota_state = CCM_OTA_IDLE;
+    ota_state_start = ccm_get_time_ms();
+
+    ccm_event_register(CCM_EVENT_OTA, CCM_EVENT_ID_ANY, ota_event_handler);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_ota_process
+ *******************************************************************************
+ * Summary:
+ *  Send the AT+OTA command of the current state once the policy allows it,
+ *  and give the download or the apply up if it stalls. Call when no event is
+ *  pending.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of the AT+OTA commands in milliseconds
+ *
+ * Return:
+ *  uint32_t - milliseconds until the next call is needed, CCM_OTA_WAIT_FOREVER
+ *             if only an OTA event can change the state.
+ *
+ *******************************************************************************/
+uint32_t ccm_ota_process(uint32_t delay)
+{
+    uint32_t now = ccm_get_time_ms();
+    int32_t wait = (int32_t)(ota_wait_until - now);
+    ccm_ota_action_t action = CCM_OTA_ACTION_DOWNLOAD;
+    ccm_command_id_t command = CCM_CMD_OTA_ACCEPT;
+    ccm_ota_state_t next = CCM_OTA_DOWNLOADING;
+    int result = 0;
+
+    switch (ota_state)
+    {
+    case CCM_OTA_AVAILABLE:
+        break;
+
+    case CCM_OTA_VERIFIED:
+        action = CCM_OTA_ACTION_APPLY;
+        command = CCM_CMD_OTA_APPLY;
+        next = CCM_OTA_APPLYING;
+        break;
+
+    case CCM_OTA_DOWNLOADING:
+        if ((now - ota_activity) >= CCM_OTA_DOWNLOAD_TIMEOUT)
+        {
+            CCM_LOG(CCM_LOG_WARN, "\nOTA download timed out\n\r");
+            ota_failures++;
+            set_state(CCM_OTA_IDLE);
+            return CCM_OTA_WAIT_FOREVER;
+        }
+        return CCM_OTA_DOWNLOAD_TIMEOUT - (now - ota_activity);
+
+    case CCM_OTA_APPLYING:
+        /* The STARTUP event of the restarted module resets the host, without
+         * it the next AVAILABLE event must be accepted again */
+        if ((now - ota_activity) >= CCM_OTA_APPLY_TIMEOUT)
+        {
+            CCM_LOG(CCM_LOG_WARN, "\nOTA apply timed out, the CCM module did not restart\n\r");
+            ota_failures++;
+            set_state(CCM_OTA_IDLE);
+            return CCM_OTA_WAIT_FOREVER;
+        }
+        return CCM_OTA_APPLY_TIMEOUT - (now - ota_activity);
+
+    default:
+        return CCM_OTA_WAIT_FOREVER;
+    }
+
+    if (wait > 0)
+    {
+        return (uint32_t)wait;
+    }
+
+    if (!action_allowed(action, now))
+    {
+        ota_deferrals++;
+        ota_wait_until = now + CCM_OTA_POLICY_INTERVAL;
+        CCM_LOG(CCM_LOG_DEBUG, "\rOTA %s deferred\n", (action == CCM_OTA_ACTION_APPLY) ? "apply" : "download");
+        return CCM_OTA_POLICY_INTERVAL;
+    }
+
+    ccm_response_release(at_command_execute(command, delay, &result));
+
+    if (result)
+    {
+        set_state(next);
+        return ccm_ota_process(delay);
+    }
+
+    /* Rejected or timed out, retry unless a new event changed the state */
+    CCM_LOG(CCM_LOG_WARN, "\nOTA command failed, retrying in %u ms\n\r", (unsigned)CCM_OTA_POLICY_INTERVAL);
+    ota_failures++;
+    ota_wait_until = now + CCM_OTA_POLICY_INTERVAL;
+
+    return CCM_OTA_POLICY_INTERVAL;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_ota_get_state
+ *******************************************************************************
+ * Summary:
+ *  Current OTA state.
+ *
+ *******************************************************************************/
+ccm_ota_state_t ccm_ota_get_state(void)
+{
+    return ota_state;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_ota_get_status
+ *******************************************************************************
+ * Summary:
+ *  Progress of the OTA update and counters since boot.
+ *
+ *******************************************************************************/
+void ccm_ota_get_status(ccm_ota_status_t *status)
+{
+    status->state = ota_state;
+    status->last_event = ota_last_event;
+    status->state_time = ccm_get_time_ms() - ota_state_start;
+    status->deferrals = ota_deferrals;
+    status->failures = ota_failures;
+    status->updates = ota_updates;
+}
+
+/*******************************************************************************
+ * Function Name: ota_event_handler
+ *******************************************************************************
+ * Summary:
+ *  OTA events: AVAILABLE and VERIFIED move the state, the other ids report
+ *  the download progress. Never sends an AT command, the event drain goes on.
+ *
+ *******************************************************************************/
+static void ota_event_handler(ccm_response_t *event)
+{
+    ota_last_event = event->event_id;
+    ota_activity = ccm_get_time_ms();
+
+    if (event->event_id == CCM_EVENT_OTA_AVAILABLE)
+    {
+        /* Repeated while the update is pending, which keeps its deferral time */
+        if (ota_state == CCM_OTA_IDLE)
+        {
+            set_state(CCM_OTA_AVAILABLE);
+        }
+    }
+    else if (event->event_id == CCM_EVENT_OTA_VERIFIED)
+    {
+        set_state(CCM_OTA_VERIFIED);
+    }
+    else
+    {
+        CCM_LOG(CCM_LOG_INFO, "\nOTA progress: event %u, %s\n\r", event->event_id, ota_state_names[ota_state]);
+    }
+}
+
+static void set_state(ccm_ota_state_t state)
+{
+    if (state == CCM_OTA_APPLYING)
+    {
+        ota_updates++;
+    }
+
+    ota_state = state;
+    ota_state_start = ccm_get_time_ms();
+    ota_activity = ota_state_start;
+    ota_wait_until = ota_state_start;
+
+    CCM_LOG(CCM_LOG_INFO, "\nOTA: %s\n\n\r", ota_state_names[state]);
+}
+
+/* The policy may defer an action for up to CCM_OTA_MAX_DEFERRAL */
+static bool action_allowed(ccm_ota_action_t action, uint32_t now)
+{
+    if ((ota_policy == NULL) || ota_policy(action, ota_policy_arg))
+    {
+        return true;
+    }
+
+    return (CCM_OTA_MAX_DEFERRAL > 0) && ((now - ota_state_start) >= CCM_OTA_MAX_DEFERRAL);
+}
+
+/* [] END OF FILE */
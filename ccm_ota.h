@@ -0,0 +1,89 @@
+/******************************************************************************
+ * File Name: ccm_ota.h
+ *
+ * Description: This file is the public interface of ccm_ota.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_OTA_H_
+#define CCM_OTA_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Interval at which an action deferred by the policy is asked again, ms */
+#ifndef CCM_OTA_POLICY_INTERVAL
+#define CCM_OTA_POLICY_INTERVAL (10000u)
+#endif
+
+/* Longest deferral of an action by the policy before it runs anyway, ms.
+ * 0 lets the policy defer forever. */
+#ifndef CCM_OTA_MAX_DEFERRAL
+#define CCM_OTA_MAX_DEFERRAL (24u * 3600u * 1000u)
+#endif
+
+/* Download given up if the image is not verified within this time, ms */
+#ifndef CCM_OTA_DOWNLOAD_TIMEOUT
+#define CCM_OTA_DOWNLOAD_TIMEOUT (30u * 60u * 1000u)
+#endif
+
+/* Apply given up if the STARTUP event of the restarted CCM module does not
+ * come within this time after AT+OTA APPLY was accepted, ms */
+#ifndef CCM_OTA_APPLY_TIMEOUT
+#define CCM_OTA_APPLY_TIMEOUT (5u * 60u * 1000u)
+#endif
+
+/* ccm_ota_process() has nothing to do until the next OTA event */
+#define CCM_OTA_WAIT_FOREVER (0xFFFFFFFFu)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef enum
+{
+    CCM_OTA_IDLE = 0,    /* no update offered */
+    CCM_OTA_AVAILABLE,   /* update offered, AT+OTA ACCEPT not sent yet */
+    CCM_OTA_DOWNLOADING, /* accepted, the CCM module downloads the image */
+    CCM_OTA_VERIFIED,    /* image verified, AT+OTA APPLY not sent yet */
+    CCM_OTA_APPLYING     /* applied, the CCM module restarts */
+} ccm_ota_state_t;
+
+/* Actions the policy is asked for */
+typedef enum
+{
+    CCM_OTA_ACTION_DOWNLOAD = 0, /* AT+OTA ACCEPT */
+    CCM_OTA_ACTION_APPLY         /* AT+OTA APPLY, restarts the CCM module */
+} ccm_ota_action_t;
+
+/* Return false to defer the action, it is asked again after
+ * CCM_OTA_POLICY_INTERVAL. Called from ccm_ota_process(). */
+typedef bool (*ccm_ota_policy_t)(ccm_ota_action_t action, void *arg);
+
+typedef struct
+{
+    ccm_ota_state_t state;
+    uint8_t last_event;  /* id of the last OTA event */
+    uint32_t state_time; /* time spent in the current state, ms */
+    uint32_t deferrals;  /* actions deferred by the policy */
+    uint32_t failures;   /* rejected commands, download and apply timeouts */
+    uint32_t updates;    /* AT+OTA APPLY accepted */
+} ccm_ota_status_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_ota_init(ccm_ota_policy_t policy, void *policy_arg);
+
+uint32_t ccm_ota_process(uint32_t delay);
+
+ccm_ota_state_t ccm_ota_get_state(void);
+
+void ccm_ota_get_status(ccm_ota_status_t *status);
+
+#endif /* CCM_OTA_H_ */
@@ -0,0 +1,731 @@
+/******************************************************************************
+ * File Name: ccm_parser.c
+ *
+ * Description: Incremental parser of the message payloads. It is fed the
+ * chunks of a message as they are received (see ccm_subscription.h) and
+ * passes every field to a callback, so a configuration document is applied
+ * without buffering the whole message. No memory is allocated, the state is
+ * a ccm_parser_t of the caller.
+ *
+ * Two formats are accepted, told apart by the first character:
+ *  - JSON: objects, arrays, strings (with the escape sequences, \uXXXX to
+ *    UTF-8, surrogate pairs are not combined), numbers, true, false, null.
+ *    Only the fields with a scalar value are passed, with their path as key:
+ *    {"led":{"on":true},"rates":[1,2]} gives led.on, rates[0] and rates[1].
+ *  - key=value pairs, each ended by '\n', '\r', ';' or '&'. Every value is
+ *    passed as a string. A document cut off in a value is not complete, its
+ *    last value is not passed: end a message with ';' or '&', the '\n' of
+ *    the AT+GET response is not part of the payload.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_parser.h"
+#include "ccm_log.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Parser states */
+enum
+{
+    PARSE_START = 0,
+    PARSE_DONE,
+    PARSE_ERROR,
+    J_KEY_START,   /* '"' of a key or '}' */
+    J_KEY,
+    J_COLON,
+    J_VALUE,
+    J_STRING,
+    J_ESCAPE,
+    J_UNICODE,
+    J_LITERAL,     /* number, true, false or null */
+    J_AFTER_VALUE, /* ',' or the end of the object or array */
+    K_KEY,
+    K_VALUE
+};
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static bool step(ccm_parser_t *parser, char c);
+static bool parse_json(ccm_parser_t *parser, char c);
+static bool parse_key_value(ccm_parser_t *parser, char c);
+static void string_append(ccm_parser_t *parser, char c);
+static void unicode_append(ccm_parser_t *parser, uint16_t code);
+static void value_append(ccm_parser_t *parser, char c);
+static bool path_append(ccm_parser_t *parser, char c);
+static void path_set_index(ccm_parser_t *parser);
+static bool push(ccm_parser_t *parser, bool array);
+static void pop(ccm_parser_t *parser);
+static bool emit_literal(ccm_parser_t *parser);
+static void emit(ccm_parser_t *parser, ccm_field_type_t type, bool partial);
+static void reset(ccm_parser_t *parser);
+
+static inline bool is_space(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+static inline bool is_separator(char c)
+{
+    return (c == '\n') || (c == '\r') || (c == ';') || (c == '&');
+}
+
+static inline bool is_literal(char c)
+{
+    return ((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || (c == '-') || (c == '+') ||
+           (c == '.') || (c == 'E');
+}
+
+/*******************************************************************************
+ * Function Name: ccm_parser_init
+ *******************************************************************************
+ * Summary:
+ *  Prepare a parser for the first document.
+ *
+ * input parameter: ccm_parser_t *parser
+ *                  Parser state, one per stream parsed at the same time
+ *
+ * input parameter: ccm_field_handler_t handler
+ *                  Called for every field while the document is fed
+ *
+ * input parameter: void *arg
+ *                  Passed to the handler unchanged
+ *
+ *******************************************************************************/
+void ccm_parser_init(ccm_parser_t *parser, ccm_field_handler_t handler, void *arg)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->handler = handler;
+    parser->arg = arg;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_parser_feed
+ *******************************************************************************
+ * Summary:
+ *  Parse the next bytes of a document, the fields complete in them are passed
+ *  to the handler before it returns. The bytes after a parse error are
+ *  ignored until ccm_parser_finish().
+ *
+ * Return:
+ *  bool - false once the document has a parse error.
+ *
+ *******************************************************************************/
+bool ccm_parser_feed(ccm_parser_t *parser, const uint8_t *data, uint16_t length)
+{
+    for (uint16_t i = 0; (i < length) && (parser->state != PARSE_ERROR); i++)
+    {
+        /* A character ending a literal or a key is parsed again in the next state */
+        while (!step(parser, (char)data[i]))
+        {
+        }
+    }
+
+    return (parser->state != PARSE_ERROR);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_parser_finish
+ *******************************************************************************
+ * Summary:
+ *  End of the document, get ready for the next document. Complete means a
+ *  closed JSON value, or key=value pairs ending with a separator.
+ *
+ * Return:
+ *  bool - false if the document had a parse error or was not complete, the
+ *         fields passed before are not taken back.
+ *
+ *******************************************************************************/
+bool ccm_parser_finish(ccm_parser_t *parser)
+{
+    bool complete = false;
+
+    switch (parser->state)
+    {
+    case K_KEY:
+        complete = (parser->path_length == 0);
+        break;
+
+    case PARSE_START:
+    case PARSE_DONE:
+        complete = true;
+        break;
+
+    default:
+        break;
+    }
+
+    reset(parser);
+
+    return complete;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_parser_subscription_handler
+ *******************************************************************************
+ * Summary:
+ *  ccm_subscription_handler_t feeding a streamed topic slot to the parser
+ *  passed as arg, every message is a document. The fields of an incomplete
+ *  message are passed already, it is reported and the parser reset.
+ *
+ *******************************************************************************/
+void ccm_parser_subscription_handler(uint8_t index, const uint8_t *data, uint16_t length, bool last, bool ok,
+                                     void *arg)
+{
+    ccm_parser_t *parser = (ccm_parser_t *)arg;
+
+    if (length > 0)
+    {
+        ccm_parser_feed(parser, data, length);
+    }
+
+    if (!last)
+    {
+        return;
+    }
+
+    if (!ccm_parser_finish(parser) && ok)
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nMessage of topic %u is not a valid document\n\r", index);
+    }
+
+    if (!ok)
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nMessage of topic %u incomplete\n\r", index);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_field_get_int
+ *******************************************************************************
+ * Summary:
+ *  Value of a field as an integer.
+ *
+ * Return:
+ *  bool - false if the value is not a complete decimal integer in range.
+ *
+ *******************************************************************************/
+bool ccm_field_get_int(const ccm_field_t *field, int32_t *value)
+{
+    char *end = NULL;
+
+    if (field->partial || (field->length == 0))
+    {
+        return false;
+    }
+
+    long number = strtol(field->value, &end, 10);
+
+    if ((*end != '\0') || (number < INT32_MIN) || (number > INT32_MAX))
+    {
+        return false;
+    }
+
+    *value = (int32_t)number;
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_field_get_bool
+ *******************************************************************************
+ * Summary:
+ *  Value of a field as a boolean: true/false, or 1/0 for the key=value form.
+ *
+ * Return:
+ *  bool - false if the value is none of them.
+ *
+ *******************************************************************************/
+bool ccm_field_get_bool(const ccm_field_t *field, bool *value)
+{
+    if (!strcmp(field->value, "true") || !strcmp(field->value, "1"))
+    {
+        *value = true;
+        return true;
+    }
+
+    if (!strcmp(field->value, "false") || !strcmp(field->value, "0"))
+    {
+        *value = false;
+        return true;
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: step
+ *******************************************************************************
+ * Summary:
+ *  Parse one character.
+ *
+ * Return:
+ *  bool - false if the character must be parsed again, in the new state.
+ *
+ *******************************************************************************/
+static bool step(ccm_parser_t *parser, char c)
+{
+    switch (parser->state)
+    {
+    case PARSE_START:
+        if (is_space(c))
+        {
+            return true;
+        }
+
+        if (c == '{')
+        {
+            if (push(parser, false))
+            {
+                parser->state = J_KEY_START;
+            }
+            return true;
+        }
+
+        parser->state = K_KEY;
+        return false;
+
+    case PARSE_DONE:
+        if (!is_space(c))
+        {
+            /* Trailing characters after the document */
+            parser->state = PARSE_ERROR;
+        }
+        return true;
+
+    case PARSE_ERROR:
+        return true;
+
+    case K_KEY:
+    case K_VALUE:
+        return parse_key_value(parser, c);
+
+    default:
+        return parse_json(parser, c);
+    }
+}
+
+/* JSON states, see step() */
+static bool parse_json(ccm_parser_t *parser, char c)
+{
+    switch (parser->state)
+    {
+    case J_KEY_START:
+        if (c == '"')
+        {
+            parser->path_length = parser->stack[parser->depth - 1].path_length;
+            if ((parser->path_length > 0) && !path_append(parser, '.'))
+            {
+                return true;
+            }
+            parser->string_state = J_KEY;
+            parser->state = J_KEY;
+        }
+        else if ((c == '}') && (parser->stack[parser->depth - 1].index == 0))
+        {
+            /* Empty object, a '}' after a ',' is a trailing comma */
+            pop(parser);
+        }
+        else if (!is_space(c))
+        {
+            parser->state = PARSE_ERROR;
+        }
+        return true;
+
+    case J_KEY:
+    case J_STRING:
+        if (c == '"')
+        {
+            if (parser->state == J_STRING)
+            {
+                emit(parser, CCM_FIELD_STRING, false);
+                parser->state = J_AFTER_VALUE;
+            }
+            else
+            {
+                parser->state = J_COLON;
+            }
+        }
+        else if (c == '\\')
+        {
+            parser->state = J_ESCAPE;
+        }
+        else if ((uint8_t)c < 0x20u)
+        {
+            parser->state = PARSE_ERROR;
+        }
+        else
+        {
+            string_append(parser, c);
+        }
+        return true;
+
+    case J_ESCAPE:
+        parser->state = parser->string_state;
+        switch (c)
+        {
+        case 'b':
+            string_append(parser, '\b');
+            break;
+        case 'f':
+            string_append(parser, '\f');
+            break;
+        case 'n':
+            string_append(parser, '\n');
+            break;
+        case 'r':
+            string_append(parser, '\r');
+            break;
+        case 't':
+            string_append(parser, '\t');
+            break;
+        case 'u':
+            parser->unicode = 0;
+            parser->unicode_digits = 0;
+            parser->state = J_UNICODE;
+            break;
+        default:
+            /* \" \\ \/ */
+            string_append(parser, c);
+            break;
+        }
+        return true;
+
+    case J_UNICODE:
+    {
+        uint8_t digit;
+
+        if ((c >= '0') && (c <= '9'))
+        {
+            digit = c - '0';
+        }
+        else if (((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+        {
+            digit = (c | 0x20) - 'a' + 10;
+        }
+        else
+        {
+            parser->state = PARSE_ERROR;
+            return true;
+        }
+
+        parser->unicode = (parser->unicode << 4) | digit;
+        if (++parser->unicode_digits == 4)
+        {
+            parser->state = parser->string_state;
+            unicode_append(parser, parser->unicode);
+        }
+        return true;
+    }
+
+    case J_COLON:
+        if (c == ':')
+        {
+            parser->state = J_VALUE;
+        }
+        else if (!is_space(c))
+        {
+            parser->state = PARSE_ERROR;
+        }
+        return true;
+
+    case J_VALUE:
+        if (is_space(c))
+        {
+            return true;
+        }
+
+        parser->value_length = 0;
+
+        if (c == '"')
+        {
+            parser->string_state = J_STRING;
+            parser->state = J_STRING;
+        }
+        else if (c == '{')
+        {
+            if (push(parser, false))
+            {
+                parser->state = J_KEY_START;
+            }
+        }
+        else if (c == '[')
+        {
+            if (push(parser, true))
+            {
+                parser->state = J_VALUE;
+            }
+        }
+        else if ((c == ']') && parser->stack[parser->depth - 1].array && (parser->stack[parser->depth - 1].index == 0))
+        {
+            /* Empty array, a ']' after a ',' is a trailing comma */
+            pop(parser);
+        }
+        else if (is_literal(c))
+        {
+            parser->state = J_LITERAL;
+            return false;
+        }
+        else
+        {
+            parser->state = PARSE_ERROR;
+        }
+        return true;
+
+    case J_LITERAL:
+        if (is_literal(c))
+        {
+            if (parser->value_length == CCM_PARSER_VALUE_MAX)
+            {
+                parser->state = PARSE_ERROR;
+                return true;
+            }
+            parser->value[parser->value_length++] = c;
+            return true;
+        }
+
+        if (emit_literal(parser))
+        {
+            parser->state = J_AFTER_VALUE;
+        }
+        return false;
+
+    case J_AFTER_VALUE:
+        if (is_space(c))
+        {
+            return true;
+        }
+
+        if (c == ',')
+        {
+            parser->stack[parser->depth - 1].index++;
+
+            if (parser->stack[parser->depth - 1].array)
+            {
+                path_set_index(parser);
+                parser->state = J_VALUE;
+            }
+            else
+            {
+                parser->state = J_KEY_START;
+            }
+        }
+        else if ((c == '}') && !parser->stack[parser->depth - 1].array)
+        {
+            pop(parser);
+        }
+        else if ((c == ']') && parser->stack[parser->depth - 1].array)
+        {
+            pop(parser);
+        }
+        else
+        {
+            parser->state = PARSE_ERROR;
+        }
+        return true;
+
+    default:
+        parser->state = PARSE_ERROR;
+        return true;
+    }
+}
+
+/* key=value states, see step() */
+static bool parse_key_value(ccm_parser_t *parser, char c)
+{
+    if (parser->state == K_VALUE)
+    {
+        if (is_separator(c))
+        {
+            emit(parser, CCM_FIELD_STRING, false);
+            parser->path_length = 0;
+            parser->state = K_KEY;
+        }
+        else
+        {
+            value_append(parser, c);
+        }
+        return true;
+    }
+
+    if (c == '=')
+    {
+        parser->value_length = 0;
+        parser->state = (parser->path_length > 0) ? K_VALUE : PARSE_ERROR;
+    }
+    else if (is_separator(c))
+    {
+        /* Empty line, or a key without value */
+        parser->state = (parser->path_length == 0) ? K_KEY : PARSE_ERROR;
+    }
+    else if (!(((c == ' ') || (c == '\t')) && (parser->path_length == 0)))
+    {
+        path_append(parser, c);
+    }
+    return true;
+}
+
+/* Character of a key or a string value, from the string or an escape sequence */
+static void string_append(ccm_parser_t *parser, char c)
+{
+    if (parser->string_state == J_KEY)
+    {
+        path_append(parser, c);
+    }
+    else
+    {
+        value_append(parser, c);
+    }
+}
+
+/* UTF-8 encoding of a \uXXXX escape sequence */
+static void unicode_append(ccm_parser_t *parser, uint16_t code)
+{
+    if (code < 0x80u)
+    {
+        string_append(parser, (char)code);
+    }
+    else if (code < 0x800u)
+    {
+        string_append(parser, (char)(0xC0u | (code >> 6)));
+        string_append(parser, (char)(0x80u | (code & 0x3Fu)));
+    }
+    else
+    {
+        string_append(parser, (char)(0xE0u | (code >> 12)));
+        string_append(parser, (char)(0x80u | ((code >> 6) & 0x3Fu)));
+        string_append(parser, (char)(0x80u | (code & 0x3Fu)));
+    }
+}
+
+/* A full value buffer is passed as a piece of the value */
+static void value_append(ccm_parser_t *parser, char c)
+{
+    if (parser->value_length == CCM_PARSER_VALUE_MAX)
+    {
+        emit(parser, CCM_FIELD_STRING, true);
+    }
+
+    parser->value[parser->value_length++] = c;
+}
+
+static bool path_append(ccm_parser_t *parser, char c)
+{
+    if (parser->path_length == CCM_PARSER_PATH_MAX)
+    {
+        parser->state = PARSE_ERROR;
+        return false;
+    }
+
+    parser->path[parser->path_length++] = c;
+    return true;
+}
+
+/* Path of the next element of the innermost array: <array path>[<index>] */
+static void path_set_index(ccm_parser_t *parser)
+{
+    char index[8];
+    int length = snprintf(index, sizeof(index), "[%u]", parser->stack[parser->depth - 1].index);
+
+    parser->path_length = parser->stack[parser->depth - 1].path_length;
+
+    for (int i = 0; (i < length) && path_append(parser, index[i]); i++)
+    {
+    }
+}
+
+static bool push(ccm_parser_t *parser, bool array)
+{
+    if (parser->depth == CCM_PARSER_DEPTH)
+    {
+        parser->state = PARSE_ERROR;
+        return false;
+    }
+
+    parser->stack[parser->depth].path_length = parser->path_length;
+    parser->stack[parser->depth].index = 0;
+    parser->stack[parser->depth].array = array;
+    parser->depth++;
+
+    if (array)
+    {
+        path_set_index(parser);
+    }
+
+    return true;
+}
+
+/* End of the innermost object or array, the document ends with the outermost */
+static void pop(ccm_parser_t *parser)
+{
+    parser->depth--;
+    parser->path_length = parser->stack[parser->depth].path_length;
+    parser->state = (parser->depth == 0) ? PARSE_DONE : J_AFTER_VALUE;
+}
+
+/* A number, true, false or null, anything else is a parse error */
+static bool emit_literal(ccm_parser_t *parser)
+{
+    ccm_field_type_t type = CCM_FIELD_NUMBER;
+
+    parser->value[parser->value_length] = '\0';
+
+    if (!strcmp(parser->value, "true") || !strcmp(parser->value, "false"))
+    {
+        type = CCM_FIELD_BOOL;
+    }
+    else if (!strcmp(parser->value, "null"))
+    {
+        type = CCM_FIELD_NULL;
+    }
+    else if ((parser->value[0] != '-') && ((parser->value[0] < '0') || (parser->value[0] > '9')))
+    {
+        parser->state = PARSE_ERROR;
+        return false;
+    }
+
+    emit(parser, type, false);
+    return true;
+}
+
+static void emit(ccm_parser_t *parser, ccm_field_type_t type, bool partial)
+{
+    ccm_field_t field = {
+        .key = parser->path,
+        .value = parser->value,
+        .length = parser->value_length,
+        .type = type,
+        .partial = partial};
+
+    parser->path[parser->path_length] = '\0';
+    parser->value[parser->value_length] = '\0';
+
+    if (parser->handler)
+    {
+        parser->handler(&field, parser->arg);
+    }
+
+    parser->value_length = 0;
+
+    if (!partial)
+    {
+        parser->fields++;
+    }
+}
+
+/* Ready for the next document, the handler and the counters are kept */
+static void reset(ccm_parser_t *parser)
+{
+    parser->state = PARSE_START;
+    parser->depth = 0;
+    parser->path_length = 0;
+    parser->value_length = 0;
+}
+
+/* [] END OF FILE */
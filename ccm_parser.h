@@ -0,0 +1,99 @@
+/******************************************************************************
+ * File Name: ccm_parser.h
+ *
+ * Description: This file is the public interface of ccm_parser.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_PARSER_H_
+#define CCM_PARSER_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Deepest nesting of JSON objects and arrays */
+#ifndef CCM_PARSER_DEPTH
+#define CCM_PARSER_DEPTH (4u)
+#endif
+
+/* Longest field path ("a.b[2].c"), a longer path is a parse error */
+#ifndef CCM_PARSER_PATH_MAX
+#define CCM_PARSER_PATH_MAX (63u)
+#endif
+
+/* Longest value passed at once, a longer string is passed in pieces */
+#ifndef CCM_PARSER_VALUE_MAX
+#define CCM_PARSER_VALUE_MAX (63u)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef enum
+{
+    CCM_FIELD_STRING = 0, /* JSON string, or any value of the key=value form */
+    CCM_FIELD_NUMBER,
+    CCM_FIELD_BOOL,
+    CCM_FIELD_NULL
+} ccm_field_type_t;
+
+/* A field, key and value are '\0' terminated and only valid during the call */
+typedef struct
+{
+    const char *key;   /* path of the field: members joined by '.', array elements as [n] */
+    const char *value; /* value as received, strings unescaped */
+    uint16_t length;   /* characters in value */
+    ccm_field_type_t type;
+    bool partial;      /* a piece of a long string, more pieces of the same field follow */
+} ccm_field_t;
+
+typedef void (*ccm_field_handler_t)(const ccm_field_t *field, void *arg);
+
+/* Parser state, allocated by the caller. Use the functions below, the fields
+ * are private. */
+typedef struct
+{
+    ccm_field_handler_t handler;
+    void *arg;
+    uint8_t state;
+    uint8_t string_state; /* J_KEY or J_STRING while in an escape sequence */
+    uint8_t depth;
+    uint8_t unicode_digits;
+    uint16_t unicode;
+    uint16_t path_length;
+    uint16_t value_length;
+    uint32_t fields; /* fields passed over all documents */
+    struct
+    {
+        uint16_t path_length; /* path of the object or array itself */
+        uint16_t index;       /* next array element, or object member */
+        bool array;
+    } stack[CCM_PARSER_DEPTH];
+    char path[CCM_PARSER_PATH_MAX + 1];
+    char value[CCM_PARSER_VALUE_MAX + 1];
+} ccm_parser_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_parser_init(ccm_parser_t *parser, ccm_field_handler_t handler, void *arg);
+
+bool ccm_parser_feed(ccm_parser_t *parser, const uint8_t *data, uint16_t length);
+
+bool ccm_parser_finish(ccm_parser_t *parser);
+
+void ccm_parser_subscription_handler(uint8_t index, const uint8_t *data, uint16_t length, bool last, bool ok,
+                                     void *arg);
+
+bool ccm_field_get_int(const ccm_field_t *field, int32_t *value);
+
+bool ccm_field_get_bool(const ccm_field_t *field, bool *value);
+
+#endif /* CCM_PARSER_H_ */
@@ -0,0 +1,361 @@
+/******************************************************************************
+ * File Name: ccm_publish.c
+ *
+ * Description: Outbound telemetry. Records published to a topic are collected
+ * into one batch per topic, "[record,record,...]", sent with a single
+ * AT+SEND<index> once the batch is full or its oldest record is
+ * CCM_PUBLISH_MAX_AGE old. ccm_publish_process() sends at most one batch per
+ * call, so the main loop handles an EVENT pin edge between two batches and the
+ * inbound messages are not delayed by a burst of outbound ones.
+ *
+ * The records should be JSON values, the batch is then a JSON array. A batch
+ * the module did not acknowledge is kept and sent again after
+ * CCM_PUBLISH_MAX_AGE; records not fitting meanwhile are dropped. Call the
+ * functions from one task.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_publish.h"
+#include "ccm_command_queue.h"
+#include "ccm_config.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* "AT+SEND<index> ", the batch, '\n' and the string terminator */
+#define PUBLISH_LINE_SIZE (sizeof("AT+SEND8 ") - 1 + CCM_PUBLISH_BATCH_SIZE + 2u)
+
+#if (CCM_PUBLISH_BATCH_SIZE < 3u)
+#error "CCM_PUBLISH_BATCH_SIZE does not hold a record"
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    const char *topic;
+    uint8_t index;
+    uint16_t records;       /* records in the batch */
+    uint8_t prefix_length;  /* "AT+SEND<index> " */
+    uint16_t length;        /* characters in line, without the closing "]\n" */
+    uint32_t first_time;    /* ccm_get_time_ms() of the oldest record, or of the failed send */
+    bool full;              /* sent by the next ccm_publish_process() */
+    bool failed;            /* last send not acknowledged */
+    char line[PUBLISH_LINE_SIZE];
+} publisher_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static publisher_t publishers[CCM_PUBLISH_MAX];
+
+static ccm_publish_stats_t publish_stats;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static publisher_t *find_publisher(uint8_t index);
+static bool batch_fits(const publisher_t *publisher, uint16_t length);
+static bool send_batch(publisher_t *publisher, uint32_t delay);
+
+/*******************************************************************************
+ * Function Name: ccm_publish_register
+ *******************************************************************************
+ * Summary:
+ *  Register a topic to publish to. The topic is configured by
+ *  ccm_publish_start().
+ *
+ * input parameter: uint8_t index
+ *                  CCM topic index, 1..CCM_COMMAND_TOPIC_COUNT, not used by a
+ *                  subscription to another topic
+ *
+ * input parameter: const char *topic
+ *                  Topic name, must stay valid
+ *
+ * Return:
+ *  bool - false if the index is out of range or CCM_PUBLISH_MAX topics are
+ *         registered already.
+ *
+ *******************************************************************************/
+bool ccm_publish_register(uint8_t index, const char *topic)
+{
+    publisher_t *publisher = NULL;
+
+    if ((index == 0) || (index > CCM_COMMAND_TOPIC_COUNT))
+    {
+        return false;
+    }
+
+    publisher = find_publisher(index);
+    if (publisher == NULL)
+    {
+        publisher = find_publisher(0);
+    }
+
+    if (publisher == NULL)
+    {
+        return false;
+    }
+
+    memset(publisher, 0, sizeof(*publisher));
+    publisher->topic = topic;
+    publisher->index = index;
+    publisher->prefix_length = (uint8_t)snprintf(publisher->line, sizeof(publisher->line), "AT+SEND%u ", index);
+    publisher->length = publisher->prefix_length;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_publish_start
+ *******************************************************************************
+ * Summary:
+ *  Configure the registered topics on the CCM module, pipelined.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of each command in milliseconds
+ *
+ * Return:
+ *  bool - true if every command was acknowledged.
+ *
+ *******************************************************************************/
+bool ccm_publish_start(uint32_t delay)
+{
+    char command[CCM_COMMAND_MAX_LENGTH];
+
+    for (uint8_t i = 0; i < CCM_PUBLISH_MAX; i++)
+    {
+        if (publishers[i].topic == NULL)
+        {
+            continue;
+        }
+
+        /* AT command for storing the topic name*/
+        snprintf(command, sizeof(command), "AT+CONF Topic%u=%s\n", publishers[i].index, publishers[i].topic);
+        ccm_config_submit(command, delay, CCM_COMMAND_FLAG_NONE);
+    }
+
+    return ccm_command_queue_flush();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_publish
+ *******************************************************************************
+ * Summary:
+ *  Add a record to the batch of a topic. A full batch is sent first.
+ *
+ * input parameter: uint8_t index
+ *                  CCM topic index of a registered topic
+ *
+ * input parameter: const char *record, uint16_t length
+ *                  Record, without line breaks
+ *
+ * Return:
+ *  bool - false if the record was dropped.
+ *
+ *******************************************************************************/
+bool ccm_publish(uint8_t index, const char *record, uint16_t length)
+{
+    publisher_t *publisher = find_publisher(index);
+
+    if ((publisher == NULL) || (length == 0) || (length > CCM_PUBLISH_BATCH_SIZE - 2u) ||
+        (memchr(record, '\n', length) != NULL) || (memchr(record, '\r', length) != NULL))
+    {
+        publish_stats.dropped++;
+        return false;
+    }
+
+    if (!batch_fits(publisher, length))
+    {
+        /* A failed batch is only sent again once CCM_PUBLISH_MAX_AGE passed*/
+        if (publisher->failed || !send_batch(publisher, CCM_TIMEOUT_AUTO))
+        {
+            publish_stats.dropped++;
+            return false;
+        }
+
+        publish_stats.size_flushes++;
+    }
+
+    if (publisher->records == 0)
+    {
+        publisher->first_time = ccm_get_time_ms();
+    }
+
+    publisher->line[publisher->length++] = (publisher->records == 0) ? '[' : ',';
+    memcpy(&publisher->line[publisher->length], record, length);
+    publisher->length += length;
+    publisher->records++;
+    publish_stats.records++;
+
+    if ((publisher->records >= CCM_PUBLISH_BATCH_RECORDS) || !batch_fits(publisher, 1))
+    {
+        publisher->full = true;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_publish_process
+ *******************************************************************************
+ * Summary:
+ *  Send one batch that is full or old enough. Call from the main loop, between
+ *  the event drains.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of AT+SEND in milliseconds
+ *
+ * Return:
+ *  uint32_t - ms until the next batch is due, 0 if one is due already,
+ *             CCM_PUBLISH_WAIT_FOREVER if no record is waiting.
+ *
+ *******************************************************************************/
+uint32_t ccm_publish_process(uint32_t delay)
+{
+    uint32_t wait = CCM_PUBLISH_WAIT_FOREVER;
+    bool sent = false;
+
+    for (uint8_t i = 0; i < CCM_PUBLISH_MAX; i++)
+    {
+        publisher_t *publisher = &publishers[i];
+        uint32_t age = ccm_get_time_ms() - publisher->first_time;
+        uint32_t due = 0;
+
+        if ((publisher->topic == NULL) || (publisher->records == 0))
+        {
+            continue;
+        }
+
+        if (!publisher->full && (age < CCM_PUBLISH_MAX_AGE))
+        {
+            due = CCM_PUBLISH_MAX_AGE - age;
+        }
+        else if (!sent)
+        {
+            bool full = publisher->full;
+
+            sent = true;
+            if (send_batch(publisher, delay))
+            {
+                if (full)
+                {
+                    publish_stats.size_flushes++;
+                }
+                else
+                {
+                    publish_stats.age_flushes++;
+                }
+                continue;
+            }
+
+            due = CCM_PUBLISH_MAX_AGE;
+        }
+
+        if (due < wait)
+        {
+            wait = due;
+        }
+    }
+
+    return wait;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_publish_flush
+ *******************************************************************************
+ * Summary:
+ *  Send every waiting batch now, e.g. before a host reset.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of AT+SEND in milliseconds
+ *
+ * Return:
+ *  bool - false if a batch was not acknowledged.
+ *
+ *******************************************************************************/
+bool ccm_publish_flush(uint32_t delay)
+{
+    bool success = true;
+
+    for (uint8_t i = 0; i < CCM_PUBLISH_MAX; i++)
+    {
+        if ((publishers[i].topic != NULL) && (publishers[i].records > 0) && !send_batch(&publishers[i], delay))
+        {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_publish_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Copy of the publish statistics.
+ *
+ *******************************************************************************/
+void ccm_publish_get_stats(ccm_publish_stats_t *stats)
+{
+    *stats = publish_stats;
+}
+
+/* Registered topic of an index, a free entry for index 0 */
+static publisher_t *find_publisher(uint8_t index)
+{
+    for (uint8_t i = 0; i < CCM_PUBLISH_MAX; i++)
+    {
+        if ((index == 0) ? (publishers[i].topic == NULL) : (publishers[i].index == index))
+        {
+            return &publishers[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Room for a separator, the record and the closing ']' */
+static bool batch_fits(const publisher_t *publisher, uint16_t length)
+{
+    return (publisher->length - publisher->prefix_length) + 1u + length + 1u <= CCM_PUBLISH_BATCH_SIZE;
+}
+
+static bool send_batch(publisher_t *publisher, uint32_t delay)
+{
+    int result = 0;
+    uint16_t length = publisher->length;
+
+    publisher->line[length] = ']';
+    publisher->line[length + 1] = '\n';
+    publisher->line[length + 2] = '\0';
+
+    /* AT command for publishing the batch to the topic*/
+    ccm_response_release(at_command_send_receive(publisher->line, (int)delay, &result, "OK"));
+
+    if (!result)
+    {
+        publish_stats.errors++;
+        publisher->failed = true;
+        publisher->full = false;
+        publisher->first_time = ccm_get_time_ms();
+        return false;
+    }
+
+    publish_stats.batches++;
+    publish_stats.bytes += length - publisher->prefix_length + 1u;
+
+    publisher->records = 0;
+    publisher->length = publisher->prefix_length;
+    publisher->full = false;
+    publisher->failed = false;
+
+    return true;
+}
+
+/* [] END OF FILE */
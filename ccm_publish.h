@@ -0,0 +1,72 @@
+/******************************************************************************
+ * File Name: ccm_publish.h
+ *
+ * Description: This file is the public interface of ccm_publish.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_PUBLISH_H_
+#define CCM_PUBLISH_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Number of topics published to */
+#ifndef CCM_PUBLISH_MAX
+#define CCM_PUBLISH_MAX (2u)
+#endif
+
+/* Longest batch payload, "[record,record,...]", in bytes */
+#ifndef CCM_PUBLISH_BATCH_SIZE
+#define CCM_PUBLISH_BATCH_SIZE (256u)
+#endif
+
+/* A batch is sent once it holds this many records */
+#ifndef CCM_PUBLISH_BATCH_RECORDS
+#define CCM_PUBLISH_BATCH_RECORDS (16u)
+#endif
+
+/* A batch is sent once its oldest record waited this long, ms */
+#ifndef CCM_PUBLISH_MAX_AGE
+#define CCM_PUBLISH_MAX_AGE (5000u)
+#endif
+
+/* Returned by ccm_publish_process() when no record is waiting */
+#define CCM_PUBLISH_WAIT_FOREVER (0xFFFFFFFFu)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    uint32_t records;      /* records queued */
+    uint32_t batches;      /* AT+SEND acknowledged */
+    uint32_t bytes;        /* payload bytes of the acknowledged batches */
+    uint32_t size_flushes; /* batches sent because full */
+    uint32_t age_flushes;  /* batches sent because of CCM_PUBLISH_MAX_AGE */
+    uint32_t errors;       /* AT+SEND not acknowledged, the batch is sent again */
+    uint32_t dropped;      /* records too long, or not fitting while a batch failed */
+} ccm_publish_stats_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+bool ccm_publish_register(uint8_t index, const char *topic);
+
+bool ccm_publish_start(uint32_t delay);
+
+bool ccm_publish(uint8_t index, const char *record, uint16_t length);
+
+uint32_t ccm_publish_process(uint32_t delay);
+
+bool ccm_publish_flush(uint32_t delay);
+
+void ccm_publish_get_stats(ccm_publish_stats_t *stats);
+
+#endif /* CCM_PUBLISH_H_ */
@@ -0,0 +1,347 @@
+/******************************************************************************
+ * File Name: ccm_rtos.c
+ *
+ * Description: Optional FreeRTOS threading model of the CCM link, built when
+ * FREERTOS is added to COMPONENTS in the Makefile.
+ *
+ * - The AT link task owns the UART: it executes the AT command API calls of
+ *   the other tasks, received through a request queue, one at a time. The
+ *   blocking API (at_command_send_receive() and friends) posts its request and
+ *   waits for the completion, so it can be called from any task.
+ * - While waiting for a response the AT link task blocks on a notification
+ *   given by the UART interrupt, the other tasks run in the meantime.
+ * - The event task drains the CCM event queue when the EVENT pin rises and
+ *   calls the registered handlers.
+ * - The log task writes the deferred log to the debug UART at low priority.
+ *
+ * The state shared by the tasks outside of the AT link task (time base, link
+ * state cache, response slots) is accessed in critical sections; the callbacks
+ * of the AT link task only touch state of the task waiting for the call.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_rtos.h"
+
+#if CCM_RTOS
+
+#include "CCM.h"
+#include "ccm_event.h"
+#include "ccm_log.h"
+#include "ccm_ota.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    ccm_rtos_function_t function;
+    void *arg;
+    TaskHandle_t caller;
+} io_request_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static TaskHandle_t io_task;
+static StaticTask_t io_task_tcb;
+static StackType_t io_task_stack[CCM_RTOS_IO_STACK_SIZE];
+
+static TaskHandle_t event_task;
+static StaticTask_t event_task_tcb;
+static StackType_t event_task_stack[CCM_RTOS_EVENT_STACK_SIZE];
+
+static TaskHandle_t log_task;
+static StaticTask_t log_task_tcb;
+static StackType_t log_task_stack[CCM_RTOS_LOG_STACK_SIZE];
+
+static QueueHandle_t io_requests;
+static StaticQueue_t io_requests_queue;
+static uint8_t io_requests_storage[CCM_RTOS_REQUEST_QUEUE_LENGTH * sizeof(io_request_t)];
+
+/* Response timeout of the AT+EVENT? commands of the event task */
+static uint32_t event_delay;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void io_task_function(void *arg);
+static void event_task_function(void *arg);
+static void log_task_function(void *arg);
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_init
+ *******************************************************************************
+ * Summary:
+ *  Create the AT link task, the log task and the request queue. Call after
+ *  uart_init() and before vTaskStartScheduler(); until the scheduler runs the
+ *  AT command API executes in the calling context as in the bare-metal build.
+ *
+ *******************************************************************************/
+void ccm_rtos_init(void)
+{
+    io_requests = xQueueCreateStatic(CCM_RTOS_REQUEST_QUEUE_LENGTH, sizeof(io_request_t),
+                                     io_requests_storage, &io_requests_queue);
+
+    io_task = xTaskCreateStatic(io_task_function, "ccm_io", CCM_RTOS_IO_STACK_SIZE, NULL,
+                                CCM_RTOS_IO_TASK_PRIORITY, io_task_stack, &io_task_tcb);
+
+    log_task = xTaskCreateStatic(log_task_function, "ccm_log", CCM_RTOS_LOG_STACK_SIZE, NULL,
+                                 CCM_RTOS_LOG_TASK_PRIORITY, log_task_stack, &log_task_tcb);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_direct
+ *******************************************************************************
+ * Summary:
+ *  Whether an AT command API call executes directly in the calling context:
+ *  before the scheduler starts, and in the AT link task itself (for example
+ *  from a stream callback).
+ *
+ *******************************************************************************/
+bool ccm_rtos_direct(void)
+{
+    return (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) || (xTaskGetCurrentTaskHandle() == io_task);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_call
+ *******************************************************************************
+ * Summary:
+ *  Execute function in the AT link task and wait for it to return. Calls made
+ *  from the AT link task itself, or before the scheduler runs, execute
+ *  directly.
+ *
+ * input parameter: ccm_rtos_function_t function
+ *                  Function to execute
+ *
+ * input parameter: void *arg
+ *                  Passed to the function, typically the arguments and results
+ *                  of the API call on the caller stack
+ *
+ *******************************************************************************/
+void ccm_rtos_call(ccm_rtos_function_t function, void *arg)
+{
+    if (ccm_rtos_direct())
+    {
+        function(arg);
+        return;
+    }
+
+    io_request_t request = {
+        .function = function,
+        .arg = arg,
+        .caller = xTaskGetCurrentTaskHandle()};
+
+    xQueueSend(io_requests, &request, portMAX_DELAY);
+
+    ulTaskNotifyTakeIndexed(CCM_RTOS_NOTIFY_DONE, pdTRUE, portMAX_DELAY);
+}
+
+/*******************************************************************************
+ * Function Name: io_task_function
+ *******************************************************************************
+ * Summary:
+ *  AT link task: execute the requests of the other tasks in arrival order.
+ *
+ *******************************************************************************/
+static void io_task_function(void *arg)
+{
+    io_request_t request;
+
+    while (1)
+    {
+        if (pdPASS == xQueueReceive(io_requests, &request, portMAX_DELAY))
+        {
+            request.function(request.arg);
+
+            xTaskNotifyGiveIndexed(request.caller, CCM_RTOS_NOTIFY_DONE);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_io_wait
+ *******************************************************************************
+ * Summary:
+ *  Block the AT link task until the UART interrupt received data or delay
+ *  milliseconds elapsed. Used by the receive path instead of sleeping the CPU.
+ *
+ * Return:
+ *  bool - false on timeout.
+ *
+ *******************************************************************************/
+bool ccm_rtos_io_wait(uint32_t delay)
+{
+    TickType_t ticks = pdMS_TO_TICKS(delay);
+
+    return (ulTaskNotifyTakeIndexed(CCM_RTOS_NOTIFY_WAKEUP, pdTRUE, (ticks > 0) ? ticks : 1) > 0);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_io_notify_from_isr
+ *******************************************************************************
+ * Summary:
+ *  Wake the AT link task up, called by the UART interrupt handler.
+ *
+ *******************************************************************************/
+void ccm_rtos_io_notify_from_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (io_task != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(io_task, CCM_RTOS_NOTIFY_WAKEUP, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_event_task_start
+ *******************************************************************************
+ * Summary:
+ *  Create the event task. Call once the application is ready for the CCM
+ *  events (subscribed); events signaled before are handled right away.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of AT+EVENT? in milliseconds
+ *
+ *******************************************************************************/
+void ccm_rtos_event_task_start(uint32_t delay)
+{
+    event_delay = delay;
+
+    event_task = xTaskCreateStatic(event_task_function, "ccm_event", CCM_RTOS_EVENT_STACK_SIZE, NULL,
+                                   CCM_RTOS_EVENT_TASK_PRIORITY, event_task_stack, &event_task_tcb);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_event_notify_from_isr
+ *******************************************************************************
+ * Summary:
+ *  Signal a CCM event, called by the EVENT pin interrupt handler.
+ *
+ *******************************************************************************/
+void ccm_rtos_event_notify_from_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (event_task != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(event_task, CCM_RTOS_NOTIFY_WAKEUP, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: event_task_function
+ *******************************************************************************
+ * Summary:
+ *  Event task: drain the CCM event queue on every EVENT pin rising edge. The
+ *  handlers run in this task; their AT commands go through the AT link task.
+ *  The OTA steps run between the drains, waking the task up when they are due.
+ *
+ *******************************************************************************/
+static void event_task_function(void *arg)
+{
+    /* Events may have been queued before the task existed */
+    bool pending = true;
+    uint32_t ota_wait = CCM_OTA_WAIT_FOREVER;
+
+    while (1)
+    {
+        if (!pending)
+        {
+            TickType_t ticks = (ota_wait == CCM_OTA_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(ota_wait);
+
+            pending = (ulTaskNotifyTakeIndexed(CCM_RTOS_NOTIFY_WAKEUP, pdTRUE, ticks) > 0);
+        }
+
+        if (pending)
+        {
+            /* The queue may still hold events if the drain limit was hit */
+            pending = (ccm_event_drain(event_delay, true) >= CCM_EVENT_DRAIN_MAX);
+        }
+
+        if (!pending)
+        {
+            ota_wait = ccm_ota_process(event_delay);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_rtos_log_notify
+ *******************************************************************************
+ * Summary:
+ *  Wake the log task up, called by ccm_log when a message was added. Can be
+ *  called from interrupt context.
+ *
+ *******************************************************************************/
+void ccm_rtos_log_notify(void)
+{
+    if ((log_task == NULL) || (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING))
+    {
+        return;
+    }
+
+    if (xPortIsInsideInterrupt())
+    {
+        BaseType_t woken = pdFALSE;
+
+        vTaskNotifyGiveIndexedFromISR(log_task, CCM_RTOS_NOTIFY_WAKEUP, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyGiveIndexed(log_task, CCM_RTOS_NOTIFY_WAKEUP);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: log_task_function
+ *******************************************************************************
+ * Summary:
+ *  Log task: write the deferred log to the debug UART when the other tasks are
+ *  idle.
+ *
+ *******************************************************************************/
+static void log_task_function(void *arg)
+{
+    while (1)
+    {
+        ulTaskNotifyTakeIndexed(CCM_RTOS_NOTIFY_WAKEUP, pdTRUE, portMAX_DELAY);
+
+        ccm_log_flush();
+    }
+}
+
+#if (configCHECK_FOR_STACK_OVERFLOW > 0)
+/*******************************************************************************
+ * Function Name: vApplicationStackOverflowHook
+ *******************************************************************************
+ * Summary:
+ *  Called by the kernel when it detects that a task overflowed its stack
+ *  (configCHECK_FOR_STACK_OVERFLOW in FreeRTOSConfig.h). The memory next to
+ *  the stack is corrupted, the task name is logged and the system halted.
+ *
+ *******************************************************************************/
+void vApplicationStackOverflowHook(TaskHandle_t task, char *task_name)
+{
+    static const char overflow[] = "\n\rStack overflow in task ";
+
+    /* Called from the context switch: no formatting, see ccm_log.c */
+    ccm_log_data(CCM_LOG_ERROR, overflow, sizeof(overflow) - 1);
+    ccm_log_data(CCM_LOG_ERROR, task_name, strlen(task_name));
+    ccm_log_data(CCM_LOG_ERROR, "\n\r", 2);
+
+    handle_error();
+}
+#endif
+
+#endif /* CCM_RTOS */
+
+/* [] END OF FILE */
@@ -0,0 +1,103 @@
+/******************************************************************************
+ * File Name: ccm_rtos.h
+ *
+ * Description: This file is the public interface of ccm_rtos.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_RTOS_H_
+#define CCM_RTOS_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set by the build system when FREERTOS is added to COMPONENTS */
+#if defined(COMPONENT_FREERTOS)
+#define CCM_RTOS (1)
+#else
+#define CCM_RTOS (0)
+#endif
+
+#if CCM_RTOS
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* The AT link task has the highest priority so that the link is never idle
+ * while a request is waiting; payload processing runs in lower priority tasks */
+#ifndef CCM_RTOS_IO_TASK_PRIORITY
+#define CCM_RTOS_IO_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#endif
+
+#ifndef CCM_RTOS_EVENT_TASK_PRIORITY
+#define CCM_RTOS_EVENT_TASK_PRIORITY (configMAX_PRIORITIES - 3)
+#endif
+
+#ifndef CCM_RTOS_LOG_TASK_PRIORITY
+#define CCM_RTOS_LOG_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#endif
+
+/* Stack sizes in words */
+#ifndef CCM_RTOS_IO_STACK_SIZE
+#define CCM_RTOS_IO_STACK_SIZE (1024u)
+#endif
+
+#ifndef CCM_RTOS_EVENT_STACK_SIZE
+#define CCM_RTOS_EVENT_STACK_SIZE (512u)
+#endif
+
+#ifndef CCM_RTOS_LOG_STACK_SIZE
+#define CCM_RTOS_LOG_STACK_SIZE (384u)
+#endif
+
+/* Requests waiting for the AT link task */
+#ifndef CCM_RTOS_REQUEST_QUEUE_LENGTH
+#define CCM_RTOS_REQUEST_QUEUE_LENGTH (4u)
+#endif
+
+/* Interval at which a task sleeping in ccm_deep_sleep_until() or
+ * ccm_deep_sleep_timeout() checks its wake-up condition, ms */
+#ifndef CCM_RTOS_SLEEP_POLL_INTERVAL
+#define CCM_RTOS_SLEEP_POLL_INTERVAL (10u)
+#endif
+
+/* Task notification indexes, see configTASK_NOTIFICATION_ARRAY_ENTRIES */
+#define CCM_RTOS_NOTIFY_WAKEUP (0u)
+#define CCM_RTOS_NOTIFY_DONE   (1u)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Function executed by the AT link task on behalf of another task */
+typedef void (*ccm_rtos_function_t)(void *arg);
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_rtos_init(void);
+
+bool ccm_rtos_direct(void);
+
+void ccm_rtos_call(ccm_rtos_function_t function, void *arg);
+
+bool ccm_rtos_io_wait(uint32_t delay);
+
+void ccm_rtos_io_notify_from_isr(void);
+
+void ccm_rtos_event_task_start(uint32_t delay);
+
+void ccm_rtos_event_notify_from_isr(void);
+
+void ccm_rtos_log_notify(void);
+
+#endif /* CCM_RTOS */
+
+#endif /* CCM_RTOS_H_ */
@@ -0,0 +1,415 @@
+/******************************************************************************
+ * File Name: ccm_settings.c
+ *
+ * Description: Runtime settings of the application: connection flow, Wi-Fi
+ * onboarding, credentials, endpoint and topic. They are loaded once at boot
+ * from a host flash row into a ccm_settings_t; a blank or corrupted row, or a
+ * row saved with other compile-time defaults, gives the defaults of the
+ * firmware.
+ *
+ * Changes (ccm_settings_set(), or fields of a settings message through the
+ * parser) go to a staged copy. The settings in use do not change while the
+ * application runs: ccm_settings_save() stores the staged copy, which is used
+ * from the next boot on.
+ *
+ * Saved settings are on trial until they connect: they go to a second row,
+ * next to the last-known-good row. The boot after a save uses the trial row;
+ * ccm_settings_confirm() makes it the last-known-good row once the CCM module
+ * connected, ccm_settings_revert() drops it when the connection supervisor
+ * gave up, so that settings that cannot connect (wrong Passphrase, Endpoint,
+ * flow) do not lock the device out of remote configuration.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_settings.h"
+#include "ccm_config.h"
+#include "ccm_log.h"
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "stddef.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define SETTINGS_MAGIC (0x43535431u) /* "CST1" */
+#define SETTINGS_ROW_WORDS (CY_FLASH_SIZEOF_ROW / sizeof(uint32_t))
+
+/* Flash rows of the settings */
+#define SETTINGS_ROW_CONFIRMED (0u) /* last-known-good settings */
+#define SETTINGS_ROW_TRIAL (1u)     /* saved, not connected yet */
+#define SETTINGS_ROWS (2u)
+
+/* Longest value of a string setting */
+#define SETTINGS_VALUE_SIZE (CCM_SETTINGS_ENDPOINT_SIZE)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t size;     /* sizeof(ccm_settings_t) when saved */
+    uint32_t defaults; /* hash of the compile-time defaults when saved */
+    ccm_settings_t settings;
+    uint32_t checksum;
+} settings_record_t;
+
+_Static_assert(sizeof(settings_record_t) <= CY_FLASH_SIZEOF_ROW, "ccm_settings_t does not fit in a flash row");
+
+typedef struct
+{
+    const char *key;
+    size_t offset;
+    size_t size;
+} string_setting_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Emulated EEPROM section of the linker script, kept by firmware updates */
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(CY_FLASH_SIZEOF_ROW)
+static const uint32_t settings_flash[SETTINGS_ROWS][SETTINGS_ROW_WORDS] = {{0}};
+
+/* RAM copy of the row, written whole to flash */
+static union
+{
+    settings_record_t record;
+    uint32_t words[SETTINGS_ROW_WORDS];
+} settings_row;
+
+static ccm_settings_t settings;        /* in use since boot */
+static ccm_settings_t settings_staged; /* saved by ccm_settings_save() */
+static uint32_t defaults_hash = 0;
+static bool settings_rejected = false; /* a staged change was invalid */
+static bool settings_on_trial = false; /* in use from the trial row */
+
+/* A string setting received in pieces */
+static char field_value[SETTINGS_VALUE_SIZE];
+static uint16_t field_length = 0;
+
+static cyhal_flash_t settings_flash_obj;
+static bool settings_flash_ready = false;
+
+static const string_setting_t string_settings[] = {
+    {"ssid", offsetof(ccm_settings_t, ssid), CCM_SETTINGS_SSID_SIZE},
+    {"passphrase", offsetof(ccm_settings_t, passphrase), CCM_SETTINGS_PASSPHRASE_SIZE},
+    {"endpoint", offsetof(ccm_settings_t, endpoint), CCM_SETTINGS_ENDPOINT_SIZE},
+    {"topic", offsetof(ccm_settings_t, topic), CCM_SETTINGS_TOPIC_SIZE},
+};
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static uint32_t record_checksum(void);
+static bool row_load(uint32_t row);
+static bool row_write(uint32_t row);
+static bool row_erase(uint32_t row);
+
+/*******************************************************************************
+ * Function Name: ccm_settings_init
+ *******************************************************************************
+ * Summary:
+ *  Load the settings from flash, once at boot: the trial row if settings were
+ *  saved since the last connection, else the last-known-good row.
+ *
+ * input parameter: const ccm_settings_t *defaults
+ *                  Compile-time settings of the firmware, used until settings
+ *                  are saved
+ *
+ *******************************************************************************/
+void ccm_settings_init(const ccm_settings_t *defaults)
+{
+    defaults_hash = ccm_fnv1a(CCM_FNV1A_INIT, defaults, sizeof(*defaults));
+
+    if (row_load(SETTINGS_ROW_TRIAL))
+    {
+        settings = settings_row.record.settings;
+        settings_on_trial = true;
+        CCM_LOG(CCM_LOG_INFO, "\rTrying the saved settings\n");
+    }
+    else if (row_load(SETTINGS_ROW_CONFIRMED))
+    {
+        settings = settings_row.record.settings;
+        CCM_LOG(CCM_LOG_INFO, "\rSettings loaded from flash\n");
+    }
+    else
+    {
+        settings = *defaults;
+    }
+
+    /* The strings are used as they are, make sure they are terminated */
+    settings.ssid[CCM_SETTINGS_SSID_SIZE - 1] = '\0';
+    settings.passphrase[CCM_SETTINGS_PASSPHRASE_SIZE - 1] = '\0';
+    settings.endpoint[CCM_SETTINGS_ENDPOINT_SIZE - 1] = '\0';
+    settings.topic[CCM_SETTINGS_TOPIC_SIZE - 1] = '\0';
+
+    settings_flash_ready = (CY_RSLT_SUCCESS == cyhal_flash_init(&settings_flash_obj));
+
+    ccm_settings_discard();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_get
+ *******************************************************************************
+ * Summary:
+ *  Settings in use, loaded at boot.
+ *
+ *******************************************************************************/
+const ccm_settings_t *ccm_settings_get(void)
+{
+    return &settings;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_set
+ *******************************************************************************
+ * Summary:
+ *  Change a staged setting.
+ *
+ * input parameter: const char *key
+ *                  "flow" ("aws" or "cirrent"), "onboarding" ("credentials"
+ *                  or "app"), "ssid", "passphrase", "endpoint" or "topic"
+ *                  const char *value
+ *
+ * Return:
+ *  bool - false for an unknown key, an invalid or too long value.
+ *
+ *******************************************************************************/
+bool ccm_settings_set(const char *key, const char *value)
+{
+    if (!strcmp(key, "flow"))
+    {
+        if (!strcmp(value, "aws"))
+        {
+            settings_staged.flow = CCM_FLOW_AWS;
+            return true;
+        }
+        if (!strcmp(value, "cirrent"))
+        {
+            settings_staged.flow = CCM_FLOW_CIRRENT;
+            return true;
+        }
+        return false;
+    }
+
+    if (!strcmp(key, "onboarding"))
+    {
+        if (!strcmp(value, "credentials"))
+        {
+            settings_staged.onboarding = CCM_ONBOARDING_CREDENTIALS;
+            return true;
+        }
+        if (!strcmp(value, "app"))
+        {
+            settings_staged.onboarding = CCM_ONBOARDING_CIRRENT_APP;
+            return true;
+        }
+        return false;
+    }
+
+    for (uint32_t i = 0; i < sizeof(string_settings) / sizeof(string_settings[0]); i++)
+    {
+        if (!strcmp(key, string_settings[i].key))
+        {
+            size_t length = strlen(value);
+
+            if (length >= string_settings[i].size)
+            {
+                return false;
+            }
+
+            memcpy((char *)&settings_staged + string_settings[i].offset, value, length + 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_field_handler
+ *******************************************************************************
+ * Summary:
+ *  Field handler for ccm_parser_init(): every field of a settings message is
+ *  a staged setting, e.g. {"flow":"cirrent","topic":"data"}. An invalid field
+ *  makes the next ccm_settings_save() fail.
+ *
+ *******************************************************************************/
+void ccm_settings_field_handler(const ccm_field_t *field, void *arg)
+{
+    if ((field->type != CCM_FIELD_STRING) || (field_length + field->length >= SETTINGS_VALUE_SIZE))
+    {
+        CCM_LOG(CCM_LOG_WARN, "\rInvalid setting %s\n", field->key);
+        settings_rejected = true;
+        field_length = 0;
+        return;
+    }
+
+    memcpy(&field_value[field_length], field->value, field->length);
+    field_length += field->length;
+    field_value[field_length] = '\0';
+
+    if (field->partial)
+    {
+        return;
+    }
+
+    if (!ccm_settings_set(field->key, field_value))
+    {
+        /* The key only, passphrase is one of the settings */
+        CCM_LOG(CCM_LOG_WARN, "\rInvalid setting %s\n", field->key);
+        settings_rejected = true;
+    }
+
+    field_length = 0;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_changed
+ *******************************************************************************
+ * Summary:
+ *  Check whether the staged settings differ from the settings in use.
+ *
+ *******************************************************************************/
+bool ccm_settings_changed(void)
+{
+    return 0 != memcmp(&settings_staged, &settings, sizeof(settings));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_save
+ *******************************************************************************
+ * Summary:
+ *  Write the staged settings to the trial row, they are used from the next
+ *  boot on and kept if they connect. Staged settings with an invalid change
+ *  are discarded instead.
+ *
+ * Return:
+ *  bool - false if a change was invalid or the flash write failed.
+ *
+ *******************************************************************************/
+bool ccm_settings_save(void)
+{
+    if (settings_rejected || !settings_flash_ready)
+    {
+        ccm_settings_discard();
+        return false;
+    }
+
+    memset(&settings_row, 0, sizeof(settings_row));
+    settings_row.record.magic = SETTINGS_MAGIC;
+    settings_row.record.size = sizeof(ccm_settings_t);
+    settings_row.record.defaults = defaults_hash;
+    settings_row.record.settings = settings_staged;
+    settings_row.record.checksum = record_checksum();
+
+    return row_write(SETTINGS_ROW_TRIAL);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_confirm
+ *******************************************************************************
+ * Summary:
+ *  The CCM module connected with the settings in use: settings on trial
+ *  become the last-known-good settings. Call once connected.
+ *
+ *******************************************************************************/
+void ccm_settings_confirm(void)
+{
+    if (!settings_on_trial || !settings_flash_ready)
+    {
+        return;
+    }
+
+    /* The last-known-good row first: a reset in between tries the same
+     * settings again and confirms them once more */
+    if (row_load(SETTINGS_ROW_TRIAL) && row_write(SETTINGS_ROW_CONFIRMED) && row_erase(SETTINGS_ROW_TRIAL))
+    {
+        settings_on_trial = false;
+        CCM_LOG(CCM_LOG_INFO, "\rSaved settings confirmed\n");
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_revert
+ *******************************************************************************
+ * Summary:
+ *  The CCM module did not connect with the settings on trial, the connection
+ *  supervisor gave up: drop them, the next boot uses the last-known-good
+ *  settings. Call before the host reset of the escalation; nothing to do for
+ *  last-known-good settings.
+ *
+ *******************************************************************************/
+void ccm_settings_revert(void)
+{
+    if (!settings_on_trial || !settings_flash_ready)
+    {
+        return;
+    }
+
+    if (row_erase(SETTINGS_ROW_TRIAL))
+    {
+        settings_on_trial = false;
+        CCM_LOG(CCM_LOG_WARN, "\rSaved settings did not connect, reverted\n");
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_settings_discard
+ *******************************************************************************
+ * Summary:
+ *  Drop the staged changes.
+ *
+ *******************************************************************************/
+void ccm_settings_discard(void)
+{
+    settings_staged = settings;
+    settings_rejected = false;
+    field_length = 0;
+}
+
+/* Copy a row to settings_row, true if it holds valid settings of this firmware */
+static bool row_load(uint32_t row)
+{
+    const volatile uint32_t *flash = settings_flash[row];
+
+    for (uint32_t i = 0; i < SETTINGS_ROW_WORDS; i++)
+    {
+        settings_row.words[i] = flash[i];
+    }
+
+    return (settings_row.record.magic == SETTINGS_MAGIC) && (settings_row.record.size == sizeof(ccm_settings_t)) &&
+           (settings_row.record.defaults == defaults_hash) && (settings_row.record.checksum == record_checksum());
+}
+
+/* Write settings_row to a row */
+static bool row_write(uint32_t row)
+{
+    if (CY_RSLT_SUCCESS !=
+        cyhal_flash_write(&settings_flash_obj, (uint32_t)(uintptr_t)settings_flash[row], settings_row.words))
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\rSettings write failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/* Invalidate a row */
+static bool row_erase(uint32_t row)
+{
+    memset(&settings_row, 0, sizeof(settings_row));
+
+    return row_write(row);
+}
+
+static uint32_t record_checksum(void)
+{
+    return ccm_fnv1a(CCM_FNV1A_INIT, &settings_row.record, offsetof(settings_record_t, checksum));
+}
+
+/* [] END OF FILE */
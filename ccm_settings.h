@@ -0,0 +1,78 @@
+/******************************************************************************
+ * File Name: ccm_settings.h
+ *
+ * Description: This file is the public interface of ccm_settings.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_SETTINGS_H_
+#define CCM_SETTINGS_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "ccm_command_queue.h"
+#include "ccm_parser.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Longest settings, including the string terminator. The Endpoint is sized so
+ * that "AT+CONF Endpoint=<value>\n" fits in a queued command */
+#define CCM_SETTINGS_SSID_SIZE (33u)
+#define CCM_SETTINGS_PASSPHRASE_SIZE (64u)
+#define CCM_SETTINGS_ENDPOINT_SIZE (CCM_COMMAND_MAX_LENGTH - sizeof("AT+CONF Endpoint=\n") + 1u)
+#define CCM_SETTINGS_TOPIC_SIZE (65u)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef enum
+{
+    CCM_FLOW_AWS = 0, /* endpoint and credentials configured by the application */
+    CCM_FLOW_CIRRENT  /* endpoint provisioned by Cirrent Cloud */
+} ccm_flow_t;
+
+typedef enum
+{
+    CCM_ONBOARDING_CREDENTIALS = 0, /* SSID and Passphrase from the settings */
+    CCM_ONBOARDING_CIRRENT_APP      /* Wi-Fi onboarding mode, SSID chosen in the Cirrent APP */
+} ccm_onboarding_t;
+
+/* Settings of the application, stored in one flash row. An empty string is
+ * not sent to the CCM module, which keeps its own value. */
+typedef struct
+{
+    uint8_t flow;       /* ccm_flow_t */
+    uint8_t onboarding; /* ccm_onboarding_t */
+    char ssid[CCM_SETTINGS_SSID_SIZE];
+    char passphrase[CCM_SETTINGS_PASSPHRASE_SIZE];
+    char endpoint[CCM_SETTINGS_ENDPOINT_SIZE];
+    char topic[CCM_SETTINGS_TOPIC_SIZE];
+} ccm_settings_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_settings_init(const ccm_settings_t *defaults);
+
+const ccm_settings_t *ccm_settings_get(void);
+
+bool ccm_settings_set(const char *key, const char *value);
+
+void ccm_settings_field_handler(const ccm_field_t *field, void *arg);
+
+bool ccm_settings_changed(void);
+
+bool ccm_settings_save(void);
+
+void ccm_settings_confirm(void);
+
+void ccm_settings_revert(void);
+
+void ccm_settings_discard(void);
+
+#endif /* CCM_SETTINGS_H_ */
@@ -0,0 +1,346 @@
+/******************************************************************************
+ * File Name: ccm_soak.c
+ *
+ * Description: Soak test mode (CCM_SOAK). The device publishes a message to
+ * its own subscribed topic every CCM_SOAK_PUBLISH_INTERVAL, so that the event
+ * loop runs under sustained MQTT traffic without an external publisher, and
+ * reports every CCM_SOAK_REPORT_INTERVAL:
+ *  - messages processed per second,
+ *  - p50 / p99 / max latency from the EVENT pin edge to the message processed,
+ *    from a histogram with four buckets per octave of microseconds,
+ *  - UART receive overruns and errors, AT command timeouts,
+ *  - heap high-water mark (mallinfo()) and stack high-water marks.
+ * Counts are per report interval, with the totals since boot in parentheses.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_soak.h"
+#include "ccm_command_queue.h"
+#include "ccm_log.h"
+#include "ccm_rtos.h"
+#include "heap_usage.h"
+#include "string.h"
+
+#if CCM_SOAK
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define LATENCY_BUCKETS (96u) /* up to 2^24 us */
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* ccm_get_ticks() of the last EVENT pin edge, written by the interrupt */
+static volatile uint32_t edge_ticks = 0;
+static volatile bool edge_seen = false;
+
+static uint8_t soak_publish_index = 0;
+static uint32_t soak_sequence = 0;
+static uint32_t last_publish_time = 0;
+static uint32_t period_start = 0;
+
+/* Current report interval */
+static uint32_t period_messages = 0;
+static uint32_t period_published = 0;
+static uint32_t period_publish_errors = 0;
+static uint32_t latency_count = 0;
+static uint32_t latency_max = 0;
+static uint32_t latency_histogram[LATENCY_BUCKETS];
+
+/* Totals at the previous report */
+static uint32_t total_messages = 0;
+static uint32_t total_published = 0;
+static uint32_t last_rx_overruns = 0;
+static uint32_t last_rx_errors = 0;
+static uint32_t last_timeouts = 0;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void publish(uint32_t delay);
+static uint32_t latency_bucket(uint32_t latency);
+static uint32_t bucket_upper_bound(uint32_t bucket);
+static uint32_t latency_percentile(uint32_t percent);
+static uint32_t total_timeouts(void);
+#endif
+
+/*******************************************************************************
+ * Function Name: ccm_soak_init
+ *******************************************************************************
+ * Summary:
+ *  Start the soak test, once subscribed.
+ *
+ * input parameter: uint8_t publish_index
+ *                  CCM topic index of a subscribed topic the soak messages are
+ *                  published to, 0 for none
+ *
+ *******************************************************************************/
+void ccm_soak_init(uint8_t publish_index)
+{
+#if CCM_SOAK
+    soak_publish_index = publish_index;
+    last_publish_time = ccm_get_time_ms();
+    period_start = last_publish_time;
+
+    CCM_LOG(CCM_LOG_INFO, "\n\rSoak test: report every %lu ms, publishing every %lu ms to topic %u\n\r",
+            (unsigned long)CCM_SOAK_REPORT_INTERVAL, (unsigned long)CCM_SOAK_PUBLISH_INTERVAL, publish_index);
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_soak_event_edge
+ *******************************************************************************
+ * Summary:
+ *  Time stamp of an EVENT pin edge, call from the interrupt handler.
+ *
+ *******************************************************************************/
+void ccm_soak_event_edge(void)
+{
+#if CCM_SOAK
+    edge_ticks = ccm_get_ticks();
+    edge_seen = true;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_soak_message
+ *******************************************************************************
+ * Summary:
+ *  A message was processed: count it and account its latency from the last
+ *  EVENT pin edge.
+ *
+ *******************************************************************************/
+void ccm_soak_message(void)
+{
+#if CCM_SOAK
+    period_messages++;
+
+    if (edge_seen)
+    {
+        uint32_t latency = ccm_ticks_to_us(ccm_get_ticks() - edge_ticks);
+
+        latency_histogram[latency_bucket(latency)]++;
+        latency_count++;
+        if (latency > latency_max)
+        {
+            latency_max = latency;
+        }
+    }
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_soak_process
+ *******************************************************************************
+ * Summary:
+ *  Publish the next soak message and report when due. Call from the main loop,
+ *  between the event drains.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of AT+SEND in milliseconds
+ *
+ * Return:
+ *  uint32_t - ms until the next publish or report, CCM_SOAK_WAIT_FOREVER if
+ *             the soak mode is compiled out.
+ *
+ *******************************************************************************/
+uint32_t ccm_soak_process(uint32_t delay)
+{
+#if CCM_SOAK
+    uint32_t wait = 0;
+    uint32_t elapsed = 0;
+
+    if ((soak_publish_index != 0) && (CCM_SOAK_PUBLISH_INTERVAL > 0))
+    {
+        elapsed = ccm_get_time_ms() - last_publish_time;
+
+        if (elapsed >= CCM_SOAK_PUBLISH_INTERVAL)
+        {
+            publish(delay);
+
+            /* Keep the rate, but do not catch up after a long stall*/
+            last_publish_time = (elapsed >= 2u * CCM_SOAK_PUBLISH_INTERVAL) ? ccm_get_time_ms()
+                                                                            : last_publish_time + CCM_SOAK_PUBLISH_INTERVAL;
+            elapsed = ccm_get_time_ms() - last_publish_time;
+        }
+
+        wait = (elapsed < CCM_SOAK_PUBLISH_INTERVAL) ? (CCM_SOAK_PUBLISH_INTERVAL - elapsed) : 0;
+    }
+    else
+    {
+        wait = CCM_SOAK_REPORT_INTERVAL;
+    }
+
+    elapsed = ccm_get_time_ms() - period_start;
+    if (elapsed >= CCM_SOAK_REPORT_INTERVAL)
+    {
+        ccm_soak_report();
+        elapsed = 0;
+    }
+
+    if (CCM_SOAK_REPORT_INTERVAL - elapsed < wait)
+    {
+        wait = CCM_SOAK_REPORT_INTERVAL - elapsed;
+    }
+
+    return wait;
+#else
+    return CCM_SOAK_WAIT_FOREVER;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: ccm_soak_report
+ *******************************************************************************
+ * Summary:
+ *  Log the statistics of the report interval and start the next one.
+ *
+ *******************************************************************************/
+void ccm_soak_report(void)
+{
+#if CCM_SOAK
+    uint32_t now = ccm_get_time_ms();
+    uint32_t elapsed = now - period_start;
+    uint32_t rate = elapsed ? (uint32_t)(((uint64_t)period_messages * 100000u) / elapsed) : 0; /* messages/s x 100 */
+    uint32_t timeouts = total_timeouts();
+    uint32_t heap_high_water = 0;
+    uint32_t heap_in_use = 0;
+    ccm_memory_stats_t memory_stats;
+
+    total_messages += period_messages;
+    total_published += period_published;
+
+    ccm_get_memory_stats(&memory_stats);
+    memory_budget_heap(&heap_high_water, &heap_in_use);
+
+    CCM_LOG(CCM_LOG_INFO, "\n\rSoak at %lu s: %lu messages, %lu.%02lu msg/s (%lu), published %lu (%lu), %lu failed\n\r",
+            (unsigned long)(now / 1000u), (unsigned long)period_messages, (unsigned long)(rate / 100u),
+            (unsigned long)(rate % 100u), (unsigned long)total_messages, (unsigned long)period_published,
+            (unsigned long)total_published, (unsigned long)period_publish_errors);
+    CCM_LOG(CCM_LOG_INFO, "  latency us: p50 <= %lu, p99 <= %lu, max %lu, %lu samples\n\r",
+            (unsigned long)latency_percentile(50u), (unsigned long)latency_percentile(99u),
+            (unsigned long)latency_max, (unsigned long)latency_count);
+    CCM_LOG(CCM_LOG_INFO, "  UART overruns %lu (%lu), errors %lu (%lu), AT timeouts %lu (%lu)\n\r",
+            (unsigned long)(memory_stats.rx_overruns - last_rx_overruns), (unsigned long)memory_stats.rx_overruns,
+            (unsigned long)(memory_stats.rx_errors - last_rx_errors), (unsigned long)memory_stats.rx_errors,
+            (unsigned long)(timeouts - last_timeouts), (unsigned long)timeouts);
+    CCM_LOG(CCM_LOG_INFO, "  heap high-water %lu bytes, in use %lu bytes, main stack unused %lu bytes\n\r",
+            (unsigned long)heap_high_water, (unsigned long)heap_in_use, (unsigned long)memory_budget_stack_unused());
+
+#if CCM_RTOS
+    TaskStatus_t tasks[CCM_SOAK_TASKS_MAX];
+    UBaseType_t task_count = uxTaskGetSystemState(tasks, CCM_SOAK_TASKS_MAX, NULL);
+
+    for (UBaseType_t i = 0; i < task_count; i++)
+    {
+        CCM_LOG(CCM_LOG_INFO, "  task %s stack unused %lu words\n\r", tasks[i].pcTaskName,
+                (unsigned long)tasks[i].usStackHighWaterMark);
+    }
+#endif
+
+    last_rx_overruns = memory_stats.rx_overruns;
+    last_rx_errors = memory_stats.rx_errors;
+    last_timeouts = timeouts;
+
+    period_start = now;
+    period_messages = 0;
+    period_published = 0;
+    period_publish_errors = 0;
+    latency_count = 0;
+    latency_max = 0;
+    memset(latency_histogram, 0, sizeof(latency_histogram));
+#endif
+}
+
+#if CCM_SOAK
+/* AT+SEND<index> of the next soak message, received back through the subscription */
+static void publish(uint32_t delay)
+{
+    char command[CCM_COMMAND_MAX_LENGTH];
+    int result = 0;
+
+    snprintf(command, sizeof(command), "AT+SEND%u {\"soak\":%lu,\"t\":%lu}\n", soak_publish_index,
+             (unsigned long)++soak_sequence, (unsigned long)ccm_get_time_ms());
+
+    ccm_response_release(at_command_send_receive(command, (int)delay, &result, "OK"));
+
+    if (result)
+    {
+        period_published++;
+    }
+    else
+    {
+        period_publish_errors++;
+    }
+}
+
+/* Four buckets per octave: values 0..3, then the top three bits of the value */
+static uint32_t latency_bucket(uint32_t latency)
+{
+    uint32_t octave = 0;
+    uint32_t bucket = 0;
+
+    if (latency < 4u)
+    {
+        return latency;
+    }
+
+    while ((latency >> (octave + 1u)) != 0)
+    {
+        octave++;
+    }
+
+    bucket = 4u * (octave - 1u) + ((latency >> (octave - 2u)) & 3u);
+
+    return (bucket < LATENCY_BUCKETS) ? bucket : (LATENCY_BUCKETS - 1u);
+}
+
+static uint32_t bucket_upper_bound(uint32_t bucket)
+{
+    uint32_t octave = bucket / 4u + 1u;
+
+    if (bucket < 4u)
+    {
+        return bucket;
+    }
+
+    return ((4u + bucket % 4u + 1u) << (octave - 2u)) - 1u;
+}
+
+/* Upper bound of the bucket holding the percentile, 0 without samples */
+static uint32_t latency_percentile(uint32_t percent)
+{
+    uint32_t target = (latency_count * percent + 99u) / 100u;
+    uint32_t cumulated = 0;
+
+    for (uint32_t i = 0; (i < LATENCY_BUCKETS) && (target > 0); i++)
+    {
+        cumulated += latency_histogram[i];
+        if (cumulated >= target)
+        {
+            return bucket_upper_bound(i);
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t total_timeouts(void)
+{
+    uint32_t timeouts = 0;
+    ccm_timeout_stats_t stats;
+
+    for (uint32_t i = 0; i < CCM_TIMEOUT_CLASS_COUNT; i++)
+    {
+        ccm_timeout_get_stats((ccm_timeout_class_t)i, &stats);
+        timeouts += stats.timeouts;
+    }
+
+    return timeouts;
+}
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * File Name: ccm_soak.h
+ *
+ * Description: This file is the public interface of ccm_soak.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_SOAK_H_
+#define CCM_SOAK_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set to 1 (SOAK=1 in the Makefile) for the soak test mode */
+#ifndef CCM_SOAK
+#define CCM_SOAK (0)
+#endif
+
+/* Interval of the soak reports, ms */
+#ifndef CCM_SOAK_REPORT_INTERVAL
+#define CCM_SOAK_REPORT_INTERVAL (60000u)
+#endif
+
+/* Interval of the messages the device publishes to its own subscribed topic,
+ * ms. 0 to only receive the messages of an external publisher */
+#ifndef CCM_SOAK_PUBLISH_INTERVAL
+#define CCM_SOAK_PUBLISH_INTERVAL (200u)
+#endif
+
+/* Tasks whose stack high-water mark is reported, RTOS build */
+#ifndef CCM_SOAK_TASKS_MAX
+#define CCM_SOAK_TASKS_MAX (8u)
+#endif
+
+/* Returned by ccm_soak_process() when the soak mode is compiled out */
+#define CCM_SOAK_WAIT_FOREVER (0xFFFFFFFFu)
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_soak_init(uint8_t publish_index);
+
+void ccm_soak_event_edge(void);
+
+void ccm_soak_message(void);
+
+uint32_t ccm_soak_process(uint32_t delay);
+
+void ccm_soak_report(void);
+
+#endif /* CCM_SOAK_H_ */
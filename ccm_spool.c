@@ -0,0 +1,542 @@
+/******************************************************************************
+ * File Name: ccm_spool.c
+ *
+ * Description: Message spool in the host flash. The received messages are
+ * appended to a ring of flash rows and consumed later by the application, so
+ * that a slow message handler does not hold up the event drain and pending
+ * messages survive a host reset.
+ *
+ * The rows are written in order of a sequence number that grows with every
+ * new row, which spreads the erase cycles over the whole ring. The row being
+ * filled is kept in RAM and only written (erase and program) while messages
+ * back up: once CCM_SPOOL_SYNC_RECORDS records wait that are in RAM only, or
+ * once a change waited CCM_SPOOL_SYNC_INTERVAL (ccm_spool_process()). Records
+ * consumed before that never reach the flash. Every row write also records
+ * the consumer position, which is found again after a reset from the newest
+ * valid row. Records consumed after the last row write are delivered again
+ * after a reset: process them so that a repeated message is harmless.
+ *
+ * Flash endurance: a row write costs one erase cycle of one row, and the
+ * writes rotate over the CCM_SPOOL_ROWS rows. A consumer keeping up costs no
+ * write. A consumer permanently behind costs one write per
+ * CCM_SPOOL_SYNC_RECORDS messages plus at most one per CCM_SPOOL_SYNC_INTERVAL:
+ * at 10 messages/s that is 1.45 writes/s, with the defaults and the 100 k
+ * cycles per row of the PSoC 6 flash the ring then lasts 32 x 100 k / 1.45 s,
+ * about 25 days of sustained backlog. Size CCM_SPOOL_ROWS and
+ * CCM_SPOOL_SYNC_RECORDS for the expected backlog time of the product.
+ *
+ * The CPU stalls while a row is written: append from the message handler,
+ * once the AT+GET response is complete, and not while a command is in flight.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_spool.h"
+
+#if CCM_SPOOL
+
+#include "CCM.h"
+#include "ccm_config.h"
+#include "ccm_rtos.h"
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "stddef.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define SPOOL_MAGIC (0x43535031u) /* "CSP1" */
+#define SPOOL_ROW_WORDS (CY_FLASH_SIZEOF_ROW / sizeof(uint32_t))
+#define SPOOL_HEADER_SIZE (20u)
+#define SPOOL_DATA_SIZE (CY_FLASH_SIZEOF_ROW - SPOOL_HEADER_SIZE)
+#define SPOOL_CHECKED_HEADER_SIZE (offsetof(spool_row_t, checksum))
+
+#define RECORD_HEADER_SIZE (4u)
+#define RECORD_FLAG_TRUNCATED (0x01u)
+#define RECORD_SIZE(length) ((RECORD_HEADER_SIZE + (length) + 3u) & ~3u)
+
+#if CCM_RTOS
+#error "The spool is used from one context, the RTOS build hands the messages to the application task instead"
+#endif
+
+#if (CCM_SPOOL_ROWS < 2u)
+#error "The spool needs at least 2 rows"
+#endif
+
+#if (RECORD_HEADER_SIZE + CCM_SPOOL_RECORD_MAX > SPOOL_DATA_SIZE)
+#error "CCM_SPOOL_RECORD_MAX does not fit in a flash row"
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;      /* grows by one per new row, 0 is never used */
+    uint32_t tail_sequence; /* consumer position when the row was written */
+    uint16_t tail_offset;
+    uint16_t used;          /* bytes of data holding records */
+    uint32_t checksum;      /* FNV-1a of the fields above and the used data */
+    uint8_t data[SPOOL_DATA_SIZE];
+} spool_row_t;
+
+typedef union
+{
+    spool_row_t row;
+    uint32_t words[SPOOL_ROW_WORDS];
+} spool_buffer_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Emulated EEPROM section of the linker script, next to the configuration
+ * fingerprint row */
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(CY_FLASH_SIZEOF_ROW)
+static const uint32_t spool_flash[CCM_SPOOL_ROWS][SPOOL_ROW_WORDS] = {{0}};
+
+/* Row being filled, and copy of the flash row the consumer reads */
+static spool_buffer_t head_row;
+static spool_buffer_t tail_row;
+static uint32_t head_sequence;
+static uint32_t tail_loaded; /* sequence held by tail_row, 0 for none */
+
+/* Consumer position, and as recorded by the last row write */
+static uint32_t tail_sequence;
+static uint16_t tail_offset;
+static uint32_t synced_tail_sequence;
+static uint16_t synced_tail_offset;
+
+/* End of the records in flash, as of the last row write */
+static uint32_t synced_head_sequence;
+static uint16_t synced_head_used;
+
+/* Records not consumed and not in flash yet */
+static uint32_t unflashed;
+
+/* A change waits for a row write since dirty_time */
+static bool dirty;
+static uint32_t dirty_time;
+
+static cyhal_flash_t spool_flash_obj;
+static bool spool_flash_ready = false;
+static ccm_spool_stats_t spool_stats;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static bool load_row(uint32_t slot, spool_buffer_t *buffer);
+static uint32_t row_checksum(const spool_row_t *row);
+static bool write_head(void);
+static bool advance_head(void);
+static const spool_row_t *tail_row_get(void);
+static bool position_before(uint32_t sequence, uint16_t offset, uint32_t other_sequence, uint16_t other_offset);
+static bool flash_tail_stale(void);
+static void mark_dirty(void);
+
+/*******************************************************************************
+ * Function Name: ccm_spool_init
+ *******************************************************************************
+ * Summary:
+ *  Find the newest valid row and the consumer position recorded in it. The
+ *  records not consumed before the reset are delivered again.
+ *
+ * Return:
+ *  bool - false if the flash can not be written, the spool then only lives
+ *         in RAM until the row being filled is full.
+ *
+ *******************************************************************************/
+bool ccm_spool_init(void)
+{
+    uint32_t newest = 0;
+
+    spool_flash_ready = (CY_RSLT_SUCCESS == cyhal_flash_init(&spool_flash_obj));
+
+    for (uint32_t slot = 0; slot < CCM_SPOOL_ROWS; slot++)
+    {
+        if (load_row(slot, &tail_row) && (tail_row.row.sequence > newest))
+        {
+            newest = tail_row.row.sequence;
+        }
+    }
+
+    tail_loaded = 0;
+
+    if (newest == 0)
+    {
+        memset(&head_row, 0, sizeof(head_row));
+        head_sequence = 1;
+        tail_sequence = 1;
+        tail_offset = 0;
+    }
+    else
+    {
+        /* Go on filling the newest row */
+        load_row(newest % CCM_SPOOL_ROWS, &head_row);
+        head_sequence = newest;
+
+        /* Walk back to the recorded consumer position over the intact rows */
+        uint32_t sequence = newest;
+        while ((sequence > head_row.row.tail_sequence) && (sequence > 1) &&
+               ((newest - sequence + 1) < CCM_SPOOL_ROWS) &&
+               load_row((sequence - 1) % CCM_SPOOL_ROWS, &tail_row) &&
+               (tail_row.row.sequence == sequence - 1))
+        {
+            sequence--;
+        }
+
+        tail_sequence = sequence;
+        tail_offset = (sequence == head_row.row.tail_sequence) ? head_row.row.tail_offset : 0;
+        tail_loaded = 0;
+    }
+
+    synced_tail_sequence = tail_sequence;
+    synced_tail_offset = tail_offset;
+    synced_head_sequence = head_sequence;
+    synced_head_used = head_row.row.used;
+    unflashed = 0;
+    dirty = false;
+
+    spool_stats.rows_used = head_sequence - tail_sequence + 1;
+
+    return spool_flash_ready;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_spool_append
+ *******************************************************************************
+ * Summary:
+ *  Append a message. The row is written to flash once CCM_SPOOL_SYNC_RECORDS
+ *  records wait in RAM only, and when it is full and holds such records.
+ *
+ * input parameter: uint8_t index
+ *                  CCM topic index of the message
+ *
+ * input parameter: const uint8_t *data, uint16_t length
+ *                  Message, truncated to CCM_SPOOL_RECORD_MAX
+ *
+ * Return:
+ *  bool - false if the spool is full, the message is dropped.
+ *
+ *******************************************************************************/
+bool ccm_spool_append(uint8_t index, const uint8_t *data, uint16_t length)
+{
+    uint8_t flags = 0;
+
+    if (length > CCM_SPOOL_RECORD_MAX)
+    {
+        length = CCM_SPOOL_RECORD_MAX;
+        flags |= RECORD_FLAG_TRUNCATED;
+    }
+
+    if ((head_row.row.used + RECORD_SIZE(length) > SPOOL_DATA_SIZE) && !advance_head())
+    {
+        spool_stats.dropped++;
+        return false;
+    }
+
+    uint8_t *record = &head_row.row.data[head_row.row.used];
+
+    record[0] = (uint8_t)length;
+    record[1] = (uint8_t)(length >> 8);
+    record[2] = index;
+    record[3] = flags;
+    memcpy(&record[RECORD_HEADER_SIZE], data, length);
+
+    head_row.row.used += RECORD_SIZE(length);
+    spool_stats.appended++;
+
+    unflashed++;
+    mark_dirty();
+
+    /* The consumer is behind, keep the backlog across a reset */
+    if (unflashed >= CCM_SPOOL_SYNC_RECORDS)
+    {
+        write_head();
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_spool_peek
+ *******************************************************************************
+ * Summary:
+ *  Oldest record not consumed yet. Rows found corrupted are skipped.
+ *
+ * Return:
+ *  bool - false if the spool is empty.
+ *
+ *******************************************************************************/
+bool ccm_spool_peek(ccm_spool_record_t *record)
+{
+    const spool_row_t *row = NULL;
+
+    while (1)
+    {
+        row = tail_row_get();
+
+        if ((row != NULL) && ((tail_offset + RECORD_HEADER_SIZE) <= row->used))
+        {
+            break;
+        }
+
+        if (tail_sequence == head_sequence)
+        {
+            return false;
+        }
+
+        tail_sequence++;
+        tail_offset = 0;
+    }
+
+    const uint8_t *header = &row->data[tail_offset];
+    uint16_t length = (uint16_t)(header[0] | (header[1] << 8));
+    uint16_t available = row->used - tail_offset - RECORD_HEADER_SIZE;
+
+    record->data = &header[RECORD_HEADER_SIZE];
+    record->length = (length < available) ? length : available;
+    record->index = header[2];
+    record->truncated = (header[3] & RECORD_FLAG_TRUNCATED) != 0;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_spool_consume
+ *******************************************************************************
+ * Summary:
+ *  Remove the record returned by ccm_spool_peek(). The new position reaches
+ *  the flash with the next row write, a record that never reached the flash
+ *  needs none.
+ *
+ *******************************************************************************/
+void ccm_spool_consume(void)
+{
+    ccm_spool_record_t record;
+
+    if (!ccm_spool_peek(&record))
+    {
+        return;
+    }
+
+    bool in_flash = position_before(tail_sequence, tail_offset, synced_head_sequence, synced_head_used);
+
+    tail_offset += RECORD_SIZE(record.length);
+    spool_stats.consumed++;
+
+    if (!in_flash)
+    {
+        unflashed--;
+    }
+
+    if ((unflashed == 0) && !flash_tail_stale())
+    {
+        /* Flash and RAM agree on what is left to process */
+        dirty = false;
+    }
+    else
+    {
+        mark_dirty();
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_spool_sync
+ *******************************************************************************
+ * Summary:
+ *  Write the row being filled and the consumer position to flash now if
+ *  records wait in RAM only or the flash would deliver consumed records again.
+ *  Call before a host reset.
+ *
+ * Return:
+ *  bool - false if the flash write failed.
+ *
+ *******************************************************************************/
+bool ccm_spool_sync(void)
+{
+    if (!dirty)
+    {
+        return true;
+    }
+
+    return write_head();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_spool_process
+ *******************************************************************************
+ * Summary:
+ *  Write the row once a change waited CCM_SPOOL_SYNC_INTERVAL. Call from the
+ *  main loop.
+ *
+ * Return:
+ *  uint32_t - ms until the next row write is due, CCM_SPOOL_WAIT_FOREVER if
+ *             nothing waits for one.
+ *
+ *******************************************************************************/
+uint32_t ccm_spool_process(void)
+{
+    uint32_t elapsed = 0;
+
+    if (!dirty)
+    {
+        return CCM_SPOOL_WAIT_FOREVER;
+    }
+
+    elapsed = ccm_get_time_ms() - dirty_time;
+    if (elapsed < CCM_SPOOL_SYNC_INTERVAL)
+    {
+        return CCM_SPOOL_SYNC_INTERVAL - elapsed;
+    }
+
+    if (!write_head())
+    {
+        /* Try again in CCM_SPOOL_SYNC_INTERVAL */
+        dirty_time = ccm_get_time_ms();
+        return CCM_SPOOL_SYNC_INTERVAL;
+    }
+
+    return CCM_SPOOL_WAIT_FOREVER;
+}
+
+void ccm_spool_get_stats(ccm_spool_stats_t *stats)
+{
+    spool_stats.rows_used = head_sequence - tail_sequence + 1;
+    *stats = spool_stats;
+}
+
+/* Copy a flash row to RAM, true if it holds a valid row */
+static bool load_row(uint32_t slot, spool_buffer_t *buffer)
+{
+    const volatile uint32_t *flash = spool_flash[slot];
+
+    for (uint32_t i = 0; i < SPOOL_ROW_WORDS; i++)
+    {
+        buffer->words[i] = flash[i];
+    }
+
+    return (buffer->row.magic == SPOOL_MAGIC) && (buffer->row.sequence != 0) &&
+           ((buffer->row.sequence % CCM_SPOOL_ROWS) == slot) && (buffer->row.used <= SPOOL_DATA_SIZE) &&
+           (buffer->row.checksum == row_checksum(&buffer->row));
+}
+
+static uint32_t row_checksum(const spool_row_t *row)
+{
+    uint32_t hash = ccm_fnv1a(CCM_FNV1A_INIT, row, SPOOL_CHECKED_HEADER_SIZE);
+
+    return ccm_fnv1a(hash, row->data, row->used);
+}
+
+/*******************************************************************************
+ * Function Name: write_head
+ *******************************************************************************
+ * Summary:
+ *  Write the row being filled to its flash slot, with the consumer position.
+ *
+ *******************************************************************************/
+static bool write_head(void)
+{
+    uint32_t slot = head_sequence % CCM_SPOOL_ROWS;
+
+    head_row.row.magic = SPOOL_MAGIC;
+    head_row.row.sequence = head_sequence;
+    head_row.row.tail_sequence = tail_sequence;
+    head_row.row.tail_offset = tail_offset;
+    head_row.row.checksum = row_checksum(&head_row.row);
+
+    if (!spool_flash_ready ||
+        (CY_RSLT_SUCCESS != cyhal_flash_write(&spool_flash_obj, (uint32_t)(uintptr_t)spool_flash[slot], head_row.words)))
+    {
+        spool_stats.write_errors++;
+        return false;
+    }
+
+    synced_tail_sequence = tail_sequence;
+    synced_tail_offset = tail_offset;
+    synced_head_sequence = head_sequence;
+    synced_head_used = head_row.row.used;
+    unflashed = 0;
+    dirty = false;
+    spool_stats.row_writes++;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: advance_head
+ *******************************************************************************
+ * Summary:
+ *  The row being filled is full: write it and start the next one, unless
+ *  that would overwrite a row not consumed yet. A row whose records were all
+ *  consumed or are in flash already is not written again.
+ *
+ *******************************************************************************/
+static bool advance_head(void)
+{
+    if ((head_sequence - tail_sequence + 2) > CCM_SPOOL_ROWS)
+    {
+        return false;
+    }
+
+    if ((unflashed > 0) && !write_head())
+    {
+        return false;
+    }
+
+    head_sequence++;
+    memset(&head_row, 0, sizeof(head_row));
+
+    return true;
+}
+
+/* Row the consumer reads: the RAM row being filled or a copy of a flash row,
+ * NULL if that flash row is corrupted */
+static const spool_row_t *tail_row_get(void)
+{
+    if (tail_sequence == head_sequence)
+    {
+        return &head_row.row;
+    }
+
+    if (tail_loaded != tail_sequence)
+    {
+        tail_loaded = 0;
+        if (!load_row(tail_sequence % CCM_SPOOL_ROWS, &tail_row) || (tail_row.row.sequence != tail_sequence))
+        {
+            return NULL;
+        }
+        tail_loaded = tail_sequence;
+    }
+
+    return &tail_row.row;
+}
+
+/* Whether position (sequence, offset) is before (other_sequence, other_offset) */
+static bool position_before(uint32_t sequence, uint16_t offset, uint32_t other_sequence, uint16_t other_offset)
+{
+    return (sequence < other_sequence) || ((sequence == other_sequence) && (offset < other_offset));
+}
+
+/* The flash would deliver records again that were consumed since */
+static bool flash_tail_stale(void)
+{
+    return position_before(synced_tail_sequence, synced_tail_offset, synced_head_sequence, synced_head_used) &&
+           position_before(synced_tail_sequence, synced_tail_offset, tail_sequence, tail_offset);
+}
+
+static void mark_dirty(void)
+{
+    if (!dirty)
+    {
+        dirty = true;
+        dirty_time = ccm_get_time_ms();
+    }
+}
+
+#endif /* CCM_SPOOL */
+
+/* [] END OF FILE */
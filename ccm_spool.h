@@ -0,0 +1,92 @@
+/******************************************************************************
+ * File Name: ccm_spool.h
+ *
+ * Description: This file is the public interface of ccm_spool.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_SPOOL_H_
+#define CCM_SPOOL_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set to 1 to spool the received messages in flash and process them from the
+ * main loop (bare metal build, see the SPOOL variable of the Makefile) */
+#ifndef CCM_SPOOL
+#define CCM_SPOOL (0)
+#endif
+
+/* Flash rows of the spool, a ring in the emulated EEPROM section */
+#ifndef CCM_SPOOL_ROWS
+#define CCM_SPOOL_ROWS (32u)
+#endif
+
+/* The row being filled is written to flash once this many messages wait
+ * unprocessed in RAM only, or once one of them waited CCM_SPOOL_SYNC_INTERVAL.
+ * Messages processed before that never reach the flash: a consumer keeping up
+ * causes no flash writes. A host reset loses the messages waiting in RAM only,
+ * 1 makes every message survive it at the cost of a row write per message */
+#ifndef CCM_SPOOL_SYNC_RECORDS
+#define CCM_SPOOL_SYNC_RECORDS (8u)
+#endif
+
+/* Longest time a change of the spool stays in RAM only, ms */
+#ifndef CCM_SPOOL_SYNC_INTERVAL
+#define CCM_SPOOL_SYNC_INTERVAL (5000u)
+#endif
+
+/* Returned by ccm_spool_process() when nothing is waiting for a row write */
+#define CCM_SPOOL_WAIT_FOREVER (0xFFFFFFFFu)
+
+/* Longest message stored, longer messages are truncated. A record never spans
+ * two rows: flash row size - row header - record header. */
+#define CCM_SPOOL_RECORD_MAX (488u)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Oldest record not consumed yet, data is valid until the next spool call */
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t length;
+    uint8_t index;  /* CCM topic index */
+    bool truncated; /* longer than CCM_SPOOL_RECORD_MAX */
+} ccm_spool_record_t;
+
+typedef struct
+{
+    uint32_t appended;     /* records since boot */
+    uint32_t consumed;     /* records since boot */
+    uint32_t dropped;      /* spool full, record not stored */
+    uint32_t row_writes;   /* flash row writes since boot */
+    uint32_t write_errors; /* failed flash row writes */
+    uint32_t rows_used;    /* rows holding records not consumed, the row being filled included */
+} ccm_spool_stats_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+bool ccm_spool_init(void);
+
+bool ccm_spool_append(uint8_t index, const uint8_t *data, uint16_t length);
+
+bool ccm_spool_peek(ccm_spool_record_t *record);
+
+void ccm_spool_consume(void);
+
+bool ccm_spool_sync(void);
+
+uint32_t ccm_spool_process(void);
+
+void ccm_spool_get_stats(ccm_spool_stats_t *stats);
+
+#endif /* CCM_SPOOL_H_ */
@@ -0,0 +1,210 @@
+/******************************************************************************
+ * File Name: ccm_stats.c
+ *
+ * Description: Latency and throughput instrumentation of the AT link. Every
+ * command exchange is accounted per command table entry: send time, time to
+ * the first response byte, time to the complete response, bytes in and out,
+ * timeouts and error responses. The receive timestamps are taken by the UART
+ * interrupt from the low power timer, which keeps counting in deep sleep
+ * (unlike the CPU cycle counter), and are dumped on demand over the debug
+ * UART with ccm_stats_dump().
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_stats.h"
+#include "ccm_log.h"
+#include "inttypes.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static ccm_stats_entry_t stats_entries[CCM_CMD_COUNT + 1];
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void account_latency(uint32_t latency, uint32_t count, uint32_t *minimum, uint32_t *maximum, uint64_t *total);
+
+/*******************************************************************************
+ * Function Name: account_latency
+ *******************************************************************************
+ * Summary:
+ *  Update minimum, maximum and total of a latency already counted in count.
+ *
+ *******************************************************************************/
+static void account_latency(uint32_t latency, uint32_t count, uint32_t *minimum, uint32_t *maximum, uint64_t *total)
+{
+    if ((count == 1) || (latency < *minimum))
+    {
+        *minimum = latency;
+    }
+
+    if (latency > *maximum)
+    {
+        *maximum = latency;
+    }
+
+    *total += latency;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_stats_record
+ *******************************************************************************
+ * Summary:
+ *  Account one command exchange.
+ *
+ * input parameter: uint8_t command
+ *                  ccm_command_id_t of the command, CCM_STATS_OTHER for a
+ *                  command sent as string
+ *
+ * input parameter: const ccm_stats_sample_t *sample
+ *                  Measurements of the exchange
+ *
+ *******************************************************************************/
+void ccm_stats_record(uint8_t command, const ccm_stats_sample_t *sample)
+{
+    if (!CCM_STATS || (command > CCM_STATS_OTHER))
+    {
+        return;
+    }
+
+    ccm_stats_entry_t *entry = &stats_entries[command];
+    uint32_t send_ms = ccm_get_time_ms() - (ccm_ticks_to_us(ccm_get_ticks() - sample->send_ticks) / 1000u);
+
+    if ((entry->count == 0) && (entry->timeouts == 0))
+    {
+        entry->first_send_ms = send_ms;
+    }
+    entry->last_send_ms = send_ms;
+
+    entry->bytes_out += sample->bytes_out;
+    entry->bytes_in += sample->bytes_in;
+
+    if (sample->timed_out)
+    {
+        entry->timeouts++;
+        return;
+    }
+
+    if (sample->error)
+    {
+        entry->errors++;
+    }
+
+    entry->count++;
+
+    account_latency(ccm_ticks_to_us(sample->first_byte_ticks - sample->send_ticks), entry->count,
+                    &entry->first_byte_min, &entry->first_byte_max, &entry->first_byte_total);
+
+    account_latency(ccm_ticks_to_us(sample->done_ticks - sample->send_ticks), entry->count,
+                    &entry->response_min, &entry->response_max, &entry->response_total);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_stats_record_response
+ *******************************************************************************
+ * Summary:
+ *  Account the exchange of a command answered by a single response line.
+ *
+ * input parameter: uint8_t command
+ *                  ccm_command_id_t of the command, CCM_STATS_OTHER for a
+ *                  command sent as string
+ *
+ * input parameter: uint16_t bytes_out
+ *                  Length of the command sent
+ *
+ * input parameter: uint32_t send_ticks
+ *                  ccm_get_ticks() just before the command was sent
+ *
+ * input parameter: const ccm_response_t *response
+ *                  Response received, the empty response on timeout
+ *
+ *******************************************************************************/
+void ccm_stats_record_response(uint8_t command, uint16_t bytes_out, uint32_t send_ticks, const ccm_response_t *response)
+{
+    ccm_stats_sample_t sample = {
+        .send_ticks = send_ticks,
+        .first_byte_ticks = response->rx_start_ticks,
+        .done_ticks = response->rx_end_ticks,
+        .bytes_out = bytes_out,
+        .bytes_in = response->length,
+        .timed_out = (response->slot == CCM_RESPONSE_NO_SLOT),
+        .error = !strncmp(response->data, "ERR", 3)};
+
+    ccm_stats_record(command, &sample);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_stats_get
+ *******************************************************************************
+ * Summary:
+ *  Statistics of a command, NULL if command is out of range.
+ *
+ *******************************************************************************/
+const ccm_stats_entry_t *ccm_stats_get(uint8_t command)
+{
+    return (command <= CCM_STATS_OTHER) ? &stats_entries[command] : NULL;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_stats_reset
+ *******************************************************************************
+ * Summary:
+ *  Clear the statistics, for example before measuring a CCM firmware update.
+ *
+ *******************************************************************************/
+void ccm_stats_reset(void)
+{
+    memset(stats_entries, 0, sizeof(stats_entries));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_stats_dump
+ *******************************************************************************
+ * Summary:
+ *  Log the statistics of every command used so far at CCM_LOG_INFO, one line
+ *  per command. Latencies are min/avg/max in microseconds. The log is drained
+ *  after every line, the dump is longer than the log ring.
+ *
+ *******************************************************************************/
+void ccm_stats_dump(void)
+{
+    if (!CCM_STATS)
+    {
+        return;
+    }
+
+    CCM_LOG(CCM_LOG_INFO, "\n\rAT link statistics at %" PRIu32 " ms\n\r", ccm_get_time_ms());
+    CCM_LOG(CCM_LOG_INFO, "command               count tmo err first(ms) last(ms) first byte(us) response(us) out in\n\r");
+    ccm_log_flush();
+
+    for (uint8_t i = 0; i <= CCM_STATS_OTHER; i++)
+    {
+        const ccm_stats_entry_t *entry = &stats_entries[i];
+        uint32_t count = (entry->count > 0) ? entry->count : 1;
+
+        if ((entry->count == 0) && (entry->timeouts == 0))
+        {
+            continue;
+        }
+
+        /* Table commands are printed without their '\n' */
+        const char *name = (i < CCM_STATS_OTHER) ? ccm_commands[i].command : "(other)";
+        int name_length = (i < CCM_STATS_OTHER) ? (ccm_commands[i].length - 1) : (int)strlen(name);
+
+        CCM_LOG(CCM_LOG_INFO, "%-21.*s %5" PRIu32 " %3" PRIu32 " %3" PRIu32 " %8" PRIu32 " %8" PRIu32
+                " %" PRIu32 "/%" PRIu32 "/%" PRIu32 " %" PRIu32 "/%" PRIu32 "/%" PRIu32
+                " %" PRIu32 " %" PRIu32 "\n\r",
+                name_length, name, entry->count, entry->timeouts, entry->errors, entry->first_send_ms,
+                entry->last_send_ms, entry->first_byte_min, (uint32_t)(entry->first_byte_total / count),
+                entry->first_byte_max, entry->response_min, (uint32_t)(entry->response_total / count),
+                entry->response_max, entry->bytes_out, entry->bytes_in);
+        ccm_log_flush();
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+/******************************************************************************
+ * File Name: ccm_stats.h
+ *
+ * Description: This file is the public interface of ccm_stats.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_STATS_H_
+#define CCM_STATS_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set to 0 to compile out the AT link instrumentation */
+#ifndef CCM_STATS
+#define CCM_STATS (1)
+#endif
+
+/* Entry accounting the commands sent as strings, not from the command table */
+#define CCM_STATS_OTHER (CCM_CMD_COUNT)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Exchange of one AT command, times in ccm_get_ticks() units */
+typedef struct
+{
+    uint32_t send_ticks;       /* command written to the UART */
+    uint32_t first_byte_ticks; /* first byte of the response received */
+    uint32_t done_ticks;       /* response line complete */
+    uint16_t bytes_out;
+    uint16_t bytes_in;
+    bool timed_out;
+    bool error;                /* "ERRnn" response */
+} ccm_stats_sample_t;
+
+/* Accumulated statistics of one command, latencies in microseconds */
+typedef struct
+{
+    uint32_t count;
+    uint32_t timeouts;
+    uint32_t errors;
+    uint32_t first_send_ms; /* ccm_get_time_ms() of the first and last send */
+    uint32_t last_send_ms;
+    uint32_t first_byte_min;
+    uint32_t first_byte_max;
+    uint64_t first_byte_total;
+    uint32_t response_min;
+    uint32_t response_max;
+    uint64_t response_total;
+    uint32_t bytes_out;
+    uint32_t bytes_in;
+} ccm_stats_entry_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_stats_record(uint8_t command, const ccm_stats_sample_t *sample);
+
+void ccm_stats_record_response(uint8_t command, uint16_t bytes_out, uint32_t send_ticks, const ccm_response_t *response);
+
+const ccm_stats_entry_t *ccm_stats_get(uint8_t command);
+
+void ccm_stats_reset(void);
+
+void ccm_stats_dump(void);
+
+#endif /* CCM_STATS_H_ */
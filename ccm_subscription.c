@@ -0,0 +1,514 @@
+/******************************************************************************
+ * File Name: ccm_subscription.c
+ *
+ * Description: Subscription registry. Every topic slot has its own handler and
+ * optional message buffer. The topic configuration and subscribe commands of
+ * all the slots are pipelined at startup, and a MSG event is routed by its
+ * topic index straight to AT+GET<index> of the right slot.
+ *
+ * A batched slot defers its fetches: the MSG events of a drain are counted,
+ * and once the drain is complete the pending messages are fetched back to
+ * back and passed to the handler as one batch. With latest-value-wins
+ * coalescing only the newest of them reaches the handler.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_subscription.h"
+#include "ccm_command_queue.h"
+#include "ccm_config.h"
+#include "ccm_event.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* AT+GET<n> and AT+SUBSCRIBE<n> of every slot come from the command table */
+#if (CCM_SUBSCRIPTION_MAX > CCM_COMMAND_TOPIC_COUNT)
+#error "CCM_SUBSCRIPTION_MAX exceeds the topic commands of the command table"
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    const char *topic;
+    ccm_subscription_handler_t handler;
+    ccm_subscription_batch_handler_t batch_handler;
+    void *arg;
+    uint8_t *buffer;
+    uint16_t buffer_size;
+    uint16_t buffer_length;
+    uint16_t message_start; /* offset of the message being received */
+    uint16_t pending;       /* MSG events of a batched slot not fetched yet */
+    ccm_coalesce_t coalesce;
+    bool receiving;         /* payload of the current AT+GET<index> started */
+    bool truncated;
+    uint8_t index;
+} subscription_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Slot n of the CCM is subscriptions[n - 1] */
+static subscription_t subscriptions[CCM_SUBSCRIPTION_MAX];
+
+/* Batch being collected, one slot is fetched at a time */
+static ccm_message_t batch[CCM_SUBSCRIPTION_BATCH_MAX];
+static uint8_t batch_count;
+
+static ccm_subscription_stats_t subscription_stats;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void message_event_handler(ccm_response_t *event);
+static void message_chunk_handler(const uint8_t *chunk, uint16_t length, bool last, bool ok, void *arg);
+static void batch_chunk_handler(const uint8_t *chunk, uint16_t length, bool last, bool ok, void *arg);
+static bool fetch_batch(subscription_t *subscription, uint32_t delay);
+static void deliver_batch(subscription_t *subscription, uint8_t count);
+static void drain_handler(void);
+static bool submit_topic(const subscription_t *subscription, uint32_t delay, bool *acknowledged);
+
+/*******************************************************************************
+ * Function Name: ccm_subscription_register
+ *******************************************************************************
+ * Summary:
+ *  Register a topic slot. The topic is configured and subscribed to by
+ *  ccm_subscription_start().
+ *
+ * input parameter: uint8_t index
+ *                  CCM topic index, 1..CCM_SUBSCRIPTION_MAX
+ *
+ * input parameter: const char *topic
+ *                  Topic name, must stay valid
+ *
+ * input parameter: ccm_subscription_handler_t handler
+ *                  Receives the messages of the topic
+ *
+ * input parameter: void *arg
+ *                  Passed to the handler unchanged
+ *
+ * input parameter: uint8_t *buffer, uint16_t buffer_size
+ *                  Message buffer of the slot, NULL to stream the messages
+ *
+ * Return:
+ *  bool - false if the index is out of range.
+ *
+ *******************************************************************************/
+bool ccm_subscription_register(uint8_t index, const char *topic, ccm_subscription_handler_t handler,
+                               void *arg, uint8_t *buffer, uint16_t buffer_size)
+{
+    if ((index == 0) || (index > CCM_SUBSCRIPTION_MAX))
+    {
+        return false;
+    }
+
+    subscription_t *subscription = &subscriptions[index - 1];
+
+    memset(subscription, 0, sizeof(*subscription));
+    subscription->topic = topic;
+    subscription->handler = handler;
+    subscription->arg = arg;
+    subscription->buffer = buffer;
+    subscription->buffer_size = (buffer != NULL) ? buffer_size : 0;
+    subscription->index = index;
+
+    ccm_event_register(CCM_EVENT_MSG, CCM_EVENT_ID_ANY, message_event_handler);
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_subscription_register_batch
+ *******************************************************************************
+ * Summary:
+ *  Register a batched topic slot. The messages announced by the MSG events of
+ *  a drain are fetched once the drain is complete and passed together.
+ *
+ * input parameter: uint8_t index
+ *                  CCM topic index, 1..CCM_SUBSCRIPTION_MAX
+ *
+ * input parameter: const char *topic
+ *                  Topic name, must stay valid
+ *
+ * input parameter: ccm_subscription_batch_handler_t handler
+ *                  Receives the batches of the topic
+ *
+ * input parameter: void *arg
+ *                  Passed to the handler unchanged
+ *
+ * input parameter: uint8_t *buffer, uint16_t buffer_size
+ *                  Holds the messages of a batch. A message not fitting into
+ *                  the rest of it starts a new batch, only a message longer
+ *                  than the whole buffer is truncated.
+ *
+ * input parameter: ccm_coalesce_t coalesce
+ *                  CCM_COALESCE_LATEST to pass only the newest message
+ *
+ * Return:
+ *  bool - false if the index is out of range or there is no buffer.
+ *
+ *******************************************************************************/
+bool ccm_subscription_register_batch(uint8_t index, const char *topic, ccm_subscription_batch_handler_t handler,
+                                     void *arg, uint8_t *buffer, uint16_t buffer_size, ccm_coalesce_t coalesce)
+{
+    if ((buffer == NULL) || (buffer_size == 0) ||
+        !ccm_subscription_register(index, topic, NULL, arg, buffer, buffer_size))
+    {
+        return false;
+    }
+
+    subscription_t *subscription = &subscriptions[index - 1];
+
+    subscription->batch_handler = handler;
+    subscription->coalesce = coalesce;
+
+    ccm_event_set_drain_handler(drain_handler);
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_subscription_start
+ *******************************************************************************
+ * Summary:
+ *  Configure and subscribe every registered topic. The commands of all the
+ *  slots are sent in one pipelined batch; when the command queue is full, the
+ *  queued ones are sent first.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of each command in milliseconds
+ *
+ * Return:
+ *  bool - true if every command was queued and acknowledged.
+ *
+ *******************************************************************************/
+bool ccm_subscription_start(uint32_t delay)
+{
+    bool submitted = true;
+    bool acknowledged = true;
+
+    for (uint8_t i = 0; i < CCM_SUBSCRIPTION_MAX; i++)
+    {
+        subscription_t *subscription = &subscriptions[i];
+
+        if (subscription->topic == NULL)
+        {
+            continue;
+        }
+
+        if (!submit_topic(subscription, delay, &acknowledged))
+        {
+            CCM_LOG(CCM_LOG_ERROR, "\nTopic %u not subscribed, command not queued\n\r", subscription->index);
+            submitted = false;
+        }
+    }
+
+    acknowledged = ccm_command_queue_flush() && acknowledged;
+
+    return submitted && acknowledged;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_subscription_fetch
+ *******************************************************************************
+ * Summary:
+ *  Receive the next message of a topic slot with AT+GET<index> and pass it to
+ *  the handler of the slot. A batched slot also fetches its pending messages.
+ *
+ * input parameter: uint8_t index
+ *                  CCM topic index
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout in milliseconds
+ *
+ * Return:
+ *  bool - true if a message was received completely.
+ *
+ *******************************************************************************/
+bool ccm_subscription_fetch(uint8_t index, uint32_t delay)
+{
+    if ((index == 0) || (index > CCM_SUBSCRIPTION_MAX) || (subscriptions[index - 1].topic == NULL))
+    {
+        return false;
+    }
+
+    subscription_t *subscription = &subscriptions[index - 1];
+
+    if (subscription->batch_handler)
+    {
+        subscription->pending++;
+        return fetch_batch(subscription, delay);
+    }
+
+    subscription->buffer_length = 0;
+    subscription->truncated = false;
+
+    /*AT command to receive the message from the subscribed topic,
+     * the payload is processed chunk by chunk while it is received */
+    return (1 == at_command_execute_stream(CCM_CMD_GET(index), delay, message_chunk_handler, subscription));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_subscription_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Message and batch counters since boot.
+ *
+ *******************************************************************************/
+void ccm_subscription_get_stats(ccm_subscription_stats_t *stats)
+{
+    *stats = subscription_stats;
+}
+
+/*******************************************************************************
+ * Function Name: message_chunk_handler
+ *******************************************************************************
+ * Summary:
+ *  Pass the chunks of a message to the handler of its slot, or collect them in
+ *  the slot buffer.
+ *
+ *******************************************************************************/
+static void message_chunk_handler(const uint8_t *chunk, uint16_t length, bool last, bool ok, void *arg)
+{
+    subscription_t *subscription = (subscription_t *)arg;
+
+    if (last)
+    {
+        subscription_stats.messages++;
+    }
+
+    if (subscription->buffer == NULL)
+    {
+        subscription->handler(subscription->index, chunk, length, last, ok, subscription->arg);
+        return;
+    }
+
+    uint16_t space = subscription->buffer_size - subscription->buffer_length;
+    uint16_t copy = (length < space) ? length : space;
+
+    if (copy < length)
+    {
+        subscription->truncated = true;
+    }
+
+    if (copy > 0)
+    {
+        memcpy(&subscription->buffer[subscription->buffer_length], chunk, copy);
+        subscription->buffer_length += copy;
+    }
+
+    if (last)
+    {
+        subscription->handler(subscription->index, subscription->buffer, subscription->buffer_length,
+                              true, ok && !subscription->truncated, subscription->arg);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: message_event_handler
+ *******************************************************************************
+ * Summary:
+ *  MSG event, the event id is the index of the topic with a new message.
+ *
+ *******************************************************************************/
+static void message_event_handler(ccm_response_t *event)
+{
+    uint8_t index = event->event_id;
+
+    CCM_LOG(CCM_LOG_INFO, "\nNew message notification on the subscribed topic %u\n\n\r", index);
+
+    /* Batched slot: fetched by drain_handler() with the other pending messages */
+    if ((index > 0) && (index <= CCM_SUBSCRIPTION_MAX) && subscriptions[index - 1].batch_handler)
+    {
+        if (subscriptions[index - 1].pending < UINT16_MAX)
+        {
+            subscriptions[index - 1].pending++;
+        }
+        return;
+    }
+
+    if (!ccm_subscription_fetch(event->event_id, CCM_SUBSCRIPTION_FETCH_DELAY))
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nMessage of topic %u not received\n\r", event->event_id);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: drain_handler
+ *******************************************************************************
+ * Summary:
+ *  End of an event drain, fetch the pending messages of the batched slots.
+ *
+ *******************************************************************************/
+static void drain_handler(void)
+{
+    for (uint8_t i = 0; i < CCM_SUBSCRIPTION_MAX; i++)
+    {
+        subscription_t *subscription = &subscriptions[i];
+
+        if ((subscription->pending > 0) && !fetch_batch(subscription, CCM_SUBSCRIPTION_FETCH_DELAY))
+        {
+            CCM_LOG(CCM_LOG_WARN, "\nMessages of topic %u not received\n\r", subscription->index);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: fetch_batch
+ *******************************************************************************
+ * Summary:
+ *  Fetch the pending messages of a batched slot with AT+GET<index> back to
+ *  back and pass them to its handler. Stops early if the CCM module has no
+ *  message left. With CCM_COALESCE_LATEST every message replaces the previous
+ *  one in the buffer and only the last one is passed.
+ *
+ * Return:
+ *  bool - false if an AT+GET<index> failed.
+ *
+ *******************************************************************************/
+static bool fetch_batch(subscription_t *subscription, uint32_t delay)
+{
+    bool latest = (subscription->coalesce == CCM_COALESCE_LATEST);
+    bool success = true;
+
+    subscription->buffer_length = 0;
+    batch_count = 0;
+
+    while (subscription->pending > 0)
+    {
+        /* Pass a full batch before fetching more */
+        if (!latest && ((batch_count == CCM_SUBSCRIPTION_BATCH_MAX) ||
+                        (subscription->buffer_length == subscription->buffer_size)))
+        {
+            deliver_batch(subscription, batch_count);
+            batch_count = 0;
+            subscription->buffer_length = 0;
+        }
+
+        subscription->pending--;
+        subscription->receiving = false;
+        subscription->truncated = false;
+
+        success = (1 == at_command_execute_stream(CCM_CMD_GET(subscription->index), delay,
+                                                  batch_chunk_handler, subscription));
+
+        /* No payload: no message left, or the command failed */
+        if (!subscription->receiving)
+        {
+            break;
+        }
+
+        if (latest && (batch_count > 0))
+        {
+            subscription_stats.coalesced++;
+            batch_count = 0;
+        }
+
+        batch[batch_count].data = &subscription->buffer[subscription->message_start];
+        batch[batch_count].length = subscription->buffer_length - subscription->message_start;
+        batch[batch_count].truncated = subscription->truncated || !success;
+        batch_count++;
+
+        subscription_stats.messages++;
+    }
+
+    subscription->pending = 0;
+
+    if (batch_count > 0)
+    {
+        deliver_batch(subscription, batch_count);
+    }
+
+    return success;
+}
+
+/*******************************************************************************
+ * Function Name: batch_chunk_handler
+ *******************************************************************************
+ * Summary:
+ *  Append the chunks of a message to the batch in the slot buffer. A message
+ *  not fitting behind the earlier messages of the batch makes them pass first
+ *  and moves to the start of the buffer. With CCM_COALESCE_LATEST the first
+ *  chunk of a message discards the previous message, an empty response
+ *  leaves it in place.
+ *
+ *******************************************************************************/
+static void batch_chunk_handler(const uint8_t *chunk, uint16_t length, bool last, bool ok, void *arg)
+{
+    subscription_t *subscription = (subscription_t *)arg;
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    if (!subscription->receiving)
+    {
+        subscription->receiving = true;
+
+        if (subscription->coalesce == CCM_COALESCE_LATEST)
+        {
+            subscription->buffer_length = 0;
+        }
+        subscription->message_start = subscription->buffer_length;
+    }
+
+    uint16_t space = subscription->buffer_size - subscription->buffer_length;
+
+    if ((length > space) && (subscription->message_start > 0))
+    {
+        uint16_t received = subscription->buffer_length - subscription->message_start;
+
+        deliver_batch(subscription, batch_count);
+        batch_count = 0;
+
+        memmove(subscription->buffer, &subscription->buffer[subscription->message_start], received);
+        subscription->message_start = 0;
+        subscription->buffer_length = received;
+        space = subscription->buffer_size - received;
+    }
+
+    uint16_t copy = (length < space) ? length : space;
+
+    if (copy < length)
+    {
+        subscription->truncated = true;
+    }
+
+    if (copy > 0)
+    {
+        memcpy(&subscription->buffer[subscription->buffer_length], chunk, copy);
+        subscription->buffer_length += copy;
+    }
+}
+
+static void deliver_batch(subscription_t *subscription, uint8_t count)
+{
+    subscription_stats.batches++;
+    subscription->batch_handler(subscription->index, batch, count, subscription->arg);
+}
+
+/* AT commands storing the topic name of a slot and subscribing to it. The
+ * queued commands are sent first if the queue has no room for both of them,
+ * acknowledged is cleared if one of those failed */
+static bool submit_topic(const subscription_t *subscription, uint32_t delay, bool *acknowledged)
+{
+    char command[CCM_COMMAND_MAX_LENGTH];
+
+    if ((ccm_command_queue_pending() + 2u) > CCM_COMMAND_QUEUE_SIZE)
+    {
+        *acknowledged = ccm_command_queue_flush() && *acknowledged;
+    }
+
+    snprintf(command, sizeof(command), "AT+CONF Topic%u=%s\n", subscription->index, subscription->topic);
+
+    return ccm_config_submit(command, delay, CCM_COMMAND_FLAG_NONE) &&
+           ccm_command_queue_submit_id(CCM_CMD_SUBSCRIBE(subscription->index), delay, CCM_COMMAND_FLAG_NONE, NULL,
+                                       NULL);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,90 @@
+/******************************************************************************
+ * File Name: ccm_subscription.h
+ *
+ * Description: This file is the public interface of ccm_subscription.c source
+ * file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_SUBSCRIPTION_H_
+#define CCM_SUBSCRIPTION_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Number of topic slots, the CCM topic indexes are 1..CCM_SUBSCRIPTION_MAX */
+#ifndef CCM_SUBSCRIPTION_MAX
+#define CCM_SUBSCRIPTION_MAX (4u)
+#endif
+
+/* Response timeout of AT+GET<index> in milliseconds */
+#ifndef CCM_SUBSCRIPTION_FETCH_DELAY
+#define CCM_SUBSCRIPTION_FETCH_DELAY (CCM_TIMEOUT_AUTO)
+#endif
+
+/* Most messages passed to a batch handler in one call */
+#ifndef CCM_SUBSCRIPTION_BATCH_MAX
+#define CCM_SUBSCRIPTION_BATCH_MAX (8u)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Message handler of a topic slot. Without a buffer the message is passed in
+ * chunks while it is received; with a buffer it is passed once, complete (or
+ * truncated to the buffer size), with last set to true. ok is only set with
+ * last and if the whole message was received (and fitted into the buffer),
+ * an incomplete message should be discarded. */
+typedef void (*ccm_subscription_handler_t)(uint8_t index, const uint8_t *data, uint16_t length,
+                                           bool last, bool ok, void *arg);
+
+/* Coalescing policy of a batched topic slot */
+typedef enum
+{
+    CCM_COALESCE_NONE = 0, /* every message is passed */
+    CCM_COALESCE_LATEST    /* latest value wins: only the newest pending message is passed */
+} ccm_coalesce_t;
+
+/* A message of a batch, data points into the slot buffer */
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t length;
+    bool truncated; /* did not fit into the rest of the buffer, or incomplete */
+} ccm_message_t;
+
+/* Message handler of a batched topic slot, the messages are only valid during
+ * the call. Called once per drain, or more often if a batch does not fit in
+ * CCM_SUBSCRIPTION_BATCH_MAX messages or in the slot buffer. */
+typedef void (*ccm_subscription_batch_handler_t)(uint8_t index, const ccm_message_t *messages, uint8_t count,
+                                                 void *arg);
+
+typedef struct
+{
+    uint32_t messages;  /* messages received over all slots */
+    uint32_t batches;   /* batch handler calls */
+    uint32_t coalesced; /* stale messages not passed, CCM_COALESCE_LATEST */
+} ccm_subscription_stats_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+bool ccm_subscription_register(uint8_t index, const char *topic, ccm_subscription_handler_t handler,
+                               void *arg, uint8_t *buffer, uint16_t buffer_size);
+
+bool ccm_subscription_register_batch(uint8_t index, const char *topic, ccm_subscription_batch_handler_t handler,
+                                     void *arg, uint8_t *buffer, uint16_t buffer_size, ccm_coalesce_t coalesce);
+
+bool ccm_subscription_start(uint32_t delay);
+
+bool ccm_subscription_fetch(uint8_t index, uint32_t delay);
+
+void ccm_subscription_get_stats(ccm_subscription_stats_t *stats);
+
+#endif /* CCM_SUBSCRIPTION_H_ */
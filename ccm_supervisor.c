@@ -0,0 +1,263 @@
+/******************************************************************************
+ * File Name: ccm_supervisor.c
+ *
+ * Description: Connection supervisor. Runs a connection attempt until it
+ * succeeds, waiting a jittered, exponentially growing backoff between the
+ * failed attempts so that a fleet of devices does not reconnect in lockstep
+ * after a broker or access point outage. Once the retry budget is exhausted
+ * the application escalates to a host reset; the backoff level survives the
+ * reset so that a device in a reset loop does not hammer the broker.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_supervisor.h"
+#include "ccm_log.h"
+#include "ccm_rtos.h"
+#include "cy_pdl.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define ESCALATION_MAGIC (0x53555056u) /* "SUPV" */
+
+/* Largest doubling of CCM_SUPERVISOR_BASE_DELAY, keeps the shift defined */
+#define MAX_BACKOFF_EXPONENT (16u)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static const char *const error_names[CCM_ERROR_CLASS_COUNT] = {
+    [CCM_ERROR_NONE] = "none",
+    [CCM_ERROR_TIMEOUT] = "timeout",
+    [CCM_ERROR_NOT_CONNECTED] = "not connected",
+    [CCM_ERROR_WIFI] = "Wi-Fi",
+    [CCM_ERROR_NETWORK] = "network",
+    [CCM_ERROR_AUTH] = "authentication",
+    [CCM_ERROR_COMMAND] = "command rejected",
+};
+
+/* Not cleared by the startup code: the escalations counted before a host
+ * reset, valid if the magic matches */
+CY_NOINIT static uint32_t escalation_magic;
+CY_NOINIT static uint32_t escalation_count;
+
+static ccm_supervisor_stats_t supervisor_stats;
+static uint32_t random_state;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static uint32_t escalations(void);
+static uint32_t backoff_delay(ccm_error_class_t error, uint32_t exponent);
+static void backoff_wait(uint32_t delay);
+static bool never(void);
+
+/*******************************************************************************
+ * Function Name: ccm_error_classify
+ *******************************************************************************
+ * Summary:
+ *  Class of a response that is not the expected one.
+ *
+ * input parameter: const ccm_response_t *response
+ *                  Response of the failed command
+ *
+ * Return:
+ *  ccm_error_class_t - CCM_ERROR_NOT_CONNECTED if the command was accepted.
+ *
+ *******************************************************************************/
+ccm_error_class_t ccm_error_classify(const ccm_response_t *response)
+{
+    if ((response == NULL) || (response->slot == CCM_RESPONSE_NO_SLOT))
+    {
+        return CCM_ERROR_TIMEOUT;
+    }
+
+    if (strncmp(response->data, "ERR14", 5) == 0)
+    {
+        /* ERR14 <n>: connection failure, n tells which step failed */
+        switch (response->data[6])
+        {
+        case '2':
+            return CCM_ERROR_WIFI;
+        case '5':
+            return CCM_ERROR_AUTH;
+        default:
+            return CCM_ERROR_NETWORK;
+        }
+    }
+
+    if (strncmp(response->data, "ERR", 3) == 0)
+    {
+        return CCM_ERROR_COMMAND;
+    }
+
+    return CCM_ERROR_NOT_CONNECTED;
+}
+
+const char *ccm_error_name(ccm_error_class_t error)
+{
+    return (error < CCM_ERROR_CLASS_COUNT) ? error_names[error] : "unknown";
+}
+
+/*******************************************************************************
+ * Function Name: ccm_supervisor_run
+ *******************************************************************************
+ * Summary:
+ *  Call attempt until it succeeds or CCM_SUPERVISOR_RETRY_BUDGET attempts in
+ *  a row failed, with a backoff between the attempts. After a host reset by
+ *  ccm_supervisor_escalate() the backoff starts at its upper bound.
+ *
+ * input parameter: const char *name
+ *                  Name of the attempt in the log
+ *
+ * input parameter: ccm_supervisor_attempt_t attempt
+ *                  One attempt, returns CCM_ERROR_NONE on success
+ *
+ * input parameter: void *arg
+ *                  Passed to attempt
+ *
+ * Return:
+ *  bool - false if the retry budget is exhausted.
+ *
+ *******************************************************************************/
+bool ccm_supervisor_run(const char *name, ccm_supervisor_attempt_t attempt, void *arg)
+{
+    uint32_t level = escalations() * CCM_SUPERVISOR_RETRY_BUDGET;
+    uint32_t failures = 0;
+
+    while (1)
+    {
+        ccm_error_class_t error;
+        uint32_t delay;
+
+        supervisor_stats.attempts++;
+        error = attempt(arg);
+
+        if (error == CCM_ERROR_NONE)
+        {
+            if ((failures > 0) || (level > 0))
+            {
+                CCM_LOG(CCM_LOG_INFO, "\n%s succeeded after %lu retries\n\r", name, (unsigned long)failures);
+            }
+
+            /* Connected: the next outage starts over with the short backoff */
+            escalation_magic = 0;
+            return true;
+        }
+
+        supervisor_stats.errors[error]++;
+        supervisor_stats.last_error = error;
+        failures++;
+
+        if (failures >= CCM_SUPERVISOR_RETRY_BUDGET)
+        {
+            CCM_LOG(CCM_LOG_ERROR, "\n%s failed %lu times, last error: %s\n\r",
+                    name, (unsigned long)failures, ccm_error_name(error));
+            return false;
+        }
+
+        delay = backoff_delay(error, level + failures - 1);
+        supervisor_stats.last_backoff = delay;
+
+        CCM_LOG(CCM_LOG_WARN, "\n%s failed (%s), retry %lu in %lu ms\n\r",
+                name, ccm_error_name(error), (unsigned long)failures, (unsigned long)delay);
+
+        backoff_wait(delay);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_supervisor_escalate
+ *******************************************************************************
+ * Summary:
+ *  The retry budget is exhausted: count the escalation and reset the host,
+ *  which starts over with the link to the CCM module. Does not return.
+ *
+ *******************************************************************************/
+void ccm_supervisor_escalate(void)
+{
+    escalation_count = escalations() + 1;
+    escalation_magic = ESCALATION_MAGIC;
+
+    CCM_LOG(CCM_LOG_ERROR, "\nRetry budget exhausted, resetting the host (escalation %lu)\n\r",
+            (unsigned long)escalation_count);
+    ccm_log_flush();
+
+    NVIC_SystemReset();
+}
+
+void ccm_supervisor_get_stats(ccm_supervisor_stats_t *stats)
+{
+    *stats = supervisor_stats;
+    stats->escalations = escalations();
+}
+
+/* Escalations since the last successful attempt, 0 after a power-on reset */
+static uint32_t escalations(void)
+{
+    return (escalation_magic == ESCALATION_MAGIC) ? escalation_count : 0;
+}
+
+/*******************************************************************************
+ * Function Name: backoff_delay
+ *******************************************************************************
+ * Summary:
+ *  Equal jitter backoff: half of min(MAX_DELAY, BASE_DELAY * 2^exponent) plus
+ *  a random part of up to the other half. Authentication failures and
+ *  rejected commands need a configuration change, they wait the upper bound.
+ *
+ *******************************************************************************/
+static uint32_t backoff_delay(ccm_error_class_t error, uint32_t exponent)
+{
+    uint32_t ceiling = CCM_SUPERVISOR_MAX_DELAY;
+
+    if ((error != CCM_ERROR_AUTH) && (error != CCM_ERROR_COMMAND) && (exponent < MAX_BACKOFF_EXPONENT) &&
+        ((CCM_SUPERVISOR_BASE_DELAY << exponent) < CCM_SUPERVISOR_MAX_DELAY))
+    {
+        ceiling = CCM_SUPERVISOR_BASE_DELAY << exponent;
+    }
+
+    /* xorshift32, seeded with the die unique id so that devices powered up
+     * together draw different delays */
+    if (random_state == 0)
+    {
+        uint64_t unique_id = Cy_SysLib_GetUniqueId();
+
+        random_state = (uint32_t)unique_id ^ (uint32_t)(unique_id >> 32) ^ ccm_get_ticks();
+        if (random_state == 0)
+        {
+            random_state = 1;
+        }
+    }
+
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+
+    return (ceiling / 2) + (random_state % ((ceiling / 2) + 1));
+}
+
+/* Sleep through the backoff, deep sleep in the bare metal build */
+static void backoff_wait(uint32_t delay)
+{
+#if CCM_RTOS
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        vTaskDelay(pdMS_TO_TICKS(delay));
+        return;
+    }
+#endif
+
+    ccm_deep_sleep_timeout(never, delay);
+}
+
+static bool never(void)
+{
+    return false;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * File Name: ccm_supervisor.h
+ *
+ * Description: This file is the public interface of ccm_supervisor.c source
+ * file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_SUPERVISOR_H_
+#define CCM_SUPERVISOR_H_
+
+#include "CCM.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Backoff before the first retry, doubled by every failed attempt, ms */
+#ifndef CCM_SUPERVISOR_BASE_DELAY
+#define CCM_SUPERVISOR_BASE_DELAY (2000u)
+#endif
+
+/* Upper bound of the backoff, also used right away for the errors that do not
+ * go away by themselves (authentication, rejected command), ms */
+#ifndef CCM_SUPERVISOR_MAX_DELAY
+#define CCM_SUPERVISOR_MAX_DELAY (300000u)
+#endif
+
+/* Failed attempts before ccm_supervisor_run() gives up */
+#ifndef CCM_SUPERVISOR_RETRY_BUDGET
+#define CCM_SUPERVISOR_RETRY_BUDGET (12u)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Classes of the errors reported by the CCM module */
+typedef enum
+{
+    CCM_ERROR_NONE = 0,
+    CCM_ERROR_TIMEOUT,       /* no response */
+    CCM_ERROR_NOT_CONNECTED, /* command accepted, not connected (yet) */
+    CCM_ERROR_WIFI,          /* ERR14 2: Wi-Fi network unreachable or credentials */
+    CCM_ERROR_NETWORK,       /* other ERR14: DNS, broker unreachable */
+    CCM_ERROR_AUTH,          /* ERR14 5: MQTT device authentication failure */
+    CCM_ERROR_COMMAND,       /* other ERR: command rejected */
+    CCM_ERROR_CLASS_COUNT
+} ccm_error_class_t;
+
+/* One connection attempt, returns CCM_ERROR_NONE on success */
+typedef ccm_error_class_t (*ccm_supervisor_attempt_t)(void *arg);
+
+typedef struct
+{
+    uint32_t attempts;                        /* since boot */
+    uint32_t errors[CCM_ERROR_CLASS_COUNT];   /* failed attempts per class */
+    uint32_t last_backoff;                    /* ms */
+    uint32_t escalations;                     /* budgets exhausted, kept over host resets */
+    ccm_error_class_t last_error;
+} ccm_supervisor_stats_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+ccm_error_class_t ccm_error_classify(const ccm_response_t *response);
+
+const char *ccm_error_name(ccm_error_class_t error);
+
+bool ccm_supervisor_run(const char *name, ccm_supervisor_attempt_t attempt, void *arg);
+
+void ccm_supervisor_escalate(void);
+
+void ccm_supervisor_get_stats(ccm_supervisor_stats_t *stats);
+
+#endif /* CCM_SUPERVISOR_H_ */
@@ -0,0 +1,334 @@
+/******************************************************************************
+ * File Name: ccm_timeout.c
+ *
+ * Description: Per-command response timeouts. Every AT command belongs to a
+ * class with a fixed default timeout and bounds; in adaptive mode the deadline
+ * of a class follows its observed latency, tracked as an EWMA with mean
+ * deviation (as for TCP retransmission timers) and a 99th percentile taken
+ * from a decaying log2 histogram. A timeout doubles the deadline of the class
+ * until the next response is received in time.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_timeout.h"
+#include "ccm_commands.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define HISTOGRAM_BUCKETS (18u)   /* up to 2^18 ms */
+#define HISTOGRAM_DECAY_AT (256u) /* halve the histogram after this many samples */
+#define PERCENTILE_TAIL (100u)    /* 1 out of 100 samples above the p99 */
+#define EWMA_SHIFT (3u)           /* gain 1/8 */
+#define DEVIATION_SHIFT (2u)      /* gain 1/4 */
+#define DEVIATION_FACTOR (4u)
+#define MAX_BACKOFF (4u)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    const char *prefix;
+    ccm_timeout_class_t timeout_class;
+} command_class_t;
+
+typedef struct
+{
+    uint32_t minimum;  /* lower bound of the adaptive deadline */
+    uint32_t initial;  /* timeout used until enough samples are collected */
+    uint32_t maximum;  /* upper bound of the deadline */
+} class_limits_t;
+
+typedef struct
+{
+    uint32_t samples;
+    uint32_t timeouts;
+    uint32_t ewma_scaled;      /* latency << EWMA_SHIFT */
+    uint32_t deviation_scaled; /* mean deviation << DEVIATION_SHIFT */
+    uint16_t histogram[HISTOGRAM_BUCKETS];
+    uint16_t histogram_total;
+    uint8_t backoff;
+} class_state_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Commands only sent as strings, with no entry in the command table. The
+ * other commands take the class of their CCM_COMMAND_LIST entry */
+static const command_class_t command_classes[] = {
+    {"AT+SEND", CCM_TIMEOUT_CLASS_GET},
+};
+
+/* Milliseconds. The CONNECT class starts at the 120 s the application always
+ * allowed AT+CONNECT, slow Wi-Fi joins and MQTT handshakes included */
+static const class_limits_t class_limits[CCM_TIMEOUT_CLASS_COUNT] = {
+    [CCM_TIMEOUT_CLASS_QUICK] = {.minimum = 200, .initial = 2000, .maximum = 10000},
+    [CCM_TIMEOUT_CLASS_PROBE] = {.minimum = 1000, .initial = 4000, .maximum = 10000},
+    [CCM_TIMEOUT_CLASS_GET] = {.minimum = 500, .initial = 10000, .maximum = 60000},
+    [CCM_TIMEOUT_CLASS_CONNECT] = {.minimum = 30000, .initial = 120000, .maximum = 240000},
+    [CCM_TIMEOUT_CLASS_OTA] = {.minimum = 1000, .initial = 30000, .maximum = 120000},
+};
+
+static class_state_t class_states[CCM_TIMEOUT_CLASS_COUNT];
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static uint32_t class_deadline(ccm_timeout_class_t timeout_class);
+static uint32_t class_p99(const class_state_t *state);
+static size_t command_verb_length(const char *command);
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_classify
+ *******************************************************************************
+ * Summary:
+ *  Timeout class of an AT command sent as a string: the class of the command
+ *  table entry with the same command word ("AT+GET" for "AT+GET2\n",
+ *  "AT+DIAG" for "AT+DIAG PING <host>\n"), CCM_TIMEOUT_CLASS_QUICK if none
+ *  matches.
+ *
+ *******************************************************************************/
+ccm_timeout_class_t ccm_timeout_classify(const char *command)
+{
+    size_t length = command_verb_length(command);
+
+    for (uint32_t i = 0; i < CCM_CMD_COUNT; i++)
+    {
+        if ((command_verb_length(ccm_commands[i].command) == length) &&
+            !strncmp(command, ccm_commands[i].command, length))
+        {
+            return ccm_commands[i].timeout_class;
+        }
+    }
+
+    for (uint32_t i = 0; i < (sizeof(command_classes) / sizeof(command_classes[0])); i++)
+    {
+        if ((strlen(command_classes[i].prefix) == length) && !strncmp(command, command_classes[i].prefix, length))
+        {
+            return command_classes[i].timeout_class;
+        }
+    }
+
+    return CCM_TIMEOUT_CLASS_QUICK;
+}
+
+/* Length of the command word: up to the topic index, arguments or line end */
+static size_t command_verb_length(const char *command)
+{
+    size_t length = 0;
+
+    while ((command[length] != '\0') && (command[length] != ' ') && (command[length] != '=') &&
+           (command[length] != '\r') && (command[length] != '\n') &&
+           ((command[length] < '0') || (command[length] > '9')))
+    {
+        length++;
+    }
+
+    return length;
+}
+
+/*******************************************************************************
+ * Function Name: class_p99
+ *******************************************************************************
+ * Summary:
+ *  Upper edge of the histogram bucket holding the 99th percentile latency.
+ *
+ *******************************************************************************/
+static uint32_t class_p99(const class_state_t *state)
+{
+    uint32_t tail = state->histogram_total / PERCENTILE_TAIL;
+    uint32_t count = 0;
+
+    for (int32_t bucket = HISTOGRAM_BUCKETS - 1; bucket >= 0; bucket--)
+    {
+        count += state->histogram[bucket];
+
+        if (count > tail)
+        {
+            return (1u << (bucket + 1)) - 1;
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Function Name: class_deadline
+ *******************************************************************************
+ * Summary:
+ *  Timeout of a class: the larger of EWMA + 4 x deviation and the p99 latency,
+ *  bounded by the class limits and doubled for every consecutive timeout.
+ *
+ *******************************************************************************/
+static uint32_t class_deadline(ccm_timeout_class_t timeout_class)
+{
+    const class_limits_t *limits = &class_limits[timeout_class];
+    const class_state_t *state = &class_states[timeout_class];
+    uint32_t deadline = limits->initial;
+
+    if (CCM_ADAPTIVE_TIMEOUT && (state->samples >= CCM_TIMEOUT_MIN_SAMPLES))
+    {
+        uint32_t ewma = state->ewma_scaled >> EWMA_SHIFT;
+        uint32_t deviation = state->deviation_scaled >> DEVIATION_SHIFT;
+        uint32_t p99 = class_p99(state);
+
+        deadline = ewma + (DEVIATION_FACTOR * deviation);
+        if (p99 > deadline)
+        {
+            deadline = p99;
+        }
+
+        if (deadline < limits->minimum)
+        {
+            deadline = limits->minimum;
+        }
+    }
+
+    deadline <<= state->backoff;
+
+    return (deadline > limits->maximum) ? limits->maximum : deadline;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_get
+ *******************************************************************************
+ * Summary:
+ *  Response timeout to use for an AT command, in milliseconds.
+ *
+ *******************************************************************************/
+uint32_t ccm_timeout_get(const char *command)
+{
+    return class_deadline(ccm_timeout_classify(command));
+}
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_get_class
+ *******************************************************************************
+ * Summary:
+ *  Response timeout of a command class, in milliseconds. Used by the command
+ *  table entries, whose class is known at compile time.
+ *
+ *******************************************************************************/
+uint32_t ccm_timeout_get_class(ccm_timeout_class_t timeout_class)
+{
+    return class_deadline(timeout_class);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_resolve
+ *******************************************************************************
+ * Summary:
+ *  Return delay, or the timeout of the command if delay is CCM_TIMEOUT_AUTO.
+ *
+ *******************************************************************************/
+uint32_t ccm_timeout_resolve(const char *command, uint32_t delay)
+{
+    return (delay == CCM_TIMEOUT_AUTO) ? ccm_timeout_get(command) : delay;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_record
+ *******************************************************************************
+ * Summary:
+ *  Account the response latency of a command in the statistics of its class.
+ *
+ * input parameter: const char *command
+ *                  AT command sent
+ *
+ * input parameter: uint32_t latency
+ *                  Time from sending the command to its response, milliseconds
+ *
+ * input parameter: bool timed_out
+ *                  true if no response was received
+ *
+ *******************************************************************************/
+void ccm_timeout_record(const char *command, uint32_t latency, bool timed_out)
+{
+    ccm_timeout_record_class(ccm_timeout_classify(command), latency, timed_out);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_record_class
+ *******************************************************************************
+ * Summary:
+ *  Account a response latency in the statistics of a command class, see
+ *  ccm_timeout_record().
+ *
+ *******************************************************************************/
+void ccm_timeout_record_class(ccm_timeout_class_t timeout_class, uint32_t latency, bool timed_out)
+{
+    class_state_t *state = &class_states[timeout_class];
+
+    if (timed_out)
+    {
+        state->timeouts++;
+        if (state->backoff < MAX_BACKOFF)
+        {
+            state->backoff++;
+        }
+        return;
+    }
+
+    state->backoff = 0;
+
+    if (state->samples == 0)
+    {
+        state->ewma_scaled = latency << EWMA_SHIFT;
+        state->deviation_scaled = (latency / 2) << DEVIATION_SHIFT;
+    }
+    else
+    {
+        int32_t error = (int32_t)latency - (int32_t)(state->ewma_scaled >> EWMA_SHIFT);
+        uint32_t magnitude = (error < 0) ? (uint32_t)(-error) : (uint32_t)error;
+
+        state->ewma_scaled = (uint32_t)((int32_t)state->ewma_scaled + error);
+        state->deviation_scaled = state->deviation_scaled + magnitude - (state->deviation_scaled >> DEVIATION_SHIFT);
+    }
+
+    state->samples++;
+
+    uint32_t bucket = 0;
+    while (((latency + 1) >> (bucket + 1)) && (bucket < (HISTOGRAM_BUCKETS - 1)))
+    {
+        bucket++;
+    }
+
+    state->histogram[bucket]++;
+    state->histogram_total++;
+
+    /* Decay so that the percentile follows a change of the link behavior */
+    if (state->histogram_total >= HISTOGRAM_DECAY_AT)
+    {
+        state->histogram_total = 0;
+        for (uint32_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+        {
+            state->histogram[i] >>= 1;
+            state->histogram_total += state->histogram[i];
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_timeout_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Latency statistics and current deadline of a command class.
+ *
+ *******************************************************************************/
+void ccm_timeout_get_stats(ccm_timeout_class_t timeout_class, ccm_timeout_stats_t *stats)
+{
+    const class_state_t *state = &class_states[timeout_class];
+
+    stats->samples = state->samples;
+    stats->timeouts = state->timeouts;
+    stats->ewma = state->ewma_scaled >> EWMA_SHIFT;
+    stats->p99 = class_p99(state);
+    stats->deadline = class_deadline(timeout_class);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * File Name: ccm_timeout.h
+ *
+ * Description: This file is the public interface of ccm_timeout.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_TIMEOUT_H_
+#define CCM_TIMEOUT_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Pass as delay to the AT command API's to use the timeout of the command class.
+ * A delay of 0 keeps its meaning: poll the received lines without waiting */
+#define CCM_TIMEOUT_AUTO (0xFFFFFFFFu)
+
+/* Set to 0 to use the fixed per-class timeouts only */
+#ifndef CCM_ADAPTIVE_TIMEOUT
+#define CCM_ADAPTIVE_TIMEOUT (1)
+#endif
+
+/* Number of samples of a class before its observed latency is trusted */
+#ifndef CCM_TIMEOUT_MIN_SAMPLES
+#define CCM_TIMEOUT_MIN_SAMPLES (8u)
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Command classes sharing the same latency behavior */
+typedef enum
+{
+    CCM_TIMEOUT_CLASS_QUICK = 0, /* local configuration and queries */
+    CCM_TIMEOUT_CLASS_PROBE,     /* AT+CONNECT?, AT+DIAG */
+    CCM_TIMEOUT_CLASS_GET,       /* message download and publish */
+    CCM_TIMEOUT_CLASS_CONNECT,   /* network and cloud connection */
+    CCM_TIMEOUT_CLASS_OTA,       /* OTA control */
+    CCM_TIMEOUT_CLASS_COUNT
+} ccm_timeout_class_t;
+
+/* Latency statistics of a command class, times in milliseconds */
+typedef struct
+{
+    uint32_t samples;
+    uint32_t timeouts;
+    uint32_t ewma;     /* smoothed latency */
+    uint32_t p99;      /* upper bound of the 99th percentile latency */
+    uint32_t deadline; /* timeout currently used */
+} ccm_timeout_stats_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+ccm_timeout_class_t ccm_timeout_classify(const char *command);
+
+uint32_t ccm_timeout_get(const char *command);
+
+uint32_t ccm_timeout_get_class(ccm_timeout_class_t timeout_class);
+
+uint32_t ccm_timeout_resolve(const char *command, uint32_t delay);
+
+void ccm_timeout_record(const char *command, uint32_t latency, bool timed_out);
+
+void ccm_timeout_record_class(ccm_timeout_class_t timeout_class, uint32_t latency, bool timed_out);
+
+void ccm_timeout_get_stats(ccm_timeout_class_t timeout_class, ccm_timeout_stats_t *stats);
+
+#endif /* CCM_TIMEOUT_H_ */
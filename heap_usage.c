@@ -1,9 +1,10 @@
 /******************************************************************************
 * File Name:   heap_usage.c
 *
-* Description: This file contains the code for printing heap usage.
-*              Supports only GCC_ARM compiler. Define PRINT_HEAP_USAGE for
-*              printing the heap usage numbers.
+* Description: This file contains the code for printing heap usage, the
+*              high-water marks of the static CCM buffers and the stack
+*              usage. Supports only GCC_ARM compiler. Define PRINT_HEAP_USAGE
+*              for printing the numbers.
 *
 * Related Document: See README.md
 *
@@ -47,6 +48,9 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include "heap_usage.h"
+#include "ccm_command_queue.h"
+#include "ccm_log.h"
 
 /* ARM compiler also defines __GNUC__ */
 #if defined (__GNUC__) && !defined(__ARMCC_VERSION)
@@ -59,16 +63,153 @@
  ******************************************************************************/
 #define TO_KB(size_bytes)  ((float)(size_bytes)/1024)
 
+/* Pattern of the unused stack, and bytes below the current stack pointer left
+ * unpainted for the frames of memory_budget_init() itself */
+#define STACK_PAINT_PATTERN (0xA5A5A5A5u)
+#define STACK_PAINT_MARGIN  (128u)
+
+#if defined (__GNUC__) && !defined(__ARMCC_VERSION)
+#define MEMORY_BUDGET_GCC (1)
+#else
+#define MEMORY_BUDGET_GCC (0)
+#endif
+
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+/* Heap allocations since boot and since memory_budget_mark_steady_state() */
+static uint32_t heap_allocations;
+static uint32_t steady_heap_allocations;
+static uint32_t steady_heap_arena;
+static uint8_t steady_state;
+
+#if MEMORY_BUDGET_GCC
+extern uint32_t __StackLimit; /* Symbol exported by the linker. */
+extern uint32_t __StackTop;   /* Symbol exported by the linker. */
+#endif
+
 
 /*******************************************************************************
  * Function Definitions
  ******************************************************************************/
 
+/*******************************************************************************
+* Function Name: memory_budget_init
+********************************************************************************
+* Summary:
+* Paint the unused stack so that its high-water mark can be measured, and make
+* stdout unbuffered in the static memory build. Call first in main().
+*
+*******************************************************************************/
+void memory_budget_init(void)
+{
+#if MEMORY_BUDGET_GCC
+    uint32_t *limit = &__StackLimit;
+    uint32_t *current = (uint32_t *)(uintptr_t)__get_MSP();
+
+    current -= (STACK_PAINT_MARGIN / sizeof(uint32_t));
+
+    for (uint32_t *word = limit; word < current; word++)
+    {
+        *word = STACK_PAINT_PATTERN;
+    }
+#endif /* #if MEMORY_BUDGET_GCC */
+
+    if (CCM_STATIC_MEMORY)
+    {
+        /* newlib allocates the stdout buffer from the heap on the first printf */
+        setvbuf(stdout, NULL, _IONBF, 0);
+    }
+}
+
+/*******************************************************************************
+* Function Name: memory_budget_mark_steady_state
+********************************************************************************
+* Summary:
+* Start of the steady state: heap allocations from now on are reported as
+* steady state growth by print_heap_usage().
+*
+*******************************************************************************/
+void memory_budget_mark_steady_state(void)
+{
+#if MEMORY_BUDGET_GCC
+    steady_heap_arena = (uint32_t)mallinfo().arena;
+#endif /* #if MEMORY_BUDGET_GCC */
+    steady_heap_allocations = heap_allocations;
+    steady_state = 1;
+}
+
+/*******************************************************************************
+* Function Name: memory_budget_stack_unused
+********************************************************************************
+* Summary:
+* Bytes of the stack never used since memory_budget_init(), 0 if the stack was
+* not painted.
+*
+*******************************************************************************/
+uint32_t memory_budget_stack_unused(void)
+{
+    uint32_t unused = 0;
+
+#if MEMORY_BUDGET_GCC
+    for (uint32_t *word = &__StackLimit; (word < &__StackTop) && (*word == STACK_PAINT_PATTERN); word++)
+    {
+        unused += sizeof(uint32_t);
+    }
+#endif /* #if MEMORY_BUDGET_GCC */
+
+    return unused;
+}
+
+/*******************************************************************************
+* Function Name: memory_budget_heap
+********************************************************************************
+* Summary:
+* Heap claimed from the system so far (newlib does not give it back, so this is
+* the high-water mark) and heap in use, in bytes. 0 if mallinfo() is not
+* available.
+*
+*******************************************************************************/
+void memory_budget_heap(uint32_t *high_water, uint32_t *in_use)
+{
+#if MEMORY_BUDGET_GCC
+    struct mallinfo mall_info = mallinfo();
+
+    *high_water = (uint32_t)mall_info.arena;
+    *in_use = (uint32_t)mall_info.uordblks;
+#else
+    *high_water = 0;
+    *in_use = 0;
+#endif /* #if MEMORY_BUDGET_GCC */
+}
+
+#if CCM_STATIC_MEMORY && MEMORY_BUDGET_GCC
+/*******************************************************************************
+* Function Name: __wrap__malloc_r
+********************************************************************************
+* Summary:
+* Counts the heap allocations of the application and of newlib, linked with
+* -Wl,--wrap=_malloc_r in the static memory build.
+*
+*******************************************************************************/
+struct _reent;
+extern void *__real__malloc_r(struct _reent *reent, size_t size);
+
+void *__wrap__malloc_r(struct _reent *reent, size_t size)
+{
+    heap_allocations++;
+
+    return __real__malloc_r(reent, size);
+}
+#endif /* #if CCM_STATIC_MEMORY && MEMORY_BUDGET_GCC */
+
 /*******************************************************************************
 * Function Name: print_heap_usage
 ********************************************************************************
 * Summary:
-* Prints the available heap and utilized heap by using mallinfo().
+* Prints the available heap and utilized heap by using mallinfo(), the high-water
+* marks of the static CCM buffers and the stack usage.
 *
 *******************************************************************************/
 void print_heap_usage(char *msg)
@@ -77,6 +218,9 @@ void print_heap_usage(char *msg)
 #if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION)
     struct mallinfo mall_info = mallinfo();
 
+    /* Keep the order of the messages logged before the report */
+    ccm_log_flush();
+
     extern uint8_t __HeapBase;  /* Symbol exported by the linker. */
     extern uint8_t __HeapLimit; /* Symbol exported by the linker. */
 
@@ -94,6 +238,32 @@ void print_heap_usage(char *msg)
     printf("Heap in use at this point   : %u bytes/%.2f KB, %.2f%% of available heap\r\n",
             mall_info.uordblks, TO_KB(mall_info.uordblks), ((float) mall_info.uordblks * 100u)/heap_size);
 
+    if (steady_state)
+    {
+        printf("Steady state heap growth    : %"PRIu32" bytes, %"PRIu32" allocations\r\n",
+                (uint32_t)mall_info.arena - steady_heap_arena, heap_allocations - steady_heap_allocations);
+    }
+
+    ccm_memory_stats_t memory_stats;
+    ccm_get_memory_stats(&memory_stats);
+
+    uint32_t stack_size = (uint32_t)((uint8_t *)&__StackTop - (uint8_t *)&__StackLimit);
+    uint32_t stack_unused = memory_budget_stack_unused();
+
+    printf("Response pool high-water    : %u of %u slots of %u bytes, %"PRIu32" lines dropped, %"PRIu32" truncated\r\n",
+            memory_stats.pool_high_water, memory_stats.pool_size, memory_stats.slot_size, memory_stats.rx_overruns,
+            memory_stats.rx_truncated);
+    printf("Stream ring high-water      : %"PRIu32" of %"PRIu32" bytes\r\n",
+            memory_stats.stream_high_water, memory_stats.stream_ring_size);
+    printf("TX ring high-water          : %"PRIu32" of %"PRIu32" bytes, %"PRIu32" bytes in %"PRIu32" transfers\r\n",
+            memory_stats.tx_high_water, memory_stats.tx_ring_size, memory_stats.tx_bytes, memory_stats.tx_transfers);
+    printf("Command queue high-water    : %u of %u commands\r\n",
+            ccm_command_queue_high_water(), CCM_COMMAND_QUEUE_SIZE);
+    printf("Log ring high-water         : %"PRIu32" of %u bytes, %"PRIu32" messages dropped\r\n",
+            ccm_log_high_water(), CCM_LOG_RING_SIZE, ccm_log_dropped());
+    printf("Stack used so far           : %"PRIu32" of %"PRIu32" bytes\r\n",
+            stack_size - stack_unused, stack_size);
+
     printf("********************************\r\n\n");
 #endif /* #if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION) */
 }
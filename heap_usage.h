@@ -0,0 +1,40 @@
+/******************************************************************************
+ * File Name: heap_usage.h
+ *
+ * Description: This file is the public interface of heap_usage.c source file.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef HEAP_USAGE_H_
+#define HEAP_USAGE_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Set to 1 (STATIC_MEMORY=1 in the Makefile) to build for a fixed memory
+ * budget: stdout is unbuffered so that newlib does not allocate its buffer,
+ * and every heap allocation is counted through the _malloc_r wrapper. */
+#ifndef CCM_STATIC_MEMORY
+#define CCM_STATIC_MEMORY (0)
+#endif
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void memory_budget_init(void);
+
+void memory_budget_mark_steady_state(void);
+
+uint32_t memory_budget_stack_unused(void);
+
+void memory_budget_heap(uint32_t *high_water, uint32_t *in_use);
+
+void print_heap_usage(char *msg);
+
+#endif /* HEAP_USAGE_H_ */
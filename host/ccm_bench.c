@@ -0,0 +1,320 @@
+/******************************************************************************
+ * File Name: ccm_bench.c
+ *
+ * Description: Host benchmarks of the CCM link against the CCM emulator, run
+ * by "make -C host bench":
+ *
+ *   parse        CPU cost of one response through the receive interrupt, the
+ *                framing and at_command_execute(), and of a streamed payload
+ *   events       event throughput of the event loop of main(): MSG events
+ *                drained, dispatched and fetched, per second of line time
+ *   boot         boot to subscribed time, uart_init() to the "subscribed" mark
+ *
+ * The line times are virtual, set by the baud rate and the line latency of
+ * the emulator (ccm_bench [baud] [line latency in us]); the CPU times are
+ * measured on the host with CLOCK_PROCESS_CPUTIME_ID. Every result is one
+ * "bench <name> <value> <unit>" line, for CI to keep and compare.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_host_app.h"
+#include "ccm_hal_host.h"
+#include "ccm_boot.h"
+#include "ccm_event.h"
+#include "ccm_subscription.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define BENCH_BAUD (115200u)
+#define BENCH_LINE_LATENCY_US (200u)
+#define BENCH_EVENT_LATENCY_US (100u)
+
+#define BENCH_PARSE_COUNT (20000u)   /* responses parsed */
+#define BENCH_STREAM_COUNT (1000u)   /* streamed payloads */
+#define BENCH_STREAM_SIZE (1024u)    /* bytes per streamed payload */
+#define BENCH_EVENT_COUNT (2000u)    /* MSG events, in bursts */
+#define BENCH_EVENT_BURST (32u)
+#define BENCH_MESSAGE_SIZE (64u)
+#define BENCH_RUN_TIME (600000u)     /* ms, longest virtual time of a benchmark */
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static ccm_emulator_config_t bench_config = {
+    .baud = BENCH_BAUD,
+    .line_latency_us = BENCH_LINE_LATENCY_US,
+    .event_latency_us = BENCH_EVENT_LATENCY_US,
+    .wifi_connected = true,
+    .aws_connected = true};
+
+static uint8_t message_buffer[BENCH_STREAM_SIZE];
+static uint32_t messages_received;
+static uint32_t messages_expected;
+static uint32_t stream_bytes;
+
+/* Standard output of the results, the one of the program gets the printf
+ * output of the CCM link */
+static FILE *results;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void bench_init(const ccm_emulator_config_t *config);
+static void bench_parse(void);
+static void bench_events(void);
+static void bench_boot(void);
+static uint64_t cpu_time_ns(void);
+static void report(const char *name, double value, const char *unit);
+
+/*******************************************************************************
+ * Function Name: main
+ *******************************************************************************
+ * Summary:
+ *  Run the benchmarks, each on a freshly started CCM link.
+ *
+ * Return:
+ *  int - EXIT_SUCCESS if every benchmark completed.
+ *
+ *******************************************************************************/
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        bench_config.baud = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2)
+    {
+        bench_config.line_latency_us = (uint32_t)strtoul(argv[2], NULL, 10);
+    }
+    if (bench_config.baud == 0)
+    {
+        fprintf(stderr, "usage: %s [baud] [line latency in us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Only the results are written, the log and printf output is dropped */
+    results = fdopen(dup(STDOUT_FILENO), "w");
+    if ((results == NULL) || (freopen("/dev/null", "w", stdout) == NULL))
+    {
+        perror("ccm_bench");
+        return EXIT_FAILURE;
+    }
+    ccm_hal_host_set_debug_output(false);
+
+    report("baud", bench_config.baud, "bit/s");
+    report("line_latency", bench_config.line_latency_us, "us");
+
+    bench_boot();
+    bench_parse();
+    bench_events();
+
+    return EXIT_SUCCESS;
+}
+
+static void stream_handler(const uint8_t *chunk, uint16_t length, bool last, bool ok, void *arg)
+{
+    (void)chunk;
+    (void)arg;
+
+    stream_bytes += length;
+    if (last && !ok)
+    {
+        fprintf(stderr, "bench parse: streamed payload incomplete\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Cost of the receive path per response line and per streamed byte */
+static void bench_parse(void)
+{
+    static const ccm_emulator_rule_t script[] = {
+        {"AT+EVENT?", "OK 1 1 MSG\r\n"}};
+    static char stream_response[BENCH_STREAM_SIZE + 8u];
+    ccm_emulator_rule_t stream_script[] = {
+        {"AT+GET1", stream_response}};
+    int result = 0;
+
+    bench_init(&bench_config);
+
+    /* Event lines, tokenized by the AT+EVENT? answer path */
+    ccm_emulator_set_script(script, 1);
+
+    uint64_t line_start = ccm_hal_host_time_ns();
+    uint64_t cpu_start = cpu_time_ns();
+
+    for (uint32_t i = 0; i < BENCH_PARSE_COUNT; i++)
+    {
+        ccm_response_t *response = at_command_execute(CCM_CMD_EVENT_QUERY, CCM_TIMEOUT_AUTO, &result);
+
+        if ((result != 1) || (response->event_type != CCM_EVENT_MSG))
+        {
+            fprintf(stderr, "bench parse: unexpected response %s", response->data);
+            exit(EXIT_FAILURE);
+        }
+        ccm_response_release(response);
+    }
+
+    uint64_t cpu = cpu_time_ns() - cpu_start;
+    uint64_t line = ccm_hal_host_time_ns() - line_start;
+
+    report("parse_response_cpu", (double)cpu / BENCH_PARSE_COUNT, "ns/response");
+    report("parse_response_line", (double)line / BENCH_PARSE_COUNT / 1000.0, "us/response");
+
+    /* Streamed payloads, delivered in chunks from the stream ring */
+    memcpy(stream_response, "OK ", 3);
+    memset(&stream_response[3], 'x', BENCH_STREAM_SIZE);
+    memcpy(&stream_response[3 + BENCH_STREAM_SIZE], "\r\n", 3);
+    ccm_emulator_set_script(stream_script, 1);
+    stream_bytes = 0;
+
+    line_start = ccm_hal_host_time_ns();
+    cpu_start = cpu_time_ns();
+
+    for (uint32_t i = 0; i < BENCH_STREAM_COUNT; i++)
+    {
+        if (1 != at_command_execute_stream(CCM_CMD_GET1, CCM_TIMEOUT_AUTO, stream_handler, NULL))
+        {
+            fprintf(stderr, "bench parse: streamed payload failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    cpu = cpu_time_ns() - cpu_start;
+    line = ccm_hal_host_time_ns() - line_start;
+
+    if (stream_bytes != (BENCH_STREAM_COUNT * BENCH_STREAM_SIZE))
+    {
+        fprintf(stderr, "bench parse: %lu streamed bytes\n", (unsigned long)stream_bytes);
+        exit(EXIT_FAILURE);
+    }
+
+    report("parse_stream_cpu", (double)cpu / stream_bytes, "ns/byte");
+    report("parse_stream_line", (double)line / BENCH_STREAM_COUNT / 1000.0, "us/payload");
+}
+
+static void message_handler(uint8_t index, const uint8_t *data, uint16_t length, bool last, bool ok, void *arg)
+{
+    (void)index;
+    (void)data;
+    (void)length;
+    (void)arg;
+
+    if (last && ok)
+    {
+        messages_received++;
+    }
+}
+
+static bool burst_received(void)
+{
+    return messages_received >= messages_expected;
+}
+
+/* MSG events through the event loop, published in bursts */
+static void bench_events(void)
+{
+    char payload[BENCH_MESSAGE_SIZE + 1u];
+    uint64_t line = 0;
+    uint64_t cpu = 0;
+
+    memset(payload, 'm', BENCH_MESSAGE_SIZE);
+    payload[BENCH_MESSAGE_SIZE] = '\0';
+
+    bench_init(&bench_config);
+    ccm_subscription_register(1, "data", message_handler, NULL, message_buffer, sizeof(message_buffer));
+
+    if (!ccm_host_app_connect_and_subscribe(CCM_TIMEOUT_AUTO))
+    {
+        fprintf(stderr, "bench events: not subscribed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    messages_received = 0;
+    messages_expected = 0;
+
+    while (messages_expected < BENCH_EVENT_COUNT)
+    {
+        for (uint32_t i = 0; i < BENCH_EVENT_BURST; i++)
+        {
+            ccm_emulator_publish(1, payload);
+        }
+        messages_expected += BENCH_EVENT_BURST;
+
+        uint64_t line_start = ccm_hal_host_time_ns();
+        uint64_t cpu_start = cpu_time_ns();
+
+        if (!ccm_host_app_run(burst_received, BENCH_RUN_TIME))
+        {
+            fprintf(stderr, "bench events: %lu of %lu messages received\n", (unsigned long)messages_received,
+                    (unsigned long)messages_expected);
+            exit(EXIT_FAILURE);
+        }
+
+        cpu += cpu_time_ns() - cpu_start;
+        line += ccm_hal_host_time_ns() - line_start;
+    }
+
+    report("events_per_second", (double)messages_expected * 1e9 / (double)line, "events/s");
+    report("events_cpu", (double)cpu / messages_expected, "ns/event");
+    report("events_drain_max_batch", ccm_event_get_stats()->max_batch, "events");
+}
+
+/* uart_init() to subscribed, from a module that is not connected yet */
+static void bench_boot(void)
+{
+    ccm_emulator_config_t config = bench_config;
+
+    config.aws_connected = false;
+
+    uint64_t cpu_start = cpu_time_ns();
+
+    bench_init(&config);
+    ccm_subscription_register(1, "data", message_handler, NULL, message_buffer, sizeof(message_buffer));
+    ccm_subscription_register(2, "settings", message_handler, NULL, NULL, 0);
+
+    if (!ccm_host_app_connect_and_subscribe(CCM_TIMEOUT_AUTO))
+    {
+        fprintf(stderr, "bench boot: not subscribed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t cpu = cpu_time_ns() - cpu_start;
+
+    report("boot_to_subscribed", ccm_boot_time("subscribed") - ccm_boot_time("uart_init"), "ms");
+    report("boot_to_subscribed_cpu", (double)cpu / 1000.0, "us");
+}
+
+/* The host UART starts at BAUD_RATE of CCM.c, it runs at the rate of the
+ * benchmark from the start, as after a baud rate negotiation */
+static void bench_init(const ccm_emulator_config_t *config)
+{
+    uint32_t actual_baud = 0;
+
+    ccm_host_app_init(config);
+    (void)ccm_hal_uart_set_baud(config->baud, &actual_baud);
+}
+
+static uint64_t cpu_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ull) + (uint64_t)now.tv_nsec;
+}
+
+static void report(const char *name, double value, const char *unit)
+{
+    fprintf(results, "bench %s %.1f %s\n", name, value, unit);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,670 @@
+/******************************************************************************
+ * File Name: ccm_emulator.c
+ *
+ * Description: Scripted CCM module for the host build of the CCM link. The
+ * command lines written by the host are answered when their last byte is
+ * written, with the state of the emulator at that time; the answer bytes
+ * arrive on the host side CCM_EMULATOR_BYTE_TIME_NS() apart, starting one line
+ * latency after the end of the command. Commands not answered by the script
+ * get the built-in answers below, the ones of the CCM AT command set the
+ * example uses.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_emulator.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define LINE_MASK (CCM_EMULATOR_LINE_SIZE - 1u)
+#define EVENT_SIZE (48u)
+#define HISTORY_LINE_SIZE (64u)
+#define GARBLED_BYTE (0xFFu)
+#define NS_PER_US (1000ull)
+
+#define FAULT_RESPONSE "ERR2 EMULATED FAULT\r\n"
+#define UNKNOWN_RESPONSE "ERR3 UNKNOWN COMMAND\r\n"
+#define BAUD_COMMAND "AT+CONF BaudRate="
+
+#if (CCM_EMULATOR_LINE_SIZE & LINE_MASK) != 0
+#error "CCM_EMULATOR_LINE_SIZE must be a power of two"
+#endif
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+/* Byte on the line to the host, readable from time on */
+typedef struct
+{
+    uint64_t time;
+    uint8_t data;
+    bool error;
+} line_byte_t;
+
+typedef struct
+{
+    uint8_t index;
+    char payload[CCM_EMULATOR_PAYLOAD_SIZE];
+} message_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static ccm_emulator_config_t config;
+static ccm_emulator_stats_t stats;
+static uint32_t host_baud;
+static uint64_t now;
+
+static const ccm_emulator_rule_t *script;
+static size_t script_count;
+
+static ccm_emulator_pin_handler_t pin_handler;
+static uint64_t edge_time = CCM_EMULATOR_TIME_NONE;
+
+static ccm_emulator_fault_t fault;
+static uint32_t fault_count;
+
+/* Answers on their way to the host, the line is busy until line_free_time */
+static line_byte_t line[CCM_EMULATOR_LINE_SIZE];
+static uint32_t line_head;
+static uint32_t line_tail;
+static uint64_t line_free_time;
+
+/* Command line being received */
+static char command[CCM_EMULATOR_COMMAND_SIZE];
+static size_t command_length;
+static bool command_garbled;
+
+static char events[CCM_EMULATOR_EVENT_COUNT][EVENT_SIZE];
+static uint32_t event_head;
+static uint32_t event_tail;
+
+static message_t messages[CCM_EMULATOR_EVENT_COUNT];
+static uint32_t message_count;
+
+static char history[CCM_EMULATOR_HISTORY_SIZE][HISTORY_LINE_SIZE];
+static uint32_t history_count;
+
+/* "OK <payload>\r\n" of AT+GET<n> */
+static char get_response[CCM_EMULATOR_PAYLOAD_SIZE + 8u];
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void execute(const char *line_data, uint64_t time);
+static const char *builtin_response(const char *line_data);
+static void answer(const char *response, uint64_t time);
+static void send(const char *data, size_t length, bool error, uint64_t time);
+static bool starts_with(const char *text, const char *prefix);
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_init
+ *******************************************************************************
+ * Summary:
+ *  Reset the emulator: empty line, event and message queues, no script, no
+ *  fault. The host starts at the baud rate of the CCM module.
+ *
+ * input parameter: const ccm_emulator_config_t *config
+ *                  Line and connection parameters, copied
+ *
+ *******************************************************************************/
+void ccm_emulator_init(const ccm_emulator_config_t *emulator_config)
+{
+    config = *emulator_config;
+    memset(&stats, 0, sizeof(stats));
+    host_baud = config.baud;
+
+    script = NULL;
+    script_count = 0;
+    pin_handler = NULL;
+    edge_time = CCM_EMULATOR_TIME_NONE;
+    fault = CCM_EMULATOR_FAULT_NONE;
+    fault_count = 0;
+
+    line_head = 0;
+    line_tail = 0;
+    line_free_time = 0;
+    command_length = 0;
+    command_garbled = false;
+    event_head = 0;
+    event_tail = 0;
+    message_count = 0;
+    history_count = 0;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_set_script
+ *******************************************************************************
+ * Summary:
+ *  Answer the commands with the rules, checked in order before the built-in
+ *  answers. The rules must stay valid, NULL removes the script.
+ *
+ *******************************************************************************/
+void ccm_emulator_set_script(const ccm_emulator_rule_t *rules, size_t count)
+{
+    script = rules;
+    script_count = (rules == NULL) ? 0 : count;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_set_pin_handler
+ *******************************************************************************
+ * Summary:
+ *  Register the consumer of the EVENT pin rising edges, the GPIO interrupt of
+ *  main.c on the board.
+ *
+ *******************************************************************************/
+void ccm_emulator_set_pin_handler(ccm_emulator_pin_handler_t handler)
+{
+    pin_handler = handler;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_set_connected
+ *******************************************************************************
+ * Summary:
+ *  Change the Wi-Fi and AWS IoT core connection states answered to the
+ *  probes, without an event.
+ *
+ *******************************************************************************/
+void ccm_emulator_set_connected(bool wifi_connected, bool aws_connected)
+{
+    config.wifi_connected = wifi_connected;
+    config.aws_connected = aws_connected;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_inject
+ *******************************************************************************
+ * Summary:
+ *  Apply a fault to the next count answers, replacing the fault injected
+ *  before. CCM_EMULATOR_FAULT_NONE or a count of 0 ends the injection.
+ *
+ *******************************************************************************/
+void ccm_emulator_inject(ccm_emulator_fault_t injected_fault, uint32_t count)
+{
+    fault = injected_fault;
+    fault_count = (injected_fault == CCM_EMULATOR_FAULT_NONE) ? 0 : count;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_queue_event
+ *******************************************************************************
+ * Summary:
+ *  Queue an event for AT+EVENT?, e.g. "OK 3 0 CONLOST". The EVENT pin rises
+ *  event_latency_us later if the event queue was empty.
+ *
+ * Return:
+ *  bool - false if the event queue is full.
+ *
+ *******************************************************************************/
+bool ccm_emulator_queue_event(const char *event)
+{
+    if ((event_head - event_tail) >= CCM_EMULATOR_EVENT_COUNT)
+    {
+        stats.overflows++;
+        return false;
+    }
+
+    if ((event_head == event_tail) && (edge_time == CCM_EMULATOR_TIME_NONE))
+    {
+        edge_time = now + (config.event_latency_us * NS_PER_US);
+    }
+
+    snprintf(events[event_head % CCM_EMULATOR_EVENT_COUNT], EVENT_SIZE, "%s", event);
+    event_head++;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_publish
+ *******************************************************************************
+ * Summary:
+ *  A message arrived on the topic of index: keep the payload for AT+GET<index>
+ *  and queue its MSG event.
+ *
+ * Return:
+ *  bool - false if the message or the event queue is full.
+ *
+ *******************************************************************************/
+bool ccm_emulator_publish(uint8_t index, const char *payload)
+{
+    char event[EVENT_SIZE];
+
+    if (message_count >= CCM_EMULATOR_EVENT_COUNT)
+    {
+        stats.overflows++;
+        return false;
+    }
+
+    snprintf(event, sizeof(event), "OK 1 %u MSG", index);
+
+    if (!ccm_emulator_queue_event(event))
+    {
+        return false;
+    }
+
+    messages[message_count].index = index;
+    snprintf(messages[message_count].payload, CCM_EMULATOR_PAYLOAD_SIZE, "%s", payload);
+    message_count++;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_command_count
+ *******************************************************************************
+ * Summary:
+ *  Number of the last CCM_EMULATOR_HISTORY_SIZE command lines starting with
+ *  prefix, e.g. "AT+CONNECT?".
+ *
+ *******************************************************************************/
+uint32_t ccm_emulator_command_count(const char *prefix)
+{
+    uint32_t kept = (history_count < CCM_EMULATOR_HISTORY_SIZE) ? history_count : CCM_EMULATOR_HISTORY_SIZE;
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < kept; i++)
+    {
+        if (starts_with(history[i], prefix))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Line and command counters since ccm_emulator_init().
+ *
+ *******************************************************************************/
+void ccm_emulator_get_stats(ccm_emulator_stats_t *emulator_stats)
+{
+    *emulator_stats = stats;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_set_host_baud
+ *******************************************************************************
+ * Summary:
+ *  Baud rate of the host UART. While it differs from the baud rate of the CCM
+ *  module the bytes in both directions are garbled, the received ones with a
+ *  receive error.
+ *
+ *******************************************************************************/
+void ccm_emulator_set_host_baud(uint32_t baud)
+{
+    host_baud = baud;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_write
+ *******************************************************************************
+ * Summary:
+ *  Bytes sent by the host, the first one starting at time. Every complete
+ *  command line is answered.
+ *
+ *******************************************************************************/
+void ccm_emulator_write(const uint8_t *data, size_t length, uint64_t time)
+{
+    uint64_t byte_time = CCM_EMULATOR_BYTE_TIME_NS(host_baud);
+    bool garbled = (host_baud != config.baud);
+
+    now = time;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t byte = garbled ? GARBLED_BYTE : data[i];
+
+        time += byte_time;
+        stats.bytes_in++;
+
+        if (byte == '\n')
+        {
+            command[command_length] = '\0';
+
+            if (command_garbled)
+            {
+                stats.garbled++;
+                answer(UNKNOWN_RESPONSE, time + (config.line_latency_us * NS_PER_US));
+            }
+            else
+            {
+                execute(command, time);
+            }
+
+            command_length = 0;
+            command_garbled = false;
+        }
+        else if (byte == GARBLED_BYTE)
+        {
+            command_garbled = true;
+        }
+        else if ((byte != '\r') && (command_length < (CCM_EMULATOR_COMMAND_SIZE - 1u)))
+        {
+            command[command_length++] = (char)byte;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_readable
+ *******************************************************************************
+ * Summary:
+ *  Whether a byte has arrived on the host side by time, error tells whether
+ *  it came with a receive error.
+ *
+ *******************************************************************************/
+bool ccm_emulator_readable(uint64_t time, bool *error)
+{
+    if ((line_tail == line_head) || (line[line_tail & LINE_MASK].time > time))
+    {
+        return false;
+    }
+
+    *error = line[line_tail & LINE_MASK].error;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_read
+ *******************************************************************************
+ * Summary:
+ *  Take up to size bytes arrived on the host side by time.
+ *
+ * Return:
+ *  size_t - number of bytes written to buffer.
+ *
+ *******************************************************************************/
+size_t ccm_emulator_read(uint64_t time, uint8_t *buffer, size_t size)
+{
+    size_t count = 0;
+
+    while ((count < size) && (line_tail != line_head) && (line[line_tail & LINE_MASK].time <= time))
+    {
+        buffer[count++] = line[line_tail & LINE_MASK].data;
+        line_tail++;
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_next_time
+ *******************************************************************************
+ * Summary:
+ *  Time of the next byte arriving on the host side or of the next EVENT pin
+ *  edge, CCM_EMULATOR_TIME_NONE if nothing is scheduled.
+ *
+ *******************************************************************************/
+uint64_t ccm_emulator_next_time(void)
+{
+    uint64_t next = edge_time;
+
+    if ((line_tail != line_head) && (line[line_tail & LINE_MASK].time < next))
+    {
+        next = line[line_tail & LINE_MASK].time;
+    }
+
+    return next;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_emulator_run
+ *******************************************************************************
+ * Summary:
+ *  Advance the emulator to time and raise the EVENT pin if its edge is due.
+ *
+ * Return:
+ *  bool - true if the pin handler was called.
+ *
+ *******************************************************************************/
+bool ccm_emulator_run(uint64_t time)
+{
+    now = time;
+
+    if (edge_time > time)
+    {
+        return false;
+    }
+
+    edge_time = CCM_EMULATOR_TIME_NONE;
+    stats.edges++;
+
+    if (pin_handler)
+    {
+        pin_handler();
+    }
+
+    return true;
+}
+
+/* Answer a complete command line, its last byte received at time */
+static void execute(const char *line_data, uint64_t time)
+{
+    const char *response = NULL;
+    bool scripted = false;
+
+    stats.commands++;
+    snprintf(history[history_count % CCM_EMULATOR_HISTORY_SIZE], HISTORY_LINE_SIZE, "%.*s", (int)(HISTORY_LINE_SIZE - 1u), line_data);
+    history_count++;
+
+    time += config.line_latency_us * NS_PER_US;
+
+    for (size_t i = 0; i < script_count; i++)
+    {
+        if (starts_with(line_data, script[i].command))
+        {
+            response = script[i].response;
+            scripted = true;
+            break;
+        }
+    }
+
+    if (!scripted)
+    {
+        response = builtin_response(line_data);
+    }
+
+    answer(response, time);
+
+    /* The new rate applies once the "OK" is sent */
+    if (!scripted && starts_with(line_data, BAUD_COMMAND))
+    {
+        uint32_t baud = (uint32_t)strtoul(&line_data[sizeof(BAUD_COMMAND) - 1u], NULL, 10);
+
+        if (baud > 0)
+        {
+            config.baud = baud;
+        }
+    }
+}
+
+/* Answers of the CCM AT commands used by the example, NULL for no answer */
+static const char *builtin_response(const char *line_data)
+{
+    static const char *const acknowledged[] = {
+        "AT+CONF ", "AT+SUBSCRIBE", "AT+UNSUBSCRIBE", "AT+SEND", "AT+CLOUD_SYNC",
+        "AT+CONFMODE", "AT+OTA ", "AT+RESET", "AT+FACTORY_RESET"};
+
+    if (!strcmp(line_data, "AT+EVENT?"))
+    {
+        if (event_tail == event_head)
+        {
+            return "OK\r\n";
+        }
+
+        /* The event line is sent before the slot is reused */
+        static char event_response[EVENT_SIZE + 2u];
+        snprintf(event_response, sizeof(event_response), "%s\r\n", events[event_tail % CCM_EMULATOR_EVENT_COUNT]);
+        event_tail++;
+        stats.events++;
+
+        return event_response;
+    }
+
+    if (starts_with(line_data, "AT+GET"))
+    {
+        uint8_t index = (uint8_t)strtoul(&line_data[6], NULL, 10);
+
+        for (uint32_t i = 0; i < message_count; i++)
+        {
+            if (messages[i].index == index)
+            {
+                snprintf(get_response, sizeof(get_response), "OK %s\r\n", messages[i].payload);
+                memmove(&messages[i], &messages[i + 1u], (message_count - i - 1u) * sizeof(message_t));
+                message_count--;
+
+                return get_response;
+            }
+        }
+
+        return "OK\r\n";
+    }
+
+    if (!strcmp(line_data, "AT+CONNECT?"))
+    {
+        return config.aws_connected ? "OK 1 1 CONNECTED\r\n" : "OK 0 0 NOT CONNECTED\r\n";
+    }
+
+    if (!strcmp(line_data, "AT+CONNECT"))
+    {
+        config.wifi_connected = true;
+        config.aws_connected = true;
+
+        return "OK 1 CONNECTED\r\n";
+    }
+
+    if (!strcmp(line_data, "AT+DISCONNECT"))
+    {
+        config.wifi_connected = false;
+        config.aws_connected = false;
+
+        return "OK\r\n";
+    }
+
+    if (starts_with(line_data, "AT+DIAG PING"))
+    {
+        return config.wifi_connected ? "OK Received ping reply\r\n" : "OK Not connected to AP\r\n";
+    }
+
+    if (!strcmp(line_data, "AT"))
+    {
+        return "OK\r\n";
+    }
+
+    for (size_t i = 0; i < (sizeof(acknowledged) / sizeof(acknowledged[0])); i++)
+    {
+        if (starts_with(line_data, acknowledged[i]))
+        {
+            return "OK\r\n";
+        }
+    }
+
+    return UNKNOWN_RESPONSE;
+}
+
+/* Send a response with the fault injected into it, if any */
+static void answer(const char *response, uint64_t time)
+{
+    size_t length;
+    bool error = false;
+
+    if (response == NULL)
+    {
+        return;
+    }
+
+    length = strlen(response);
+
+    if (fault_count > 0)
+    {
+        static char faulty[sizeof(get_response)];
+
+        fault_count--;
+        stats.faults++;
+
+        switch (fault)
+        {
+        case CCM_EMULATOR_FAULT_NO_RESPONSE:
+            return;
+
+        case CCM_EMULATOR_FAULT_ERROR:
+            response = FAULT_RESPONSE;
+            length = strlen(response);
+            break;
+
+        case CCM_EMULATOR_FAULT_TRUNCATE:
+            while ((length > 0) && ((response[length - 1u] == '\n') || (response[length - 1u] == '\r')))
+            {
+                length--;
+            }
+            break;
+
+        case CCM_EMULATOR_FAULT_CORRUPT:
+            memcpy(faulty, response, length);
+            faulty[0] ^= 0x20;
+            response = faulty;
+            break;
+
+        case CCM_EMULATOR_FAULT_RX_ERROR:
+            error = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    send(response, length, error, time);
+}
+
+/* Put bytes on the line to the host, the first one not before time */
+static void send(const char *data, size_t length, bool error, uint64_t time)
+{
+    uint64_t byte_time = CCM_EMULATOR_BYTE_TIME_NS(config.baud);
+    bool garbled = (host_baud != config.baud);
+
+    if ((CCM_EMULATOR_LINE_SIZE - (line_head - line_tail)) < length)
+    {
+        stats.overflows++;
+        return;
+    }
+
+    if (line_free_time < time)
+    {
+        line_free_time = time;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        line_byte_t *byte = &line[line_head & LINE_MASK];
+
+        line_free_time += byte_time;
+        byte->time = line_free_time;
+        byte->data = garbled ? GARBLED_BYTE : (uint8_t)data[i];
+        byte->error = garbled || (error && (i == 0));
+        line_head++;
+    }
+
+    stats.bytes_out += (uint32_t)length;
+}
+
+static bool starts_with(const char *text, const char *prefix)
+{
+    return (0 == strncmp(text, prefix, strlen(prefix)));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,140 @@
+/******************************************************************************
+ * File Name: ccm_emulator.h
+ *
+ * Description: This file is the public interface of ccm_emulator.c source
+ * file, a scripted CCM module for the host build of the CCM link. It answers
+ * the AT commands the host writes with the lines of a script, queues events
+ * and messages and raises the EVENT pin, on the virtual time line of
+ * ccm_hal_host.c: every byte takes the time of its baud rate on the line and
+ * every answer is delayed by the line latency. Faults are injected into the
+ * next answers to exercise the error paths of CCM.c.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_EMULATOR_H_
+#define CCM_EMULATOR_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Bytes on their way to the host, the answers of the commands in flight */
+#ifndef CCM_EMULATOR_LINE_SIZE
+#define CCM_EMULATOR_LINE_SIZE (8192u)
+#endif
+
+/* Longest command line and longest message payload */
+#ifndef CCM_EMULATOR_COMMAND_SIZE
+#define CCM_EMULATOR_COMMAND_SIZE (256u)
+#endif
+
+#ifndef CCM_EMULATOR_PAYLOAD_SIZE
+#define CCM_EMULATOR_PAYLOAD_SIZE (4096u)
+#endif
+
+/* Events and messages waiting in the CCM module */
+#ifndef CCM_EMULATOR_EVENT_COUNT
+#define CCM_EMULATOR_EVENT_COUNT (64u)
+#endif
+
+/* Last command lines kept for ccm_emulator_command_count() */
+#ifndef CCM_EMULATOR_HISTORY_SIZE
+#define CCM_EMULATOR_HISTORY_SIZE (256u)
+#endif
+
+/* Time on the line of one byte: start bit, 8 data bits, stop bit */
+#define CCM_EMULATOR_BYTE_TIME_NS(baud) ((10ull * 1000000000ull) / (baud))
+
+#define CCM_EMULATOR_TIME_NONE (UINT64_MAX)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    uint32_t baud;             /* baud rate the CCM module talks at */
+    uint32_t line_latency_us;  /* end of a command line to the first byte of its answer */
+    uint32_t event_latency_us; /* event queued to the EVENT pin rising edge */
+    bool wifi_connected;       /* state answered to AT+DIAG PING */
+    bool aws_connected;        /* state answered to AT+CONNECT? */
+} ccm_emulator_config_t;
+
+/* Faults applied to the next answers, see ccm_emulator_inject() */
+typedef enum
+{
+    CCM_EMULATOR_FAULT_NONE = 0,
+    CCM_EMULATOR_FAULT_NO_RESPONSE, /* the command is not answered */
+    CCM_EMULATOR_FAULT_ERROR,       /* "ERR..." instead of the scripted answer */
+    CCM_EMULATOR_FAULT_TRUNCATE,    /* the last line of the answer loses its "\r\n" */
+    CCM_EMULATOR_FAULT_CORRUPT,     /* the first byte of the answer is garbled */
+    CCM_EMULATOR_FAULT_RX_ERROR     /* the UART reports a receive error with the answer */
+} ccm_emulator_fault_t;
+
+/* Scripted answer: the first rule whose command is a prefix of the command
+ * line (without "\n") answers it with its response, one or more "\r\n"
+ * terminated lines. A NULL response leaves the command unanswered. The rules
+ * are checked before the built-in answers of ccm_emulator.c */
+typedef struct
+{
+    const char *command;
+    const char *response;
+} ccm_emulator_rule_t;
+
+typedef struct
+{
+    uint32_t commands;   /* command lines received */
+    uint32_t bytes_in;   /* bytes received from the host */
+    uint32_t bytes_out;  /* bytes sent to the host */
+    uint32_t events;     /* events answered to AT+EVENT? */
+    uint32_t edges;      /* EVENT pin rising edges */
+    uint32_t faults;     /* faults applied */
+    uint32_t garbled;    /* command lines lost to a baud rate mismatch */
+    uint32_t overflows;  /* answers, events or messages dropped, no room */
+} ccm_emulator_stats_t;
+
+/* Called on an EVENT pin rising edge, from the interrupt delivery of
+ * ccm_hal_host.c */
+typedef void (*ccm_emulator_pin_handler_t)(void);
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_emulator_init(const ccm_emulator_config_t *config);
+
+void ccm_emulator_set_script(const ccm_emulator_rule_t *rules, size_t count);
+
+void ccm_emulator_set_pin_handler(ccm_emulator_pin_handler_t handler);
+
+void ccm_emulator_set_connected(bool wifi_connected, bool aws_connected);
+
+void ccm_emulator_inject(ccm_emulator_fault_t fault, uint32_t count);
+
+bool ccm_emulator_queue_event(const char *event);
+
+bool ccm_emulator_publish(uint8_t index, const char *payload);
+
+uint32_t ccm_emulator_command_count(const char *prefix);
+
+void ccm_emulator_get_stats(ccm_emulator_stats_t *stats);
+
+/* Line side, called by ccm_hal_host.c */
+void ccm_emulator_set_host_baud(uint32_t baud);
+
+void ccm_emulator_write(const uint8_t *data, size_t length, uint64_t time);
+
+bool ccm_emulator_readable(uint64_t time, bool *error);
+
+size_t ccm_emulator_read(uint64_t time, uint8_t *buffer, size_t size);
+
+uint64_t ccm_emulator_next_time(void);
+
+bool ccm_emulator_run(uint64_t time);
+
+#endif /* CCM_EMULATOR_H_ */
@@ -0,0 +1,421 @@
+/******************************************************************************
+ * File Name: ccm_hal_host.c
+ *
+ * Description: Host implementation of the CCM link hardware interface, built
+ * with CCM_HAL_CUSTOM defined. The CCM UART is connected to the CCM emulator,
+ * the debug UART to the standard output and the low power timer counts the
+ * virtual time. Interrupts are delivered from ccm_hal_sleep(),
+ * ccm_hal_deep_sleep(), ccm_hal_delay_ms() and the blocking write, the only
+ * places where time passes; the critical sections have nothing to mask.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_hal_host.h"
+#include "ccm_emulator.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define NS_PER_SECOND (1000000000ull)
+#define NS_PER_MS (1000000ull)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static uint64_t now;
+static uint32_t host_baud;
+static bool debug_output = true;
+
+static ccm_hal_uart_handler_t uart_handler;
+static ccm_hal_uart_tx_handler_t uart_tx_handler;
+
+/* End of the asynchronous transfer in progress and wake-up timer match */
+static uint64_t tx_done_time = CCM_EMULATOR_TIME_NONE;
+static uint64_t wakeup_time = CCM_EMULATOR_TIME_NONE;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static uint64_t next_interrupt_time(void);
+static bool deliver_interrupts(void);
+static void run_until(uint64_t time);
+static uint64_t ticks_now(void);
+
+/*******************************************************************************
+ * Function Name: ccm_hal_host_time_ns
+ *******************************************************************************
+ * Summary:
+ *  Virtual time since the start of the program, in nanoseconds.
+ *
+ *******************************************************************************/
+uint64_t ccm_hal_host_time_ns(void)
+{
+    return now;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_host_set_debug_output
+ *******************************************************************************
+ * Summary:
+ *  Write the debug UART output to the standard output (the default) or drop
+ *  it, e.g. while benchmarking.
+ *
+ *******************************************************************************/
+void ccm_hal_host_set_debug_output(bool enable)
+{
+    debug_output = enable;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_board_init
+ *******************************************************************************
+ * Summary:
+ *  Nothing to initialize on the host.
+ *
+ *******************************************************************************/
+void ccm_hal_board_init(void)
+{
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_init
+ *******************************************************************************
+ * Summary:
+ *  Connect the CCM UART to the emulator, initialize it with
+ *  ccm_emulator_init() before.
+ *
+ *******************************************************************************/
+void ccm_hal_uart_init(uint32_t baud, ccm_hal_uart_handler_t handler, ccm_hal_uart_tx_handler_t tx_handler)
+{
+    uart_handler = handler;
+    uart_tx_handler = tx_handler;
+    tx_done_time = CCM_EMULATOR_TIME_NONE;
+
+    host_baud = baud;
+    ccm_emulator_set_host_baud(baud);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_set_baud
+ *******************************************************************************
+ * Summary:
+ *  Change the baud rate of the CCM UART, every rate is reached exactly.
+ *
+ *******************************************************************************/
+bool ccm_hal_uart_set_baud(uint32_t baud, uint32_t *actual_baud)
+{
+    if (baud == 0)
+    {
+        return false;
+    }
+
+    host_baud = baud;
+    ccm_emulator_set_host_baud(baud);
+    *actual_baud = baud;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_write
+ *******************************************************************************
+ * Summary:
+ *  Send bytes to the emulator and wait, with the interrupts running, until
+ *  the last one is on the line.
+ *
+ *******************************************************************************/
+bool ccm_hal_uart_write(const char *data, size_t length)
+{
+    ccm_emulator_write((const uint8_t *)data, length, now);
+    run_until(now + (length * CCM_EMULATOR_BYTE_TIME_NS(host_baud)));
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_write_async
+ *******************************************************************************
+ * Summary:
+ *  Send bytes to the emulator, the transmit handler is called once they took
+ *  their time on the line. One transfer at a time.
+ *
+ *******************************************************************************/
+bool ccm_hal_uart_write_async(const uint8_t *data, size_t length)
+{
+    if (tx_done_time != CCM_EMULATOR_TIME_NONE)
+    {
+        return false;
+    }
+
+    ccm_emulator_write(data, length, now);
+    tx_done_time = now + (length * CCM_EMULATOR_BYTE_TIME_NS(host_baud));
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_uart_read
+ *******************************************************************************
+ * Summary:
+ *  Move up to size bytes arrived from the emulator by now.
+ *
+ *******************************************************************************/
+size_t ccm_hal_uart_read(uint8_t *buffer, size_t size)
+{
+    return ccm_emulator_read(now, buffer, size);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_debug_init
+ *******************************************************************************
+ * Summary:
+ *  The debug UART is the standard output.
+ *
+ *******************************************************************************/
+void ccm_hal_debug_init(void)
+{
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_debug_write
+ *******************************************************************************
+ * Summary:
+ *  Write to the standard output, every byte is taken.
+ *
+ *******************************************************************************/
+size_t ccm_hal_debug_write(const char *data, size_t length)
+{
+    if (debug_output)
+    {
+        fwrite(data, 1, length, stdout);
+    }
+
+    return length;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_timer_init
+ *******************************************************************************
+ * Summary:
+ *  The virtual low power timer, at CCM_HAL_HOST_TIMER_FREQUENCY.
+ *
+ *******************************************************************************/
+uint32_t ccm_hal_timer_init(void)
+{
+    wakeup_time = CCM_EMULATOR_TIME_NONE;
+
+    return CCM_HAL_HOST_TIMER_FREQUENCY;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_timer_read
+ *******************************************************************************
+ * Summary:
+ *  Virtual timer counter, wraps around like the 32-bit hardware counter.
+ *
+ *******************************************************************************/
+uint32_t ccm_hal_timer_read(void)
+{
+    return (uint32_t)ticks_now();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_timer_set_wakeup
+ *******************************************************************************
+ * Summary:
+ *  Wake-up interrupt at the timer tick ticks from now.
+ *
+ *******************************************************************************/
+void ccm_hal_timer_set_wakeup(uint32_t ticks)
+{
+    uint64_t target = ticks_now() + ticks;
+
+    /* First nanosecond at which the counter reads target */
+    wakeup_time = ((target / CCM_HAL_HOST_TIMER_FREQUENCY) * NS_PER_SECOND) +
+                  ((((target % CCM_HAL_HOST_TIMER_FREQUENCY) * NS_PER_SECOND) + CCM_HAL_HOST_TIMER_FREQUENCY - 1u) /
+                   CCM_HAL_HOST_TIMER_FREQUENCY);
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_critical_section_enter
+ *******************************************************************************
+ * Summary:
+ *  Interrupts only run while the CCM link sleeps, nothing to mask.
+ *
+ *******************************************************************************/
+uint32_t ccm_hal_critical_section_enter(void)
+{
+    return 0;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_critical_section_exit
+ *******************************************************************************
+ * Summary:
+ *  See ccm_hal_critical_section_enter().
+ *
+ *******************************************************************************/
+void ccm_hal_critical_section_exit(uint32_t state)
+{
+    (void)state;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_sleep
+ *******************************************************************************
+ * Summary:
+ *  Advance the virtual time to the next interrupt and run it. The program is
+ *  ended if nothing is scheduled, the CCM link would sleep forever.
+ *
+ *******************************************************************************/
+void ccm_hal_sleep(void)
+{
+    if (deliver_interrupts())
+    {
+        return;
+    }
+
+    uint64_t next = next_interrupt_time();
+
+    if (next == CCM_EMULATOR_TIME_NONE)
+    {
+        fprintf(stderr, "ccm_hal_sleep: no wake-up source, the CCM link sleeps forever\n");
+        abort();
+    }
+
+    if (next > now)
+    {
+        now = next;
+    }
+
+    (void)deliver_interrupts();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_deep_sleep
+ *******************************************************************************
+ * Summary:
+ *  Same as ccm_hal_sleep(), never refused.
+ *
+ *******************************************************************************/
+bool ccm_hal_deep_sleep(void)
+{
+    ccm_hal_sleep();
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_hal_delay_ms
+ *******************************************************************************
+ * Summary:
+ *  Advance the virtual time by delay milliseconds, running the interrupts
+ *  due meanwhile.
+ *
+ *******************************************************************************/
+void ccm_hal_delay_ms(uint32_t delay)
+{
+    run_until(now + (delay * NS_PER_MS));
+}
+
+/* Earliest of the interrupts scheduled */
+static uint64_t next_interrupt_time(void)
+{
+    uint64_t next = ccm_emulator_next_time();
+
+    if (tx_done_time < next)
+    {
+        next = tx_done_time;
+    }
+    if (wakeup_time < next)
+    {
+        next = wakeup_time;
+    }
+
+    return next;
+}
+
+/* Run the interrupts due by now, true if there was one */
+static bool deliver_interrupts(void)
+{
+    bool delivered = false;
+    bool error = false;
+
+    if (tx_done_time <= now)
+    {
+        tx_done_time = CCM_EMULATOR_TIME_NONE;
+        delivered = true;
+
+        if (uart_tx_handler)
+        {
+            uart_tx_handler();
+        }
+    }
+
+    if (wakeup_time <= now)
+    {
+        wakeup_time = CCM_EMULATOR_TIME_NONE;
+        delivered = true;
+    }
+
+    if (ccm_emulator_run(now))
+    {
+        delivered = true;
+    }
+
+    if (ccm_emulator_readable(now, &error))
+    {
+        delivered = true;
+
+        if (uart_handler)
+        {
+            uart_handler(error);
+        }
+        else
+        {
+            uint8_t dropped[16];
+            while (ccm_emulator_read(now, dropped, sizeof(dropped)) > 0)
+            {
+            }
+        }
+    }
+
+    return delivered;
+}
+
+/* Advance the virtual time to time, running the interrupts on the way */
+static void run_until(uint64_t time)
+{
+    uint64_t next;
+
+    while ((next = next_interrupt_time()) <= time)
+    {
+        if (next > now)
+        {
+            now = next;
+        }
+
+        (void)deliver_interrupts();
+    }
+
+    if (time > now)
+    {
+        now = time;
+    }
+
+    /* Nothing is due, the events queued from now on are timed from here */
+    (void)ccm_emulator_run(now);
+}
+
+static uint64_t ticks_now(void)
+{
+    return ((now / NS_PER_SECOND) * CCM_HAL_HOST_TIMER_FREQUENCY) +
+           (((now % NS_PER_SECOND) * CCM_HAL_HOST_TIMER_FREQUENCY) / NS_PER_SECOND);
+}
+
+/* [] END OF FILE */
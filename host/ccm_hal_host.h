@@ -0,0 +1,36 @@
+/******************************************************************************
+ * File Name: ccm_hal_host.h
+ *
+ * Description: This file is the public interface of ccm_hal_host.c source
+ * file, the host implementation of ccm_hal.h against the CCM emulator. Time
+ * is virtual: it only advances while CCM.c sleeps or delays, up to the next
+ * interrupt (a byte received, the end of a transfer, an EVENT pin edge or the
+ * wake-up timer), so a run is deterministic and as fast as the host allows.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_HAL_HOST_H_
+#define CCM_HAL_HOST_H_
+
+#include "ccm_hal.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Frequency of the virtual low power timer, the one of the PSoC 6 LFCLK */
+#ifndef CCM_HAL_HOST_TIMER_FREQUENCY
+#define CCM_HAL_HOST_TIMER_FREQUENCY (32768u)
+#endif
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+uint64_t ccm_hal_host_time_ns(void);
+
+void ccm_hal_host_set_debug_output(bool enable);
+
+#endif /* CCM_HAL_HOST_H_ */
@@ -0,0 +1,180 @@
+/******************************************************************************
+ * File Name: ccm_host_app.c
+ *
+ * Description: The host side of the example without the board: the same
+ * calls as main() and connect_and_subscribe() of main.c for the AWS flow,
+ * against the CCM emulator. The subscriptions are registered by the caller
+ * before ccm_host_app_connect_and_subscribe().
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_host_app.h"
+#include "ccm_boot.h"
+#include "ccm_command_queue.h"
+#include "ccm_config.h"
+#include "ccm_event.h"
+#include "ccm_subscription.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Set by the EVENT pin rising edge, gpio_intr_flag of main.c */
+static volatile bool event_flag = false;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void event_pin_handler(void);
+static bool event_pending(void);
+static void connect_result_handler(ccm_response_t *response, int result, void *arg);
+
+/*******************************************************************************
+ * Function Name: ccm_host_app_init
+ *******************************************************************************
+ * Summary:
+ *  Start the emulator and bring the CCM link up as main() does.
+ *
+ * input parameter: const ccm_emulator_config_t *config
+ *                  Line and connection parameters of the emulator
+ *
+ *******************************************************************************/
+void ccm_host_app_init(const ccm_emulator_config_t *config)
+{
+    ccm_emulator_init(config);
+    ccm_emulator_set_pin_handler(event_pin_handler);
+    event_flag = false;
+
+    bsp_init();
+
+    uart_init();
+    ccm_boot_mark("uart_init");
+
+    ccm_config_init();
+}
+
+/*******************************************************************************
+ * Function Name: ccm_host_app_connect_and_subscribe
+ *******************************************************************************
+ * Summary:
+ *  Connect the CCM module to AWS IoT core unless it is connected already and
+ *  subscribe to the registered topics, then discard the events queued before,
+ *  as connect_and_subscribe() does for the AWS flow. The boot marks
+ *  "AWS connected" and "subscribed" are recorded.
+ *
+ * input parameter: uint32_t delay
+ *                  Response timeout of every command, CCM_TIMEOUT_AUTO for the
+ *                  timeout of its class
+ *
+ * Return:
+ *  bool - false if the module did not connect or a subscription failed.
+ *
+ *******************************************************************************/
+bool ccm_host_app_connect_and_subscribe(uint32_t delay)
+{
+    if (!is_aws_connected())
+    {
+        bool connected = false;
+
+        /* AT+CONNECT is sent once the endpoint is acknowledged */
+        ccm_config_submit("AT+CONF Endpoint=" CCM_HOST_APP_ENDPOINT "\n", delay, CCM_COMMAND_FLAG_NONE);
+        ccm_command_queue_submit_id(CCM_CMD_CONNECT, delay, CCM_COMMAND_FLAG_BARRIER,
+                                    connect_result_handler, &connected);
+
+        if (!ccm_command_queue_flush() || !connected)
+        {
+            CCM_LOG(CCM_LOG_ERROR, "\nNot connected to AWS IoT core\n\r");
+            return false;
+        }
+
+        ccm_link_set_aws_state(CCM_LINK_UP);
+    }
+
+    ccm_boot_mark("AWS connected");
+
+    if (!ccm_subscription_start(delay) && !ccm_subscription_start(delay))
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\nSubscribing failed, messages of some topics are not received\n\r");
+        return false;
+    }
+
+    ccm_boot_mark("subscribed");
+
+    ccm_config_commit();
+
+    while (ccm_event_drain(delay, false) >= CCM_EVENT_DRAIN_MAX)
+    {
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ccm_host_app_run
+ *******************************************************************************
+ * Summary:
+ *  The event loop of main(): drain and dispatch the events on every EVENT pin
+ *  edge, deep sleep in between, until done returns true.
+ *
+ * input parameter: bool (*done)(void)
+ *                  Checked after every pass
+ *
+ * input parameter: uint32_t timeout
+ *                  Virtual time in milliseconds after which the loop gives up
+ *
+ * Return:
+ *  bool - true if done, false on timeout.
+ *
+ *******************************************************************************/
+bool ccm_host_app_run(bool (*done)(void), uint32_t timeout)
+{
+    uint32_t start = ccm_get_time_ms();
+
+    while (!done())
+    {
+        uint32_t elapsed = ccm_get_time_ms() - start;
+
+        if (elapsed >= timeout)
+        {
+            return false;
+        }
+
+        if (event_flag)
+        {
+            /* Cleared before draining so that an edge seen while draining is not lost */
+            event_flag = false;
+
+            if (ccm_event_drain(CCM_TIMEOUT_AUTO, true) >= CCM_EVENT_DRAIN_MAX)
+            {
+                event_flag = true;
+            }
+        }
+        else
+        {
+            ccm_deep_sleep_timeout(event_pending, timeout - elapsed);
+        }
+    }
+
+    return true;
+}
+
+/* EVENT pin rising edge, gpio_interrupt_handler() of main.c */
+static void event_pin_handler(void)
+{
+    event_flag = true;
+}
+
+static bool event_pending(void)
+{
+    return event_flag;
+}
+
+static void connect_result_handler(ccm_response_t *response, int result, void *arg)
+{
+    (void)response;
+    *(bool *)arg = (result != 0);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,38 @@
+/******************************************************************************
+ * File Name: ccm_host_app.h
+ *
+ * Description: This file is the public interface of ccm_host_app.c source
+ * file, the part of main.c the host build runs: the AWS flow connection and
+ * subscription of connect_and_subscribe() and the event dispatch loop of
+ * main(), with the EVENT pin raised by the CCM emulator.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CCM_HOST_APP_H_
+#define CCM_HOST_APP_H_
+
+#include "CCM.h"
+#include "ccm_emulator.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Endpoint configured before AT+CONNECT when the module is not connected */
+#ifndef CCM_HOST_APP_ENDPOINT
+#define CCM_HOST_APP_ENDPOINT "example-ats.iot.us-east-1.amazonaws.com"
+#endif
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+void ccm_host_app_init(const ccm_emulator_config_t *config);
+
+bool ccm_host_app_connect_and_subscribe(uint32_t delay);
+
+bool ccm_host_app_run(bool (*done)(void), uint32_t timeout);
+
+#endif /* CCM_HOST_APP_H_ */
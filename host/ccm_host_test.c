@@ -0,0 +1,449 @@
+/******************************************************************************
+ * File Name: ccm_host_test.c
+ *
+ * Description: Host tests of the CCM link against the CCM emulator: command
+ * and response, line timing, injected faults, the connection checks, the
+ * event dispatch and the subscribed message path. Every scenario runs in a
+ * process of its own, "make -C host test" runs them all:
+ *
+ *   ccm_host_test --list        names of the scenarios
+ *   ccm_host_test <scenario>    exit status 0 if it passed
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+#include "ccm_host_app.h"
+#include "ccm_hal_host.h"
+#include "ccm_boot.h"
+#include "ccm_event.h"
+#include "ccm_subscription.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define TEST_BAUD (115200u)
+#define TEST_DELAY (1000u)      /* ms, response timeout of the tests */
+#define TEST_RUN_TIME (10000u)  /* ms, longest event loop of a test */
+#define TEST_MESSAGES (5u)
+#define TEST_BUFFER_SIZE (512u)
+
+#define CHECK(condition)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(condition))                                                           \
+        {                                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE);                                                     \
+        }                                                                           \
+    } while (0)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    const char *name;
+    void (*run)(void);
+} scenario_t;
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static const ccm_emulator_config_t default_config = {
+    .baud = TEST_BAUD,
+    .line_latency_us = 500u,
+    .event_latency_us = 100u,
+    .wifi_connected = true,
+    .aws_connected = true};
+
+static uint8_t message_buffer[TEST_BUFFER_SIZE];
+static char received[TEST_MESSAGES][TEST_BUFFER_SIZE];
+static uint32_t received_count;
+static uint32_t incomplete_count;
+static uint32_t batch_count;
+
+static uint32_t connect_events;
+static uint32_t other_events;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+static void test_send_receive(void);
+static void test_line_timing(void);
+static void test_faults(void);
+static void test_baud_mismatch(void);
+static void test_connection(void);
+static void test_events(void);
+static void test_subscribe(void);
+static void test_batch(void);
+static void test_message_faults(void);
+
+static const scenario_t scenarios[] = {
+    {"send_receive", test_send_receive},
+    {"line_timing", test_line_timing},
+    {"faults", test_faults},
+    {"baud_mismatch", test_baud_mismatch},
+    {"connection", test_connection},
+    {"events", test_events},
+    {"subscribe", test_subscribe},
+    {"batch", test_batch},
+    {"message_faults", test_message_faults}};
+
+/*******************************************************************************
+ * Function Name: main
+ *******************************************************************************
+ * Summary:
+ *  Run the scenario named on the command line, or list them.
+ *
+ * Return:
+ *  int - EXIT_SUCCESS if the scenario passed.
+ *
+ *******************************************************************************/
+int main(int argc, char **argv)
+{
+    if ((argc == 2) && !strcmp(argv[1], "--list"))
+    {
+        for (size_t i = 0; i < (sizeof(scenarios) / sizeof(scenarios[0])); i++)
+        {
+            printf("%s\n", scenarios[i].name);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    for (size_t i = 0; (argc == 2) && (i < (sizeof(scenarios) / sizeof(scenarios[0]))); i++)
+    {
+        if (!strcmp(argv[1], scenarios[i].name))
+        {
+            scenarios[i].run();
+            ccm_log_flush();
+            printf("\nPASS %s\n", scenarios[i].name);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    fprintf(stderr, "usage: %s --list | <scenario>\n", argv[0]);
+    return EXIT_FAILURE;
+}
+
+/* Command answered by the script and by the built-in answers */
+static void test_send_receive(void)
+{
+    static const ccm_emulator_rule_t script[] = {
+        {"AT+CONF? ThingName", "OK host-test\r\n"}};
+    int result = 0;
+
+    ccm_host_app_init(&default_config);
+    ccm_emulator_set_script(script, 1);
+
+    ccm_response_t *response = at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n");
+    CHECK(result == 1);
+    CHECK(!strcmp(response->data, "OK\r\n"));
+    ccm_response_release(response);
+
+    response = at_command_send_receive("AT+CONF? ThingName\n", TEST_DELAY, &result, "OK host-test\r\n");
+    CHECK(result == 1);
+    ccm_response_release(response);
+
+    response = at_command_send_receive("AT+NOT_A_COMMAND\n", TEST_DELAY, &result, "OK\r\n");
+    CHECK(result == 0);
+    CHECK(!strncmp(response->data, "ERR", 3));
+    ccm_response_release(response);
+
+    CHECK(ccm_emulator_command_count("AT") == 3);
+}
+
+/* Round trip of a command: both lines on the wire plus the line latency */
+static void test_line_timing(void)
+{
+    const uint64_t byte_time = CCM_EMULATOR_BYTE_TIME_NS(TEST_BAUD);
+    const uint64_t latency = default_config.line_latency_us * 1000ull;
+    int result = 0;
+
+    ccm_host_app_init(&default_config);
+
+    uint64_t start = ccm_hal_host_time_ns();
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    uint64_t elapsed = ccm_hal_host_time_ns() - start;
+
+    /* "AT\n" and "OK\r\n", the end is seen within a timer tick */
+    CHECK(result == 1);
+    CHECK(elapsed >= (latency + (7u * byte_time)));
+    CHECK(elapsed <= (latency + (7u * byte_time) + (1000000000ull / CCM_HAL_HOST_TIMER_FREQUENCY) + 1u));
+}
+
+/* Every fault fails the command it hits, the next command succeeds */
+static void test_faults(void)
+{
+    ccm_memory_stats_t memory;
+    int result = 0;
+
+    ccm_host_app_init(&default_config);
+
+    ccm_emulator_inject(CCM_EMULATOR_FAULT_ERROR, 1);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 0);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 1);
+
+    /* Times out after the delay */
+    ccm_emulator_inject(CCM_EMULATOR_FAULT_NO_RESPONSE, 1);
+    uint32_t start = ccm_get_time_ms();
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 0);
+    CHECK((ccm_get_time_ms() - start) >= TEST_DELAY);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 1);
+
+    /* Not a terminator, taken for an unsolicited line */
+    ccm_emulator_inject(CCM_EMULATOR_FAULT_CORRUPT, 1);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 0);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 1);
+
+    /* The unterminated answer runs into the next one */
+    ccm_emulator_inject(CCM_EMULATOR_FAULT_TRUNCATE, 1);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 0);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 0);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 1);
+
+    /* The line is still received, the error is counted */
+    ccm_emulator_inject(CCM_EMULATOR_FAULT_RX_ERROR, 1);
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 1);
+    ccm_get_memory_stats(&memory);
+    CHECK(memory.rx_errors == 1);
+}
+
+/* Nothing gets through while the two sides run at different rates */
+static void test_baud_mismatch(void)
+{
+    ccm_emulator_config_t config = default_config;
+    ccm_emulator_stats_t stats;
+    int result = 0;
+
+    config.baud = 9600u;
+    ccm_host_app_init(&config);
+
+    ccm_response_release(at_command_send_receive("AT\n", TEST_DELAY, &result, "OK\r\n"));
+    CHECK(result == 0);
+
+    ccm_emulator_get_stats(&stats);
+    CHECK(stats.commands == 0);
+}
+
+/* The connection checks probe only when the cached state is not fresh */
+static void test_connection(void)
+{
+    ccm_host_app_init(&default_config);
+
+    CHECK(is_aws_connected() == 1);
+    CHECK(is_aws_connected() == 1);
+    CHECK(ccm_emulator_command_count("AT+CONNECT?") == 1);
+
+    /* Connected to AWS IoT core implies Wi-Fi, no ping */
+    CHECK(is_wifi_connected() == 1);
+    CHECK(ccm_emulator_command_count("AT+DIAG PING") == 0);
+
+    ccm_emulator_set_connected(true, false);
+    ccm_link_invalidate();
+    CHECK(is_aws_connected() == 0);
+    CHECK(is_wifi_connected() == 1);
+    CHECK(ccm_emulator_command_count("AT+DIAG PING") == 1);
+
+    ccm_emulator_set_connected(false, false);
+    ccm_link_invalidate();
+    CHECK(is_wifi_connected() == 0);
+    CHECK(ccm_emulator_command_count("AT+CONNECT?") == 3);
+}
+
+static void connect_event_handler(ccm_response_t *event)
+{
+    (void)event;
+    connect_events++;
+}
+
+static void other_event_handler(ccm_response_t *event)
+{
+    (void)event;
+    other_events++;
+}
+
+static bool events_handled(void)
+{
+    return (connect_events + other_events) == 3u;
+}
+
+/* One EVENT pin edge, the drain gets every queued event and dispatches it */
+static void test_events(void)
+{
+    ccm_emulator_stats_t stats;
+
+    ccm_host_app_init(&default_config);
+    ccm_event_register(CCM_EVENT_CONNECT, CCM_EVENT_ID_ANY, connect_event_handler);
+    ccm_event_set_default_handler(other_event_handler);
+
+    CHECK(ccm_emulator_queue_event("OK 6 0 CONNECT"));
+    CHECK(ccm_emulator_queue_event("OK 9 1 EMULATED"));
+    CHECK(ccm_emulator_queue_event("OK 3 0 CONLOST"));
+
+    CHECK(ccm_host_app_run(events_handled, TEST_RUN_TIME));
+    CHECK(connect_events == 1);
+    CHECK(other_events == 2);
+
+    ccm_emulator_get_stats(&stats);
+    CHECK(stats.edges == 1);
+    CHECK(stats.events == 3);
+    CHECK(ccm_event_get_stats()->last_batch == 3);
+
+    /* CONLOST is the last word on the connection, no probe needed */
+    CHECK(is_aws_connected() == 0);
+    CHECK(ccm_emulator_command_count("AT+CONNECT?") == 0);
+}
+
+/* AT+CONNECT, without the AT+CONNECT? probes */
+static uint32_t connect_commands(void)
+{
+    return ccm_emulator_command_count("AT+CONNECT") - ccm_emulator_command_count("AT+CONNECT?");
+}
+
+static void message_handler(uint8_t index, const uint8_t *data, uint16_t length, bool last, bool ok, void *arg)
+{
+    (void)index;
+    (void)arg;
+
+    if (!last)
+    {
+        return;
+    }
+
+    if (!ok)
+    {
+        incomplete_count++;
+        return;
+    }
+
+    if (received_count < TEST_MESSAGES)
+    {
+        memcpy(received[received_count], data, length);
+        received[received_count][length] = '\0';
+    }
+    received_count++;
+}
+
+static bool messages_received(void)
+{
+    return (received_count + incomplete_count) >= TEST_MESSAGES;
+}
+
+/* Boot to subscribed from a disconnected module, then receive messages */
+static void test_subscribe(void)
+{
+    ccm_emulator_config_t config = default_config;
+    char payload[32];
+
+    config.aws_connected = false;
+    ccm_host_app_init(&config);
+    CHECK(ccm_subscription_register(1, "data", message_handler, NULL, message_buffer, sizeof(message_buffer)));
+
+    CHECK(ccm_host_app_connect_and_subscribe(CCM_TIMEOUT_AUTO));
+    CHECK(ccm_emulator_command_count("AT+CONF Endpoint=") == 1);
+    CHECK(connect_commands() == 1);
+    CHECK(ccm_emulator_command_count("AT+CONF Topic1=data") == 1);
+    CHECK(ccm_emulator_command_count("AT+SUBSCRIBE1") == 1);
+    CHECK(ccm_boot_time("subscribed") > 0);
+
+    for (uint32_t i = 0; i < TEST_MESSAGES; i++)
+    {
+        snprintf(payload, sizeof(payload), "{\"n\":%lu}", (unsigned long)i);
+        CHECK(ccm_emulator_publish(1, payload));
+    }
+
+    CHECK(ccm_host_app_run(messages_received, TEST_RUN_TIME));
+    CHECK(received_count == TEST_MESSAGES);
+    CHECK(incomplete_count == 0);
+    CHECK(!strcmp(received[0], "{\"n\":0}"));
+    CHECK(!strcmp(received[TEST_MESSAGES - 1u], "{\"n\":4}"));
+}
+
+static void batch_handler(uint8_t index, const ccm_message_t *messages, uint8_t count, void *arg)
+{
+    (void)index;
+    (void)arg;
+
+    batch_count++;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (messages[i].truncated)
+        {
+            incomplete_count++;
+        }
+        else if (received_count < TEST_MESSAGES)
+        {
+            memcpy(received[received_count], messages[i].data, messages[i].length);
+            received[received_count][messages[i].length] = '\0';
+            received_count++;
+        }
+    }
+}
+
+/* A burst of messages is fetched after the drain and passed as one batch */
+static void test_batch(void)
+{
+    ccm_host_app_init(&default_config);
+    CHECK(ccm_subscription_register_batch(1, "data", batch_handler, NULL, message_buffer, sizeof(message_buffer),
+                                          CCM_COALESCE_NONE));
+    CHECK(ccm_host_app_connect_and_subscribe(CCM_TIMEOUT_AUTO));
+    CHECK(connect_commands() == 0);
+
+    for (uint32_t i = 0; i < TEST_MESSAGES; i++)
+    {
+        CHECK(ccm_emulator_publish(1, "batched"));
+    }
+
+    CHECK(ccm_host_app_run(messages_received, TEST_RUN_TIME));
+    CHECK(received_count == TEST_MESSAGES);
+    CHECK(incomplete_count == 0);
+    CHECK(batch_count == 1);
+}
+
+/* A message not received completely is reported as such */
+static void test_message_faults(void)
+{
+    static const ccm_emulator_rule_t error_script[] = {
+        {"AT+GET1", "ERR5 EMULATED GET ERROR\r\n"}};
+    static const ccm_emulator_rule_t silent_script[] = {
+        {"AT+GET1", NULL}};
+
+    ccm_host_app_init(&default_config);
+    CHECK(ccm_subscription_register(1, "data", message_handler, NULL, message_buffer, sizeof(message_buffer)));
+    CHECK(ccm_host_app_connect_and_subscribe(CCM_TIMEOUT_AUTO));
+
+    ccm_emulator_set_script(error_script, 1);
+    CHECK(ccm_emulator_publish(1, "lost"));
+    CHECK(ccm_host_app_run(messages_received, 2u * TEST_DELAY) == false);
+    CHECK(incomplete_count == 1);
+
+    ccm_emulator_set_script(silent_script, 1);
+    CHECK(ccm_emulator_publish(1, "lost"));
+    CHECK(ccm_host_app_run(messages_received, TEST_RUN_TIME) == false);
+    CHECK(incomplete_count == 2);
+
+    /* The module keeps a message until it is read, the oldest one comes first */
+    ccm_emulator_set_script(NULL, 0);
+    CHECK(ccm_emulator_publish(1, "kept"));
+    CHECK(ccm_host_app_run(messages_received, TEST_RUN_TIME) == false);
+    CHECK(received_count == 1);
+    CHECK(!strcmp(received[0], "lost"));
+}
+
+/* [] END OF FILE */
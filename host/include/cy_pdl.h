@@ -0,0 +1,61 @@
+/******************************************************************************
+ * File Name: cy_pdl.h
+ *
+ * Description: Host stand-in for the PSoC 6 peripheral driver library header,
+ * used by the host build of the CCM link (see host/Makefile). Only the macros
+ * and functions the CCM link sources refer to are defined; the flash sections
+ * are plain RAM on the host.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CY_PDL_H_
+#define CY_PDL_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+#include "string.h"
+#include "stdlib.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define CY_SECTION(name)
+#define CY_ALIGN(align) __attribute__((aligned(align)))
+#define CY_NOINIT
+
+#define CY_FLASH_SIZEOF_ROW (512u)
+
+#define CY_RSLT_SUCCESS (0u)
+
+/* A failed assertion ends the host program */
+#define CY_ASSERT(condition) \
+    do                       \
+    {                        \
+        if (!(condition))    \
+        {                    \
+            abort();         \
+        }                    \
+    } while (0)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef uint32_t cy_rslt_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+static inline void __disable_irq(void)
+{
+}
+
+static inline void __enable_irq(void)
+{
+}
+
+#endif /* CY_PDL_H_ */
@@ -0,0 +1,19 @@
+/******************************************************************************
+ * File Name: cy_retarget_io.h
+ *
+ * Description: Host stand-in for the retarget-io header, used by the host
+ * build of the CCM link (see host/Makefile). printf writes to the standard
+ * output of the host program.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CY_RETARGET_IO_H_
+#define CY_RETARGET_IO_H_
+
+#include "stdio.h"
+
+#endif /* CY_RETARGET_IO_H_ */
@@ -0,0 +1,19 @@
+/******************************************************************************
+ * File Name: cybsp.h
+ *
+ * Description: Host stand-in for the board support package header, used by
+ * the host build of the CCM link (see host/Makefile). The host has no board,
+ * ccm_hal_board_init() of host/ccm_hal_host.c does nothing.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CYBSP_H_
+#define CYBSP_H_
+
+#include "cyhal.h"
+
+#endif /* CYBSP_H_ */
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * File Name: cyhal.h
+ *
+ * Description: Host stand-in for the cyhal header, used by the host build of
+ * the CCM link (see host/Makefile). The UART, timer and power mode API's are
+ * not needed, the host implements ccm_hal.h directly (host/ccm_hal_host.c).
+ * The host has no flash: cyhal_flash_init() fails, so that the configuration
+ * fingerprint is never written and every AT+CONF command is sent.
+ *
+ * Related Document: README.md
+ *
+ ********************************************************************************
+ * $ Copyright 2023 Cypress Semiconductor $
+ *******************************************************************************/
+
+#ifndef CYHAL_H_
+#define CYHAL_H_
+
+#include "cy_pdl.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define CYHAL_FLASH_RSLT_ERR_NOT_SUPPORTED (1u)
+
+/*******************************************************************************
+ * Data structures
+ *******************************************************************************/
+typedef struct
+{
+    uint8_t unused;
+} cyhal_flash_t;
+
+/*******************************************************************************
+ * Function prototypes
+ *******************************************************************************/
+static inline cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj)
+{
+    (void)obj;
+    return CYHAL_FLASH_RSLT_ERR_NOT_SUPPORTED;
+}
+
+static inline cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data)
+{
+    (void)obj;
+    (void)address;
+    (void)data;
+    return CYHAL_FLASH_RSLT_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CYHAL_H_ */
@@ -11,22 +11,45 @@
  * $ Copyright 2023 Cypress Semiconductor $
  ********************************************************************************/
 #include "CCM.h"
+#include "ccm_boot.h"
+#include "ccm_command_queue.h"
+#include "ccm_config.h"
+#include "ccm_ota.h"
+#include "ccm_event.h"
+#include "ccm_health.h"
+#include "ccm_parser.h"
+#include "ccm_publish.h"
+#include "ccm_settings.h"
+#include "ccm_soak.h"
+#include "ccm_subscription.h"
+#include "ccm_stats.h"
+#include "ccm_spool.h"
+#include "ccm_supervisor.h"
+#include "heap_usage.h"
+#include "ccm_rtos.h"
 
 /*******************************************************************************
  * Macros
  *******************************************************************************/
-/* define MODIFY_SSID macro as 1 for disconnecting the existing Wi-Fi connection and
- * connect to different Access point*/
-#define MODIFY_SSID_AFTER_CONNECTED (0)
+/* Default settings, used until settings are saved at runtime (see
+ * ccm_settings.c). Flow: CCM_FLOW_AWS or CCM_FLOW_CIRRENT. Onboarding:
+ * CCM_ONBOARDING_CREDENTIALS (SSID and Passphrase below) or
+ * CCM_ONBOARDING_CIRRENT_APP (Wi-Fi onboarding via Cirrent APP). An empty
+ * SSID, Passphrase or Endpoint is not sent, the CCM module keeps its own*/
+#define DEFAULT_FLOW CCM_FLOW_AWS
+#define DEFAULT_ONBOARDING CCM_ONBOARDING_CREDENTIALS
+#define DEFAULT_SSID ""
+#define DEFAULT_PASSPHRASE ""
+#define DEFAULT_ENDPOINT ""
 
-/* define CIRRENT_APP_ONBOARDING macro as 1 for Wi-Fi Onboarding via Cirrent APP.*/
-#define CIRRENT_APP_ONBOARDING (0)
+/* define FAST_START macro as 1 to probe the Wi-Fi and AWS connections in one
+ * pipelined batch, and in the Cirrent flow to poll for the endpoint switch
+ * instead of waiting MAX_CONNECT_DELAY*/
+#define FAST_START (1)
 
-/*define AWS_FLOW macro as 1 for choosing AWS flow and 0 for Cirrent flow*/
-#define AWS_FLOW (1)
-
-/* Max response delay in milliseconds for AT commands*/
-#define RESPONSE_DELAY (120000)
+/* Response delay for AT commands: per command class, adapted to the observed
+ * latency (see ccm_timeout.c). Use a value in milliseconds for a fixed delay*/
+#define RESPONSE_DELAY (CCM_TIMEOUT_AUTO)
 
 #define GPIO_INTERRUPT_PRIORITY (7u)
 
@@ -36,32 +59,153 @@
 /* CCM evaluation kits event pin is connected to P5_5*/
 #define EVENT_PIN P5_5
 
+/* Longest wait between the Wi-Fi checks while onboarding via Cirrent APP, an
+ * EVENT pin edge checks at once*/
 #define POLLING_DELAY (60000)
 
-/* Set SSID, Passphrase and Endpoint as follows
- * AT+CONF SSID=XXXX\n; where XXXX is the required SSID
- * AT+CONF Passphrase=YYYY\n ; YYYY is the Passphrase
- * AT+CONF EndPoint=ZZZZ\n; ZZZZ is the endpoint
- */
+/* Time the CCM module takes to switch to the endpoint from Cirrent Cloud, ms*/
+#define MAX_CONNECT_DELAY (120000)
+
+/* Fast start: interval of the endpoint switch probes, ms*/
+#define ENDPOINT_PROBE_INTERVAL (5000u)
+
+/* Default topic the application subscribes to, and its CCM topic index*/
+#define DEFAULT_DATA_TOPIC "data"
+#define DATA_TOPIC_INDEX (1u)
+
+/* Holds the data messages announced by the MSG events of one event drain,
+ * fetched back to back once the drain is complete*/
+#define DATA_BATCH_SIZE (2048u)
+
+/* Topic of the settings messages, e.g. {"flow":"cirrent"}: the changed
+ * settings are saved and the host restarts to use them*/
+#define SETTINGS_TOPIC "settings"
+#define SETTINGS_TOPIC_INDEX (2u)
+
+/* Topic the acknowledgements and status records are published to, batched*/
+#define TELEMETRY_TOPIC "telemetry"
+#define TELEMETRY_TOPIC_INDEX (3u)
+
+/* The OTA image is applied once no message was received for this long, ms*/
+#define OTA_QUIET_TIME (30000u)
 
-#define SET_SSID "AT+CONF SSID=\n"
-#define SET_PASSPHRASE "AT+CONF Passphrase=\n"
-#define SET_ENDPOINT "AT+CONF Endpoint=\n"
+#if CCM_RTOS
+/* Application task, processes the received messages while the next ones are
+ * downloaded by the AT link task*/
+#define APP_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+#define APP_TASK_STACK_SIZE (1024u)
+
+/* Messages handed from the AT link task to the application task*/
+#define APP_MESSAGE_COUNT (2u)
+#define APP_MESSAGE_SIZE (2048u)
+#endif
 
 /*******************************************************************************
  * Global Variables
  *******************************************************************************/
-bool gpio_intr_flag = false;
+/* Set from the EVENT pin interrupt, volatile as it wakes up the main loop*/
+volatile bool gpio_intr_flag = false;
 int result = 0;
-char *response = NULL;
+
+static const ccm_settings_t default_settings = {
+    .flow = DEFAULT_FLOW,
+    .onboarding = DEFAULT_ONBOARDING,
+    .ssid = DEFAULT_SSID,
+    .passphrase = DEFAULT_PASSPHRASE,
+    .endpoint = DEFAULT_ENDPOINT,
+    .topic = DEFAULT_DATA_TOPIC};
+
+/* Settings loaded at boot*/
+static const ccm_settings_t *settings;
+
+/* Parser of the settings messages*/
+static ccm_parser_t settings_parser;
+
+/* Outcome of the last AT+CONNECT, AWS flow*/
+static ccm_error_class_t connect_error = CCM_ERROR_NONE;
+
+/* Time of the last received message, for the OTA policy*/
+static volatile uint32_t last_message_time = 0;
+
+/* Messages processed since boot, acknowledged on the telemetry topic*/
+static uint32_t messages_processed = 0;
+
+#if CCM_SPOOL
+/* A message received for the spool, one byte over the longest record so that
+ * the spool flags a longer message as truncated*/
+static uint8_t spool_message[CCM_SPOOL_RECORD_MAX + 1];
+#else
+/* Data messages of one event drain*/
+static uint8_t data_batch[DATA_BATCH_SIZE];
+#endif
+
+#if CCM_RTOS
+/* A received message, longer messages are truncated*/
+typedef struct
+{
+    uint8_t data[APP_MESSAGE_SIZE];
+    uint16_t length;
+    uint8_t index;
+    bool truncated;
+} app_message_t;
+
+static StaticTask_t app_task_tcb;
+static StackType_t app_task_stack[APP_TASK_STACK_SIZE];
+
+/* Message buffers circulate between the free and the ready queue. A NULL
+ * message in the ready queue asks the application task to restart the host,
+ * it has one more entry for it*/
+static app_message_t app_messages[APP_MESSAGE_COUNT];
+static app_message_t *app_message_filling;
+static QueueHandle_t app_message_free;
+static QueueHandle_t app_message_ready;
+static StaticQueue_t app_message_free_queue;
+static StaticQueue_t app_message_ready_queue;
+static uint8_t app_message_free_storage[APP_MESSAGE_COUNT * sizeof(app_message_t *)];
+static uint8_t app_message_ready_storage[(APP_MESSAGE_COUNT + 1) * sizeof(app_message_t *)];
+static bool restart_requested;
+#endif
 
 /******************************************************************************
  * Function Prototypes
  *******************************************************************************/
 
 static void wifionboarding(void);
+static void connect_and_subscribe(void);
+#if FAST_START
+static void wait_for_endpoint_switch(uint32_t);
+#endif
+static void wait_for_event(uint32_t);
+static void configure_and_connect(bool);
+static void submit_setting(const char *, const char *);
+static bool setting_is_current(const char *, const char *);
+static bool wifi_credentials_changed(void);
+static ccm_error_class_t aws_connect_attempt(void *);
+#if CCM_RTOS
+static void app_task(void *);
+#endif
 static void gpio_interrupt_handler(void *, cyhal_gpio_event_t);
 static void empty_event_queue(void);
+#if !CCM_RTOS
+static bool event_pending(void);
+#endif
+static void message_received(void);
+static void acknowledge_message(uint8_t);
+static void message_chunk_handler(uint8_t, const uint8_t *, uint16_t, bool, bool, void *);
+#if CCM_SPOOL
+static void spool_message_handler(uint8_t, const uint8_t *, uint16_t, bool, bool, void *);
+static bool process_spooled_message(void);
+#else
+static void data_batch_handler(uint8_t, const ccm_message_t *, uint8_t, void *);
+#endif
+static void settings_message_handler(uint8_t, const uint8_t *, uint16_t, bool, bool, void *);
+static void request_restart(void);
+static void restart_host(void);
+static void connect_result_handler(ccm_response_t *, int, void *);
+static void health_handler(ccm_link_state_t, void *);
+static bool ota_policy(ccm_ota_action_t, void *);
+static void startup_event_handler(ccm_response_t *);
+static void unknown_event_handler(ccm_response_t *);
 
 /*******************************************************************************
  * Function Name: main
@@ -83,9 +227,25 @@ int main()
         .callback = gpio_interrupt_handler,
         .callback_arg = NULL};
 
+    /* Paint the stack for the memory budget report, before anything else runs*/
+    memory_budget_init();
+
     bsp_init();
 
     uart_init();
+    ccm_boot_mark("uart_init");
+
+    /* Speed up the link to the CCM module if both sides support it */
+    ccm_negotiate_baud_rate();
+    ccm_boot_mark("baud rate negotiated");
+
+    /* What the CCM module was configured with before the reset*/
+    ccm_config_init();
+
+    /* Flow, credentials and topic, saved at runtime or the defaults*/
+    ccm_settings_init(&default_settings);
+    settings = ccm_settings_get();
+    ccm_parser_init(&settings_parser, ccm_settings_field_handler, NULL);
 
     cyhal_gpio_init(EVENT_PIN, CYHAL_GPIO_DIR_INPUT,
                     CYHAL_GPIO_DRIVE_NONE, CYBSP_LED_STATE_OFF);
@@ -97,40 +257,170 @@ int main()
 
     printf("\r ******************AIROC™ CCM MQTT OTA AND SUBSCRIBE******************\n");
 
-#if MODIFY_SSID_AFTER_CONNECTED
+    /* Topics to subscribe to, the messages of each topic go to its own handler*/
+#if CCM_SPOOL
+    /* Received messages go to the flash spool, processed from the main loop*/
+    ccm_spool_init();
+    ccm_subscription_register(DATA_TOPIC_INDEX, settings->topic, spool_message_handler, NULL,
+                              spool_message, sizeof(spool_message));
+#else
+    /* A burst of messages is fetched after the event drain and processed as one batch*/
+    ccm_subscription_register_batch(DATA_TOPIC_INDEX, settings->topic, data_batch_handler, NULL,
+                                    data_batch, sizeof(data_batch), CCM_COALESCE_NONE);
+#endif
+    ccm_subscription_register(SETTINGS_TOPIC_INDEX, SETTINGS_TOPIC, settings_message_handler, NULL, NULL, 0);
+    ccm_publish_register(TELEMETRY_TOPIC_INDEX, TELEMETRY_TOPIC);
 
-    /* AT command for disconnecting from Wi-Fi network */
-    at_command_send_receive("AT+DISCONNECT\n", RESPONSE_DELAY, &result, NULL);
+    /* Handlers of the CCM events, add new events by registering their handler*/
+    ccm_ota_init(ota_policy, NULL);
+    ccm_event_register(CCM_EVENT_STARTUP, 0, startup_event_handler);
+    ccm_event_set_default_handler(unknown_event_handler);
 
-#endif
+#if CCM_RTOS
 
-#if AWS_FLOW
+    /* The AT link and log tasks, the application task connects and subscribes
+     * once the scheduler runs, then processes the received messages*/
+    ccm_rtos_init();
 
-    if (!is_aws_connected())
+    app_message_free = xQueueCreateStatic(APP_MESSAGE_COUNT, sizeof(app_message_t *),
+                                          app_message_free_storage, &app_message_free_queue);
+    app_message_ready = xQueueCreateStatic(APP_MESSAGE_COUNT + 1, sizeof(app_message_t *),
+                                           app_message_ready_storage, &app_message_ready_queue);
+    for (uint32_t i = 0; i < APP_MESSAGE_COUNT; i++)
     {
+        app_message_t *message = &app_messages[i];
+        xQueueSend(app_message_free, &message, 0);
+    }
 
-        /*AT command for sending Device Endpoint*/
-        at_command_send_receive(SET_ENDPOINT, RESPONSE_DELAY, &result, NULL);
+    xTaskCreateStatic(app_task, "app", APP_TASK_STACK_SIZE, NULL, APP_TASK_PRIORITY,
+                      app_task_stack, &app_task_tcb);
 
-        /*Connect to Wi-Fi network if it is not connected already*/
-        if (!is_wifi_connected())
+    vTaskStartScheduler();
+
+    /* vTaskStartScheduler() only returns if the kernel could not start*/
+    handle_error();
+
+#else
+
+    connect_and_subscribe();
+
+    while (1)
+    {
+
+        if (gpio_intr_flag)
         {
-            wifionboarding();
+            /* Cleared before draining so that an edge seen while draining is not lost*/
+            gpio_intr_flag = false;
+
+            /* Handle every event queued in the CCM module, the queue may still hold
+             * events if the drain limit was hit: come back without waiting for an edge*/
+            if (ccm_event_drain(RESPONSE_DELAY, true) >= CCM_EVENT_DRAIN_MAX)
+            {
+                gpio_intr_flag = true;
+            }
         }
+        else
+        {
+#if CCM_SPOOL
+            /* Spooled messages are processed one per pass, an EVENT pin edge goes first*/
+            if (process_spooled_message())
+            {
+                continue;
+            }
 
-        /*AT command for Connecting to AWS Cloud*/
-        at_command_send_receive("AT+CONNECT\n", RESPONSE_DELAY, &result, "OK 1 CONNECTED\r\n");
+#endif
+            /* OTA commands are sent between the event drains, when the policy allows*/
+            uint32_t wait = ccm_ota_process(RESPONSE_DELAY);
 
-        if (result != SUCCESS)
-        {
-            handle_error();
+            /* The connection is only probed once no message arrived for a while*/
+            uint32_t health_wait = ccm_health_process(RESPONSE_DELAY);
+
+            /* One telemetry batch per pass, an EVENT pin edge goes first*/
+            uint32_t publish_wait = ccm_publish_process(RESPONSE_DELAY);
+
+            /* Soak test load and reports, when built with SOAK=1*/
+            uint32_t soak_wait = ccm_soak_process(RESPONSE_DELAY);
+
+            if (health_wait < wait)
+            {
+                wait = health_wait;
+            }
+            if (publish_wait < wait)
+            {
+                wait = publish_wait;
+            }
+            if (soak_wait < wait)
+            {
+                wait = soak_wait;
+            }
+
+#if CCM_SPOOL
+            /* Messages waiting in RAM only reach the flash within CCM_SPOOL_SYNC_INTERVAL*/
+            uint32_t spool_wait = ccm_spool_process();
+
+            if (spool_wait < wait)
+            {
+                wait = spool_wait;
+            }
+
+#endif
+            /* Nothing to do until the next EVENT pin rising edge, OTA step,
+             * health check, telemetry batch or spool row write, the GPIO interrupt and the low
+             * power timer wake the system from deep sleep*/
+            ccm_deep_sleep_timeout(event_pending, wait);
         }
     }
 
-#else
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: connect_and_subscribe
+ *******************************************************************************
+ * Summary: Connect the CCM module to AWS IoT core if it is not connected
+ *          already and subscribe to the registered topics.
+ *
+ *******************************************************************************/
+static void connect_and_subscribe(void)
+{
+    CCM_LOG(CCM_LOG_INFO, (settings->flow == CCM_FLOW_AWS) ? "\rAWS flow\n" : "\rCirrent flow\n");
+
+    /* Disconnect from the access point the CCM module may still be connected to,
+     * the onboarding sends the new credentials*/
+    if (wifi_credentials_changed())
+    {
+        CCM_LOG(CCM_LOG_INFO, "\rWi-Fi credentials changed, disconnecting\n");
+
+        /* AT command for disconnecting from Wi-Fi network */
+        ccm_response_release(at_command_execute(CCM_CMD_DISCONNECT, RESPONSE_DELAY, &result));
+
+        ccm_link_set_wifi_state(CCM_LINK_DOWN);
+    }
+
+#if FAST_START
+    /* Both connection states in one pipelined batch, the checks below use them*/
+    ccm_boot_probe_links(RESPONSE_DELAY);
+#endif
+    ccm_boot_mark("connection probed");
+
+    if (settings->flow == CCM_FLOW_AWS)
+    {
+        if (!is_aws_connected())
+        {
+            /* Retried with backoff, the host is reset if the CCM module does not
+             * connect within the retry budget*/
+            if (!ccm_supervisor_run("AWS connect", aws_connect_attempt, NULL))
+            {
+                /* Settings saved since the last connection are not kept*/
+                ccm_settings_revert();
+                ccm_supervisor_escalate();
+            }
 
+            ccm_link_set_aws_state(CCM_LINK_UP);
+        }
+    }
     /*Check if CCM module already connected to AWS*/
-    if (!is_aws_connected())
+    else if (!is_aws_connected())
     {
 
         /*Connect to Wi-Fi network if it is not connected already*/
@@ -140,77 +430,303 @@ int main()
         }
 
         /*AT command for Connecting CCM device to AWS staging*/
-        at_command_send_receive("AT+CONNECT\n", RESPONSE_DELAY, &result, NULL);
+        ccm_command_queue_submit_id(CCM_CMD_CONNECT, RESPONSE_DELAY, CCM_COMMAND_FLAG_BARRIER, NULL, NULL);
 
         /*AT command for Getting Endpoint from Cirrent Cloud*/
-        at_command_send_receive("AT+CLOUD_SYNC\n", RESPONSE_DELAY, &result, NULL);
+        ccm_command_queue_submit_id(CCM_CMD_CLOUD_SYNC, RESPONSE_DELAY, CCM_COMMAND_FLAG_NONE, NULL, NULL);
+
+        ccm_command_queue_flush();
 
         /* Check in Cirrent console if the Job executed succesfully */
-        printf("\nThe Connection Automatically switches to the new endpoint after 120 seconds\n\n");
+        CCM_LOG(CCM_LOG_INFO, "\nThe Connection Automatically switches to the new endpoint after 120 seconds\n\n");
 
+#if FAST_START
+        wait_for_endpoint_switch(MAX_CONNECT_DELAY);
+#else
         delay_ms(MAX_CONNECT_DELAY);
+#endif
 
-        while (!is_aws_connected())
-            ;
+        /* Probe until the connection switched to the new endpoint*/
+        if (!ccm_supervisor_run("Endpoint switch", aws_connect_attempt, NULL))
+        {
+            ccm_settings_revert();
+            ccm_supervisor_escalate();
+        }
     }
 
-#endif
-    /* AT commands for storing the topic name and subscribing to it*/
-    at_command_send_receive("AT+CONF Topic1=data\n", RESPONSE_DELAY, &result, NULL);
+    ccm_boot_mark("AWS connected");
+
+    /* Settings saved at runtime connected, keep them over the next saves*/
+    ccm_settings_confirm();
+
+    /* AT commands for storing the topic names and subscribing to them, pipelined
+     * for all the registered topics, sent once more if one of them failed*/
+    if (!ccm_subscription_start(RESPONSE_DELAY) && !ccm_subscription_start(RESPONSE_DELAY))
+    {
+        CCM_LOG(CCM_LOG_ERROR, "\nSubscribing failed, messages of some topics are not received\n\r");
+    }
+    ccm_publish_start(RESPONSE_DELAY);
+    ccm_boot_mark("subscribed");
 
-    at_command_send_receive("AT+SUBSCRIBE1\n", RESPONSE_DELAY, &result, NULL);
+    /* Remember the configuration acknowledged by the CCM module for the next boot*/
+    ccm_config_commit();
 
     empty_event_queue();
 
-    while (1)
+    /* Liveness from the received messages and events from here on*/
+    ccm_health_init(health_handler, NULL);
+
+    /* Soak test load on the data topic, when built with SOAK=1*/
+    ccm_soak_init(DATA_TOPIC_INDEX);
+
+    /* Where the time from boot to subscribed went, per phase and per AT command*/
+    ccm_boot_dump();
+    ccm_stats_dump();
+
+    /* From here on the memory use must not grow*/
+    print_heap_usage("Subscribed\r\n");
+    memory_budget_mark_steady_state();
+}
+
+#if FAST_START
+/*******************************************************************************
+ * Function Name: wait_for_endpoint_switch
+ *******************************************************************************
+ * Summary: Probe AT+CONNECT? until the CCM module is connected to the endpoint
+ *          from Cirrent Cloud, for at most timeout ms. Sleeps between the
+ *          probes; an EVENT pin edge (CONLOST while switching) probes at once.
+ *
+ *******************************************************************************/
+static void wait_for_endpoint_switch(uint32_t timeout)
+{
+    uint32_t start = ccm_get_time_ms();
+    uint32_t elapsed = 0;
+
+    while (elapsed < timeout)
     {
+        uint32_t wait = timeout - elapsed;
 
-        if (gpio_intr_flag)
+        if (wait > ENDPOINT_PROBE_INTERVAL)
         {
-            /* AT command for checking the events queued in CCM module*/
-            response = at_command_send_receive("AT+EVENT?\n", RESPONSE_DELAY, &result, NULL);
+            wait = ENDPOINT_PROBE_INTERVAL;
+        }
 
-            /* New message available in the subscribed topic event*/
-            if (!strcmp("OK 1 1 MSG\r\n", response))
-            {
-                printf("\nNew message notification on the subscribed topic\n\n\r");
-                /*AT command to receive the message from the subscribed topic */
-                at_command_send_receive("AT+GET1\n", RESPONSE_DELAY, &result, NULL);
-            }
+        wait_for_event(wait);
 
-            /*OTA event*/
-            else if (!strcmp("OK 5 1 OTA\r\n", response))
-            {
-                printf("\nNew OTA firmware available notificaiton\n\n\r");
-                /*Download the firmware*/
-                at_command_send_receive("AT+OTA ACCEPT\n", RESPONSE_DELAY, &result, NULL);
-            }
+        ccm_link_invalidate();
+        if (is_aws_connected())
+        {
+            return;
+        }
 
-            /*Event denoting that the downloaded OTA firmware is Verified */
-            else if (!strcmp("OK 5 4 OTA\r\n", response))
-            {
-                printf("\nThe new OTA firmware image verified notification\n\n\r");
-                /*Apply the new firmware*/
-                at_command_send_receive("AT+OTA APPLY\n", RESPONSE_DELAY, &result, NULL);
-            }
+        elapsed = ccm_get_time_ms() - start;
+    }
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: wait_for_event
+ *******************************************************************************
+ * Summary: Sleep for timeout ms, or until an EVENT pin edge in the bare metal
+ *          build. The events are discarded, the caller checks the connection
+ *          state.
+ *
+ *******************************************************************************/
+static void wait_for_event(uint32_t timeout)
+{
+#if CCM_RTOS
+    vTaskDelay(pdMS_TO_TICKS(timeout));
+#else
+    ccm_deep_sleep_timeout(event_pending, timeout);
+
+    if (gpio_intr_flag)
+    {
+        gpio_intr_flag = false;
+        empty_event_queue();
+    }
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: configure_and_connect
+ *******************************************************************************
+ * Summary: Send the AWS and Wi-Fi configuration that changed since the last
+ *          boot, then AT+CONNECT. The outcome of AT+CONNECT is stored in
+ *          connect_error.
+ *
+ * input parameter: bool wifi_connected
+ *                  Skip the Wi-Fi onboarding
+ *
+ *******************************************************************************/
+static void configure_and_connect(bool wifi_connected)
+{
+    connect_error = CCM_ERROR_TIMEOUT;
+
+    /*AT command for sending Device Endpoint, pipelined with the Wi-Fi credentials*/
+    submit_setting("Endpoint", settings->endpoint);
+
+    /*Connect to Wi-Fi network if it is not connected already*/
+    if (!wifi_connected)
+    {
+        wifionboarding();
+    }
+
+    /*AT command for Connecting to AWS Cloud, sent once the configuration is acknowledged*/
+    ccm_command_queue_submit_id(CCM_CMD_CONNECT, RESPONSE_DELAY, CCM_COMMAND_FLAG_BARRIER,
+                                connect_result_handler, &connect_error);
+
+    ccm_command_queue_flush();
+}
+
+/*******************************************************************************
+ * Function Name: submit_setting
+ *******************************************************************************
+ * Summary: Queue AT+CONF <key>=<value> unless the value is empty or was
+ *          acknowledged before (see ccm_config.c).
+ *
+ *******************************************************************************/
+static void submit_setting(const char *key, const char *value)
+{
+    char command[CCM_COMMAND_MAX_LENGTH];
+
+    if ((value[0] != '\0') &&
+        (snprintf(command, sizeof(command), "AT+CONF %s=%s\n", key, value) < (int)sizeof(command)))
+    {
+        ccm_config_submit(command, RESPONSE_DELAY, CCM_COMMAND_FLAG_NONE);
+    }
+}
+
+/* True if the CCM module acknowledged AT+CONF <key>=<value> before, or the value is empty*/
+static bool setting_is_current(const char *key, const char *value)
+{
+    char command[CCM_COMMAND_MAX_LENGTH];
+
+    if (value[0] == '\0')
+    {
+        return true;
+    }
+
+    snprintf(command, sizeof(command), "AT+CONF %s=%s\n", key, value);
+
+    return ccm_config_is_current(command);
+}
+
+/*******************************************************************************
+ * Function Name: wifi_credentials_changed
+ *******************************************************************************
+ * Summary: Check whether the SSID or Passphrase of the settings differ from
+ *          the ones last acknowledged by the CCM module. Also true on the first
+ *          boot with credentials, as the module configuration is not known.
+ *
+ *******************************************************************************/
+static bool wifi_credentials_changed(void)
+{
+    return (settings->onboarding == CCM_ONBOARDING_CREDENTIALS) && (settings->ssid[0] != '\0') &&
+           (!setting_is_current("SSID", settings->ssid) || !setting_is_current("Passphrase", settings->passphrase));
+}
+
+/*******************************************************************************
+ * Function Name: aws_connect_attempt
+ *******************************************************************************
+ * Summary: One connection attempt of the connection supervisor. AWS flow:
+ *          configure and connect. Cirrent flow: check whether the CCM module
+ *          switched to the new endpoint.
+ *
+ * Return:
+ *  ccm_error_class_t - CCM_ERROR_NONE once connected to AWS IoT core.
+ *
+ *******************************************************************************/
+static ccm_error_class_t aws_connect_attempt(void *arg)
+{
+    if (settings->flow == CCM_FLOW_CIRRENT)
+    {
+        ccm_link_invalidate();
+
+        return is_aws_connected() ? CCM_ERROR_NONE : CCM_ERROR_NOT_CONNECTED;
+    }
+
+    configure_and_connect(is_wifi_connected());
+
+    /* The configuration not sent as unchanged may be lost (CCM module reset
+     * to factory settings or replaced): send all of it and connect again*/
+    if ((connect_error != CCM_ERROR_NONE) && ccm_config_skipped())
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nConnection failed with the stored configuration, configuring again\n\r");
+
+        ccm_config_invalidate();
+        configure_and_connect(false);
+    }
+
+    /* A Wi-Fi failure may be a lost access point: probe it again next time*/
+    if (connect_error != CCM_ERROR_NONE)
+    {
+        ccm_link_invalidate();
+    }
+
+    return connect_error;
+}
+
+#if CCM_RTOS
+/*******************************************************************************
+ * Function Name: app_task
+ *******************************************************************************
+ * Summary: Application task of the RTOS build: connect and subscribe, start
+ *          the event task, then process the received messages. Replace the
+ *          printing with the application specific message processing.
+ *
+ *******************************************************************************/
+static void app_task(void *arg)
+{
+    app_message_t *message = NULL;
+    uint32_t wait = 0;
+    uint32_t publish_wait = 0;
+    uint32_t soak_wait = 0;
+
+    connect_and_subscribe();
+
+    ccm_rtos_event_task_start(RESPONSE_DELAY);
 
-            /* Boot up event*/
-            else if (!strcmp("OK 2 0 STARTUP\r\n", response))
+    while (1)
+    {
+        /* The connection is only probed once no message arrived for a while*/
+        wait = ccm_health_process(RESPONSE_DELAY);
+
+        /* One telemetry batch per pass, a received message goes first*/
+        publish_wait = ccm_publish_process(RESPONSE_DELAY);
+        if (publish_wait < wait)
+        {
+            wait = publish_wait;
+        }
+
+        /* Soak test load and reports, when built with SOAK=1*/
+        soak_wait = ccm_soak_process(RESPONSE_DELAY);
+        if (soak_wait < wait)
+        {
+            wait = soak_wait;
+        }
+
+        if (pdPASS == xQueueReceive(app_message_ready, &message, pdMS_TO_TICKS(wait)))
+        {
+            if (message == NULL)
             {
-                printf("\nStart up event notification\n\n\r");
-                /*Host software reset*/
-                NVIC_SystemReset();
+                restart_host();
+                continue;
             }
 
-            gpio_intr_flag = false;
+            ccm_log_data(CCM_LOG_INFO, message->data, message->length);
+            CCM_LOG(CCM_LOG_INFO, message->truncated ? " (truncated)\n\r" : "\n\r");
+            acknowledge_message(message->index);
+
+            xQueueSend(app_message_free, &message, portMAX_DELAY);
         }
     }
 }
+#endif
 
 /*******************************************************************************
  * Function Name: wifionboarding
  *******************************************************************************
- * Summary: Send AT commands to set SSID and Passphrase for CCM module.
+ * Summary: Queue AT commands to set SSID and Passphrase for CCM module.
  *                                  or
  *          Send AT command to enter Onboarding mode and connect to Wi-Fi via Cirrent APP
  * Return:
@@ -221,42 +737,411 @@ int main()
 static void wifionboarding()
 {
 
-#if CIRRENT_APP_ONBOARDING
+    if (settings->onboarding == CCM_ONBOARDING_CIRRENT_APP)
+    {
+        /* Onboarding is interactive, complete the queued commands first */
+        ccm_command_queue_flush();
 
-    /* AT command to enter Wi-Fi onboarding mode*/
-    at_command_send_receive("AT+CONFMODE\n", RESPONSE_DELAY, &result, NULL);
+        /* AT command to enter Wi-Fi onboarding mode*/
+        ccm_response_release(at_command_execute(CCM_CMD_CONFMODE, RESPONSE_DELAY, &result));
 
-    printf("\n\rOpen Cirrent APP on your mobile device and choose your Wi-Fi SSID. \n\rThe program continues after successfully connecting to Wi-Fi SSID.\n\r");
+        CCM_LOG(CCM_LOG_INFO, "\n\rOpen Cirrent APP on your mobile device and choose your Wi-Fi SSID. \n\rThe program continues after successfully connecting to Wi-Fi SSID.\n\r");
 
-    while (!is_wifi_connected())
+        while (!is_wifi_connected())
+        {
+            wait_for_event(POLLING_DELAY);
+        }
+    }
+    else
     {
-        delay_ms(POLLING_DELAY);
+        /* AT command for sending SSID */
+        submit_setting("SSID", settings->ssid);
+
+        /*AT command for sending Passphrase*/
+        submit_setting("Passphrase", settings->passphrase);
     }
+}
 
+static void gpio_interrupt_handler(void *handler_arg, cyhal_gpio_event_t event)
+{
+    ccm_soak_event_edge();
+
+#if CCM_RTOS
+    ccm_rtos_event_notify_from_isr();
 #else
+    gpio_intr_flag = true;
+#endif
+}
 
-    /* AT command for sending SSID */
-    at_command_send_receive(SET_SSID, RESPONSE_DELAY, &result, NULL);
+#if !CCM_RTOS
+/*******************************************************************************
+ * Function Name: event_pending
+ *******************************************************************************
+ * Summary: Wake-up condition of the main loop.
+ *
+ *******************************************************************************/
+static bool event_pending(void)
+{
+    return gpio_intr_flag;
+}
+#endif
+
+static void empty_event_queue()
+{
+    /* Discard the events queued before the application was ready*/
+    while (ccm_event_drain(RESPONSE_DELAY, false) >= CCM_EVENT_DRAIN_MAX)
+    {
+    }
+}
+
+/*******************************************************************************
+ * Function Name: ota_policy
+ *******************************************************************************
+ * Summary: OTA policy of the application: download right away, apply (which
+ *          restarts the CCM module and the host) once no message was received
+ *          for OTA_QUIET_TIME. Replace with the maintenance window or load
+ *          criteria of the application.
+ *
+ *******************************************************************************/
+static bool ota_policy(ccm_ota_action_t action, void *arg)
+{
+    if (action == CCM_OTA_ACTION_DOWNLOAD)
+    {
+        return true;
+    }
 
-    /*AT command for sending Passphrase*/
-    at_command_send_receive(SET_PASSPHRASE, RESPONSE_DELAY, &result, NULL);
+    return (ccm_get_time_ms() - last_message_time) >= OTA_QUIET_TIME;
+}
+
+/*******************************************************************************
+ * Function Name: startup_event_handler
+ *******************************************************************************
+ * Summary: Boot up event of the CCM module.
+ *
+ *******************************************************************************/
+static void startup_event_handler(ccm_response_t *event)
+{
+    CCM_LOG(CCM_LOG_INFO, (ccm_ota_get_state() == CCM_OTA_APPLYING) ? "\nStart up event notification, new firmware applied\n\n\r"
+                                                                    : "\nStart up event notification\n\n\r");
+    ccm_log_flush();
 
+#if CCM_SPOOL
+    /* Keep the consumer position, the messages processed are not repeated*/
+    ccm_spool_sync();
 #endif
+
+    /*Host software reset*/
+    NVIC_SystemReset();
 }
 
-static void gpio_interrupt_handler(void *handler_arg, cyhal_gpio_event_t event)
+/*******************************************************************************
+ * Function Name: unknown_event_handler
+ *******************************************************************************
+ * Summary: Events without a registered handler are reported instead of being
+ *          silently dropped.
+ *
+ *******************************************************************************/
+static void unknown_event_handler(ccm_response_t *event)
 {
-    gpio_intr_flag = true;
+    CCM_LOG(CCM_LOG_WARN, "\nUnhandled event %u %u\n\r", event->event_type, event->event_id);
 }
 
-static void empty_event_queue()
+/* Time of the last message for the OTA policy, and of the first in the boot timeline*/
+static void message_received(void)
+{
+    static bool first_message = true;
+
+    last_message_time = ccm_get_time_ms();
+
+    if (first_message)
+    {
+        first_message = false;
+        ccm_boot_mark("first message");
+        CCM_LOG(CCM_LOG_INFO, "\nFirst message %lu ms after boot\n\r", (unsigned long)last_message_time);
+    }
+}
+
+/* Acknowledgement record of a processed message, sent with the next telemetry
+ * batch, and accounting by the soak test*/
+static void acknowledge_message(uint8_t index)
+{
+    char record[48];
+    int length = snprintf(record, sizeof(record), "{\"ack\":%lu,\"topic\":%u}",
+                          (unsigned long)++messages_processed, index);
+
+    ccm_publish(TELEMETRY_TOPIC_INDEX, record, (uint16_t)length);
+
+    ccm_soak_message();
+}
+
+/*******************************************************************************
+ * Function Name: message_chunk_handler
+ *******************************************************************************
+ * Summary: Receives the message of the subscribed topic in chunks and prints it.
+ *          Replace with the application specific message processing.
+ *
+ *******************************************************************************/
+static void message_chunk_handler(uint8_t index, const uint8_t *chunk, uint16_t length, bool last, bool ok,
+                                  void *arg)
+{
+    message_received();
+
+#if CCM_RTOS
+
+    /* Collect the message for the application task, the AT link task goes on
+     * with the next command meanwhile. Without a free buffer the message is lost*/
+    if ((app_message_filling == NULL) && (pdPASS == xQueueReceive(app_message_free, &app_message_filling, 0)))
+    {
+        app_message_filling->length = 0;
+        app_message_filling->index = index;
+        app_message_filling->truncated = false;
+    }
+
+    if (app_message_filling == NULL)
+    {
+        return;
+    }
+
+    uint16_t room = APP_MESSAGE_SIZE - app_message_filling->length;
+    if (length > room)
+    {
+        length = room;
+        app_message_filling->truncated = true;
+    }
+    if (length)
+    {
+        memcpy(&app_message_filling->data[app_message_filling->length], chunk, length);
+        app_message_filling->length += length;
+    }
+
+    if (last && !ok)
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nMessage of topic %u incomplete, discarded\n\r", index);
+        xQueueSend(app_message_free, &app_message_filling, portMAX_DELAY);
+        app_message_filling = NULL;
+    }
+    else if (last)
+    {
+        xQueueSend(app_message_ready, &app_message_filling, portMAX_DELAY);
+        app_message_filling = NULL;
+    }
+
+#else
+
+    if (length)
+    {
+        ccm_log_data(CCM_LOG_INFO, chunk, length);
+    }
+
+    if (last && !ok)
+    {
+        CCM_LOG(CCM_LOG_WARN, " (incomplete, not acknowledged)\n\r");
+    }
+    else if (last)
+    {
+        CCM_LOG(CCM_LOG_INFO, "\n\r");
+        acknowledge_message(index);
+    }
+
+#endif
+}
+
+#if CCM_SPOOL
+/*******************************************************************************
+ * Function Name: spool_message_handler
+ *******************************************************************************
+ * Summary: Receives a complete message of the subscribed topic and appends it
+ *          to the flash spool.
+ *
+ *******************************************************************************/
+static void spool_message_handler(uint8_t index, const uint8_t *data, uint16_t length, bool last, bool ok,
+                                  void *arg)
 {
-    int result = 0;
-    /* AT command for checking the events queued in CCM module*/
-    while (!result)
+    message_received();
+
+    if (!ok)
     {
-        at_command_send_receive("AT+EVENT?\n", RESPONSE_DELAY, &result, "OK\r\n");
+        CCM_LOG(CCM_LOG_WARN, "\nMessage of topic %u incomplete, not spooled\n\r", index);
+        return;
     }
+
+    if (!ccm_spool_append(index, data, length))
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nSpool full, message of topic %u dropped\n\r", index);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: process_spooled_message
+ *******************************************************************************
+ * Summary: Pass the oldest spooled message to message_chunk_handler(). The
+ *          consumer position reaches the flash from ccm_spool_process().
+ *
+ * Return:
+ *  bool - false if the spool is empty.
+ *
+ *******************************************************************************/
+static bool process_spooled_message(void)
+{
+    ccm_spool_record_t record;
+
+    if (!ccm_spool_peek(&record))
+    {
+        return false;
+    }
+
+    message_chunk_handler(record.index, record.data, record.length, true, !record.truncated, NULL);
+
+    ccm_spool_consume();
+
+    return true;
+}
+
+#else
+/*******************************************************************************
+ * Function Name: data_batch_handler
+ *******************************************************************************
+ * Summary: Receives the data messages of an event drain, passes each one to
+ *          message_chunk_handler().
+ *
+ *******************************************************************************/
+static void data_batch_handler(uint8_t index, const ccm_message_t *messages, uint8_t count, void *arg)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        message_chunk_handler(index, messages[i].data, messages[i].length, true, !messages[i].truncated, NULL);
+    }
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: settings_message_handler
+ *******************************************************************************
+ * Summary: Receives a settings message in chunks. Once received with OK and
+ *          without overrun, and a complete valid document, changed settings
+ *          are saved and the host restarts to use them.
+ *
+ *******************************************************************************/
+static void settings_message_handler(uint8_t index, const uint8_t *chunk, uint16_t length, bool last, bool ok,
+                                     void *arg)
+{
+    bool valid = true;
+
+    if (length)
+    {
+        ccm_parser_feed(&settings_parser, chunk, length);
+    }
+
+    if (!last)
+    {
+        return;
+    }
+
+    valid = ccm_parser_finish(&settings_parser);
+
+    if (!ok)
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nSettings message incomplete, not saved\n\r");
+    }
+    else if (!valid)
+    {
+        CCM_LOG(CCM_LOG_WARN, "\nSettings message is not a valid document\n\r");
+    }
+    else if (ccm_settings_changed() && ccm_settings_save())
+    {
+        CCM_LOG(CCM_LOG_INFO, "\nSettings saved, restarting\n\r");
+        request_restart();
+    }
+
+    ccm_settings_discard();
+}
+
+/*******************************************************************************
+ * Function Name: request_restart
+ *******************************************************************************
+ * Summary: Restart the host from the task owning the publish path. In the RTOS
+ *          build the settings messages are received in the AT link task, the
+ *          restart is handed to the application task.
+ *
+ *******************************************************************************/
+static void request_restart(void)
+{
+#if CCM_RTOS
+    app_message_t *restart = NULL;
+
+    if (!restart_requested)
+    {
+        restart_requested = true;
+        xQueueSend(app_message_ready, &restart, 0);
+    }
+#else
+    restart_host();
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: restart_host
+ *******************************************************************************
+ * Summary: Send the waiting telemetry, write the log and reset the host.
+ *
+ *******************************************************************************/
+static void restart_host(void)
+{
+    ccm_publish_flush(RESPONSE_DELAY);
+    ccm_log_flush();
+
+#if CCM_SPOOL
+    ccm_spool_sync();
+#endif
+
+    /*Host software reset*/
+    NVIC_SystemReset();
+}
+
+/*******************************************************************************
+ * Function Name: health_handler
+ *******************************************************************************
+ * Summary: Change of the AWS IoT core connection state seen by the health
+ *          monitor. The CCM module reconnects by itself, the messages are
+ *          fetched again after its MSG events.
+ *
+ *******************************************************************************/
+static void health_handler(ccm_link_state_t state, void *arg)
+{
+    ccm_health_stats_t stats;
+
+    ccm_health_get_stats(&stats);
+
+    CCM_LOG((state == CCM_LINK_UP) ? CCM_LOG_INFO : CCM_LOG_WARN,
+            "\nAWS IoT core %s, probe latency %lu ms, %lu probes, %lu losses\n\r",
+            (state == CCM_LINK_UP) ? "connected" : ((state == CCM_LINK_DOWN) ? "not connected" : "not answering"),
+            (unsigned long)stats.probe_latency, (unsigned long)stats.probes, (unsigned long)stats.losses);
+
+    if (stats.rssi != CCM_HEALTH_RSSI_UNKNOWN)
+    {
+        CCM_LOG(CCM_LOG_INFO, "\nRSSI %d dBm\n\r", stats.rssi);
+    }
+
+    if (state == CCM_LINK_UP)
+    {
+        char record[64];
+        int length = snprintf(record, sizeof(record), "{\"status\":\"connected\",\"latency\":%lu,\"losses\":%lu}",
+                              (unsigned long)stats.probe_latency, (unsigned long)stats.losses);
+
+        ccm_publish(TELEMETRY_TOPIC_INDEX, record, (uint16_t)length);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: connect_result_handler
+ *******************************************************************************
+ * Summary: Completion of the queued AT+CONNECT, stores the class of its error
+ *          in the ccm_error_class_t pointed to by arg.
+ *
+ *******************************************************************************/
+static void connect_result_handler(ccm_response_t *response, int command_result, void *arg)
+{
+    *(ccm_error_class_t *)arg = command_result ? CCM_ERROR_NONE : ccm_error_classify(response);
 }
 
 /* [] END OF FILE */